@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Otter.hpp"
+#include "BenchWindow.hpp"
+#include <chrono>
+
+namespace Bench {
+	// All times in milliseconds.
+	struct BenchPercentiles
+	{
+		size_t samples = 0;
+		float mean = 0.0f;
+		float min = 0.0f;
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+	};
+
+	/*
+		Renders a named scene for a fixed number of warm-up and measured frames, then writes a JSON report and quits.
+		Simulation runs on a fixed time step and the frame rate is uncapped, so runs are repeatable and measure throughput.
+		Without --render-thread, frames the GPU isn't ready for are skipped rather than waited on; the report counts them.
+		With --max-frame-allocations the run fails (non-zero exit code) when any measured frame made more heap allocations than that,
+		which guards the allocation-free steady state in CI. Needs a build with OTTER_TRACK_ALLOCATIONS.
+		Usage: OtterBench [--scene Grid1000] [--warmup 120] [--frames 1000] [--width 1280] [--height 720] [--headless]
+		                  [--present-mode immediate|mailbox|fifo] [--render-thread] [--output otter_bench.json]
+		                  [--max-frame-allocations 0]
+	*/
+	class BenchApp : public Otter::Application
+	{
+	public:
+		BenchApp();
+
+		void OnStart() override;
+		void OnTick(float deltaTime) override;
+		void OnStop() override;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		std::shared_ptr<BenchWindow> window;
+		std::string scene;
+		std::string presentMode;
+		std::string outputPath;
+		int warmupFrames = 0;
+		int measuredFrames = 0;
+		Otter::Vec2D size = {0, 0};
+		bool headless = false;
+		bool renderThread = false;
+		int maxFrameAllocations = -1;	// -1 = not enforced.
+
+		int frameIndex = 0;
+		Clock::time_point lastTick;
+		std::vector<float> cpuFrameTimes;
+		std::vector<float> gpuFrameTimes;
+		uint64_t lastGpuFrame = 0;
+		Otter::Systems::RenderStats startStats;
+		uint64_t startUploadedBytes = 0;
+		uint64_t peakGpuMemory = 0;
+		uint64_t measuredAllocations = 0;
+		uint64_t peakFrameAllocations = 0;
+
+		void BeginMeasuring();
+		void SampleFrame(float cpuFrameTime);
+		void WriteReport();
+	};
+}
+
+Otter::Application* Otter::CreateApplication()
+{
+	return new Bench::BenchApp();
+}
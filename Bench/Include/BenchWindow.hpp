@@ -0,0 +1,17 @@
+#pragma once
+#include "Otter/Core/Window.hpp"
+
+namespace Bench {
+	/*
+		Fills itself with one of the named benchmark scenes. Scenes are built the same way every run (no randomness),
+		so two reports of the same scene are comparable.
+	*/
+	class BenchWindow : public Otter::Window
+	{
+	public:
+		BenchWindow(glm::vec2 size, std::string title, bool imGuiAllowed, bool headless = false) : Otter::Window(size, title, imGuiAllowed, headless) {}
+
+		bool LoadScene(const std::string& name);	// False if there's no scene with this name.
+		static std::string GetSceneNames();			// Comma separated, for usage messages.
+	};
+}
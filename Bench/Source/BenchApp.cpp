@@ -0,0 +1,298 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#undef CreateWindow	// Clashes with Application::CreateWindow.
+#else
+#include <sys/resource.h>
+#endif
+
+#include "BenchApp.hpp"
+#include "Otter/Core/AllocationTracker.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+namespace Bench {
+
+	static const float FIXED_DELTA_TIME = 1.0f / 60.0f;
+
+	static BenchPercentiles ComputePercentiles(std::vector<float> samples)
+	{
+		BenchPercentiles result;
+		result.samples = samples.size();
+		if (samples.empty())
+			return result;
+
+		// Nearest rank, so every reported value is a frame that actually happened.
+		std::sort(samples.begin(), samples.end());
+		auto rank = [&](float percentile) { return samples[std::max<size_t>(static_cast<size_t>(std::ceil(percentile * samples.size())), 1) - 1]; };
+
+		result.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+		result.min = samples.front();
+		result.p50 = rank(0.50f);
+		result.p95 = rank(0.95f);
+		result.p99 = rank(0.99f);
+		result.max = samples.back();
+		return result;
+	}
+
+	static uint64_t GetPeakProcessMemory()
+	{
+	#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+		return counters.PeakWorkingSetSize;
+	#else
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+	#ifdef __APPLE__
+		return usage.ru_maxrss;					// Bytes on macOS...
+	#else
+		return usage.ru_maxrss * 1024ull;		// ...kilobytes everywhere else.
+	#endif
+	#endif
+	}
+
+	static bool ParsePresentMode(const std::string& name, VkPresentModeKHR& mode)
+	{
+		if (name == "immediate")
+			mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+		else if (name == "mailbox")
+			mode = VK_PRESENT_MODE_MAILBOX_KHR;
+		else if (name == "fifo")
+			mode = VK_PRESENT_MODE_FIFO_KHR;
+		else
+			return false;
+		return true;
+	}
+
+	// Scene names come from the command line and device names from the driver, either may hold quotes or backslashes.
+	static std::string EscapeJson(const std::string& value)
+	{
+		std::string result;
+		result.reserve(value.size());
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\')
+			{
+				result += '\\';
+				result += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+				result += escaped;
+			}
+			else
+				result += c;
+		}
+		return result;
+	}
+
+	static void WritePercentiles(std::ofstream& file, const char* name, const BenchPercentiles& percentiles)
+	{
+		file << "\t\t\"" << name << "\": {\"samples\": " << percentiles.samples
+			<< ", \"mean\": " << percentiles.mean
+			<< ", \"min\": " << percentiles.min
+			<< ", \"p50\": " << percentiles.p50
+			<< ", \"p95\": " << percentiles.p95
+			<< ", \"p99\": " << percentiles.p99
+			<< ", \"max\": " << percentiles.max << "}";
+	}
+
+	BenchApp::BenchApp() : Application()
+	{
+		appName = "OtterBench";
+		SetTargetFrameRate(0.0f);
+		SetFixedDeltaTime(FIXED_DELTA_TIME);
+	}
+
+	void BenchApp::OnStart()
+	{
+		const Otter::CommandLine& commandLine = GetCommandLine();
+		scene = commandLine.GetString("scene", "Grid1000");
+		warmupFrames = std::max(commandLine.GetInt("warmup", 120), 0);
+		measuredFrames = std::max(commandLine.GetInt("frames", 1000), 1);
+		size = { commandLine.GetInt("width", 1280), commandLine.GetInt("height", 720) };
+		headless = commandLine.Has("headless");
+		renderThread = commandLine.Has("render-thread");
+		presentMode = commandLine.GetString("present-mode", "immediate");
+		outputPath = commandLine.GetString("output", "otter_bench.json");
+		maxFrameAllocations = commandLine.GetInt("max-frame-allocations", -1);
+
+		if (maxFrameAllocations >= 0 && !Otter::AllocationTracker::IsEnabled())
+			LOG_F(WARNING, "--max-frame-allocations has no effect, allocation tracking is compiled out (OTTER_TRACK_ALLOCATIONS)");
+
+		VkPresentModeKHR mode;
+		if (!ParsePresentMode(presentMode, mode))
+		{
+			LOG_F(ERROR, "Unknown present mode '%s', expected immediate, mailbox or fifo", presentMode.c_str());
+			Quit();
+			return;
+		}
+
+		SetRenderThreadEnabled(renderThread);
+		window = CreateWindow<BenchWindow>(glm::vec2(size), "OtterBench - " + scene, headless);
+		if (!window)
+		{
+			LOG_F(ERROR, "Could not create the bench window");
+			Quit();
+			return;
+		}
+
+		if (!window->LoadScene(scene))
+		{
+			LOG_F(ERROR, "Unknown scene '%s', available scenes: %s", scene.c_str(), BenchWindow::GetSceneNames().c_str());
+			Quit();
+			return;
+		}
+
+		window->SetPresentMode(mode);
+		cpuFrameTimes.reserve(measuredFrames);
+		gpuFrameTimes.reserve(measuredFrames);
+		LOG_F(INFO, "Benchmarking %s: %d warm-up and %d measured frames", scene.c_str(), warmupFrames, measuredFrames);
+	}
+
+	void BenchApp::OnTick(float deltaTime)
+	{
+		if (!window)
+			return;
+
+		// Each tick closes the previous frame, so the time between two ticks covers a whole frame: simulation, recording and presenting.
+		Clock::time_point now = Clock::now();
+		float cpuFrameTime = std::chrono::duration<float, std::milli>(now - lastTick).count();
+		lastTick = now;
+
+		if (frameIndex == warmupFrames)
+			BeginMeasuring();
+		else if (frameIndex > warmupFrames)
+			SampleFrame(cpuFrameTime);
+
+		if (frameIndex == warmupFrames + measuredFrames)
+		{
+			WriteReport();
+			window.reset();
+
+			if (Otter::AllocationTracker::IsEnabled() && maxFrameAllocations >= 0 && peakFrameAllocations > static_cast<uint64_t>(maxFrameAllocations))
+			{
+				LOG_F(ERROR, "A measured frame made %llu heap allocations, more than the allowed %d", (unsigned long long)peakFrameAllocations, maxFrameAllocations);
+				Quit(1);
+				return;
+			}
+
+			Quit();
+			return;
+		}
+
+		frameIndex++;
+	}
+
+	void BenchApp::OnStop()
+	{
+	}
+
+	void BenchApp::BeginMeasuring()
+	{
+		startStats = window->GetRenderStats();
+		startUploadedBytes = GetRenderDevice()->GetUploadedBytes();
+		window->GetGpuProfiler().GetFrameMilliseconds(&lastGpuFrame);
+	}
+
+	void BenchApp::SampleFrame(float cpuFrameTime)
+	{
+		cpuFrameTimes.push_back(cpuFrameTime);
+
+		// GPU results lag a few frames behind and only change when a frame was resolved since the last tick.
+		uint64_t gpuFrame = 0;
+		float gpuFrameTime = window->GetGpuProfiler().GetFrameMilliseconds(&gpuFrame);
+		if (gpuFrame != lastGpuFrame)
+		{
+			gpuFrameTimes.push_back(gpuFrameTime);
+			lastGpuFrame = gpuFrame;
+		}
+
+		peakGpuMemory = std::max<uint64_t>(peakGpuMemory, GetRenderDevice()->GetAllocatedBytes());
+
+		// The tracker closes a frame at the top of the main loop, so these are of the frame that ended right before this tick.
+		uint64_t allocations = Otter::AllocationTracker::Get().GetLastFrameCounts().allocations;
+		measuredAllocations += allocations;
+		peakFrameAllocations = std::max(peakFrameAllocations, allocations);
+	}
+
+	void BenchApp::WriteReport()
+	{
+		Otter::Systems::RenderStats stats = window->GetRenderStats();
+		uint64_t renderedFrames = stats.renderedFrames - startStats.renderedFrames;
+		uint64_t skippedFrames = stats.skippedFrames - startStats.skippedFrames;
+		uint64_t drawCalls = stats.drawCalls - startStats.drawCalls;
+		uint64_t triangles = stats.triangles - startStats.triangles;
+		uint64_t uploadedBytes = GetRenderDevice()->GetUploadedBytes();
+		const VkPhysicalDeviceProperties& properties = GetRenderDevice()->GetProperties();
+
+		BenchPercentiles cpu = ComputePercentiles(cpuFrameTimes);
+		BenchPercentiles gpu = ComputePercentiles(gpuFrameTimes);
+
+		std::ofstream file(outputPath, std::ios::out | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_F(ERROR, "Could not write the bench report to %s", outputPath.c_str());
+			return;
+		}
+
+		file << "{\n";
+		file << "\t\"revision\": \"" << OTTER_BENCH_REVISION << "\",\n";
+	#ifdef NDEBUG
+		file << "\t\"build\": \"release\",\n";
+	#else
+		file << "\t\"build\": \"debug\",\n";
+	#endif
+		file << "\t\"scene\": \"" << EscapeJson(scene) << "\",\n";
+		file << "\t\"config\": {\n";
+		file << "\t\t\"warmupFrames\": " << warmupFrames << ",\n";
+		file << "\t\t\"measuredFrames\": " << measuredFrames << ",\n";
+		file << "\t\t\"width\": " << size.x << ",\n";
+		file << "\t\t\"height\": " << size.y << ",\n";
+		file << "\t\t\"headless\": " << (headless ? "true" : "false") << ",\n";
+		file << "\t\t\"presentMode\": \"" << (headless ? "none" : presentMode) << "\",\n";
+		file << "\t\t\"renderThread\": " << (renderThread ? "true" : "false") << ",\n";
+		file << "\t\t\"maxFramesInFlight\": " << Otter::Rendering::MAX_FRAMES_IN_FLIGHT << ",\n";
+		file << "\t\t\"fixedDeltaTime\": " << FIXED_DELTA_TIME << "\n";
+		file << "\t},\n";
+		file << "\t\"device\": {\n";
+		file << "\t\t\"name\": \"" << EscapeJson(properties.deviceName) << "\",\n";
+		file << "\t\t\"vendorId\": " << properties.vendorID << ",\n";
+		file << "\t\t\"driverVersion\": " << properties.driverVersion << ",\n";
+		file << "\t\t\"apiVersion\": \"" << VK_VERSION_MAJOR(properties.apiVersion) << "." << VK_VERSION_MINOR(properties.apiVersion) << "." << VK_VERSION_PATCH(properties.apiVersion) << "\"\n";
+		file << "\t},\n";
+		file << "\t\"results\": {\n";
+		WritePercentiles(file, "cpuFrameMs", cpu);
+		file << ",\n";
+		WritePercentiles(file, "gpuFrameMs", gpu);
+		file << ",\n";
+		file << "\t\t\"renderedFrames\": " << renderedFrames << ",\n";
+		file << "\t\t\"skippedFrames\": " << skippedFrames << ",\n";
+		file << "\t\t\"drawCallsPerFrame\": " << (renderedFrames > 0 ? drawCalls / renderedFrames : 0) << ",\n";
+		file << "\t\t\"trianglesPerFrame\": " << (renderedFrames > 0 ? triangles / renderedFrames : 0) << ",\n";
+		file << "\t\t\"uploadBytes\": " << uploadedBytes << ",\n";
+		file << "\t\t\"measuredUploadBytes\": " << uploadedBytes - startUploadedBytes << ",\n";
+		file << "\t\t\"uploadBatches\": " << GetRenderDevice()->GetUploadBatcher().GetBatchCount() << ",\n";
+		file << "\t\t\"uploadStalls\": " << GetRenderDevice()->GetUploadBatcher().GetStallCount() << ",\n";
+		file << "\t\t\"peakGpuMemoryBytes\": " << peakGpuMemory << ",\n";
+		file << "\t\t\"peakProcessMemoryBytes\": " << GetPeakProcessMemory() << ",\n";
+		file << "\t\t\"allocationTracking\": " << (Otter::AllocationTracker::IsEnabled() ? "true" : "false") << ",\n";
+		file << "\t\t\"allocationsPerFrame\": " << (cpuFrameTimes.empty() ? 0.0 : static_cast<double>(measuredAllocations) / cpuFrameTimes.size()) << ",\n";
+		file << "\t\t\"peakFrameAllocations\": " << peakFrameAllocations << "\n";
+		file << "\t}\n";
+		file << "}\n";
+
+		LOG_F(INFO, "Bench %s: CPU p50 %.3f / p95 %.3f / p99 %.3f ms, GPU p50 %.3f / p95 %.3f / p99 %.3f ms. Report written to %s",
+			scene.c_str(), cpu.p50, cpu.p95, cpu.p99, gpu.p50, gpu.p95, gpu.p99, outputPath.c_str());
+	}
+}
@@ -0,0 +1,52 @@
+#include "BenchWindow.hpp"
+#include "Otter/Components/MeshRenderer.hpp"
+#include "loguru.hpp"
+
+namespace Bench
+{
+	struct BenchScene
+	{
+		const char* name;
+		int entityCount;
+		const char* meshPath;
+		const char* texturePath;
+	};
+
+	static const BenchScene SCENES[] =
+	{
+		{ "Empty", 0, "", "" },
+		{ "Single", 1, "Assets/Meshes/viking_room.obj", "Assets/Textures/viking_room.png" },
+		{ "Grid100", 100, "Assets/Meshes/viking_room.obj", "Assets/Textures/viking_room.png" },
+		{ "Grid1000", 1000, "Assets/Meshes/viking_room.obj", "Assets/Textures/viking_room.png" },
+		{ "Grid4000", 4000, "Assets/Meshes/viking_room.obj", "Assets/Textures/viking_room.png" },	// Close to MAX_ENTITIES.
+	};
+
+	bool BenchWindow::LoadScene(const std::string& name)
+	{
+		for (const auto& scene : SCENES)
+		{
+			if (name != scene.name)
+				continue;
+
+			// Every entity holds the same handles, the assets are imported and uploaded once.
+			for (int i = 0; i < scene.entityCount; i++)
+			{
+				Otter::Entity entity = coordinator.CreateEntity();
+				coordinator.AddComponent(entity, Otter::Components::MeshRenderer(scene.meshPath, scene.texturePath));
+			}
+
+			LOG_F(INFO, "Loaded bench scene %s with %d entities", scene.name, scene.entityCount);
+			return true;
+		}
+
+		return false;
+	}
+
+	std::string BenchWindow::GetSceneNames()
+	{
+		std::string names;
+		for (const auto& scene : SCENES)
+			names += (names.empty() ? "" : ", ") + std::string(scene.name);
+		return names;
+	}
+}
@@ -1,6 +1,13 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D texSampler;
+// The device's texture table, indexed per draw.
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform ObjectPushConstants {
+    mat4 model;
+    uint textureIndex;
+} object;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
@@ -9,5 +16,5 @@ layout(location = 0) out vec4 outColor;
 
 void main() {
     //outColor = vec4(fragTexCoord, 0.0, 1.0);
-    outColor = texture(texSampler, fragTexCoord);
+    outColor = texture(textures[object.textureIndex], fragTexCoord);
 }
\ No newline at end of file
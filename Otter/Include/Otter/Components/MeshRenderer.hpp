@@ -1,24 +1,86 @@
 #pragma once
+#include "Otter/Rendering/AssetManager.hpp"
 #include <string>
+#include <utility>
 
-#include <loguru.hpp>
-#include <memory>
+namespace Otter::Rendering
+{
+	struct Mesh;
+}
 
 namespace Otter::Components
 {
+	/*
+		Handles rather than paths, see Rendering::AssetManager. Owns a reference to each of its assets: constructing from paths
+		acquires them, they're released when the component is destroyed or assigned over, as DestroyEntity and RemoveComponent do.
+		Move-only, so every entity gets a MeshRenderer of its own; constructing one for a path that's already known is cheap.
+	*/
 	class MeshRenderer
 	{
 	public:
-		std::string meshPath;
-		std::string texturePath;
-		std::string shader = "Simple";
+		Rendering::MeshHandle mesh;
+		Rendering::TextureHandle texture;
+		Rendering::ShaderHandle shader;
+		const Rendering::Mesh* resolvedMesh = nullptr;	// Looked up from mesh by the renderer, owned by the render device.
 
 		MeshRenderer() {}
 
-	 	MeshRenderer(std::string meshPath, std::string texturePath)
+		MeshRenderer(const std::string& meshPath, const std::string& texturePath, const std::string& shaderName = "Simple")
+		{
+			Rendering::AssetManager& assets = Rendering::AssetManager::Get();
+			if (!meshPath.empty())
+				mesh = assets.AcquireMesh(meshPath);
+			if (!texturePath.empty())
+				texture = assets.AcquireTexture(texturePath);
+			if (!shaderName.empty())
+				shader = assets.AcquireShader(shaderName);
+		}
+
+		MeshRenderer(const MeshRenderer&) = delete;
+		MeshRenderer& operator=(const MeshRenderer&) = delete;
+
+		MeshRenderer(MeshRenderer&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		MeshRenderer& operator=(MeshRenderer&& other) noexcept
 		{
-			this->meshPath = meshPath;
-			this->texturePath = texturePath;
+			if (this != &other)
+			{
+				Release();
+				mesh = other.mesh;
+				texture = other.texture;
+				shader = other.shader;
+				resolvedMesh = other.resolvedMesh;
+				other.mesh = {};
+				other.texture = {};
+				other.shader = {};
+				other.resolvedMesh = nullptr;
+			}
+			return *this;
+		}
+
+		~MeshRenderer()
+		{
+			Release();
+		}
+
+	private:
+		void Release()
+		{
+			// Most are the empty slots of a component array, those never touch the asset manager.
+			if (!mesh.IsValid() && !texture.IsValid() && !shader.IsValid())
+				return;
+
+			Rendering::AssetManager& assets = Rendering::AssetManager::Get();
+			assets.Release(mesh);
+			assets.Release(texture);
+			assets.Release(shader);
+			mesh = {};
+			texture = {};
+			shader = {};
+			resolvedMesh = nullptr;
 		}
 	};
-}
\ No newline at end of file
+}
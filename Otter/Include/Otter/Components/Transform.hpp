@@ -1,12 +1,34 @@
 #pragma once
+#include "Otter/Core/Types.hpp"
 #include "glm/mat4x4.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 namespace Otter::Components
 {
+	/*
+		Position, rotation and scale relative to the parent, or to the world without one.
+		The world matrix is derived from these by Systems::TransformSystem every tick, parents before children.
+	*/
 	struct Transform
 	{
-		glm::mat4x4 data;
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+		Entity parent = INVALID_ENTITY;		// Must have a Transform too, otherwise this is treated as a root.
 
-		glm::vec3 GetPosition() { return glm::vec3(); }
+		glm::mat4x4 world = glm::mat4x4(1.0f);
+
+		glm::vec3 GetPosition() const { return glm::vec3(world[3]); }	// In world space, as of the last TransformSystem tick.
+		glm::mat4x4 GetLocalMatrix() const;
 	};
-}
\ No newline at end of file
+
+	inline glm::mat4x4 Transform::GetLocalMatrix() const
+	{
+		glm::mat4x4 local = glm::mat4_cast(rotation);
+		local[0] *= scale.x;
+		local[1] *= scale.y;
+		local[2] *= scale.z;
+		local[3] = glm::vec4(position, 1.0f);
+		return local;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+/*
+	Counts heap allocations made through the global operator new/delete, compiled out unless the OTTER_TRACK_ALLOCATIONS CMake option is on.
+	Allocations are counted per frame (all threads) and per scope (the thread the scope is on), so a system allocating in its tick stands out.
+	ImGui is counted too, once InstallImGuiAllocator routed its allocator through here. VMA and the Vulkan driver are not.
+
+		OTTER_ALLOCATION_FRAME();					// Once at the start of every main loop iteration.
+		OTTER_ALLOCATION_SCOPE(system->GetName());	// Name must outlive the tracker, use string literals.
+*/
+#ifdef OTTER_TRACK_ALLOCATIONS
+	#define OTTER_ALLOCATION_CONCAT_INNER(a, b) a##b
+	#define OTTER_ALLOCATION_CONCAT(a, b) OTTER_ALLOCATION_CONCAT_INNER(a, b)
+	#define OTTER_ALLOCATION_SCOPE(name) ::Otter::AllocationScope OTTER_ALLOCATION_CONCAT(allocationScope, __LINE__)(name)
+	#define OTTER_ALLOCATION_FRAME() ::Otter::AllocationTracker::Get().BeginFrame()
+#else
+	#define OTTER_ALLOCATION_SCOPE(name)
+	#define OTTER_ALLOCATION_FRAME()
+#endif
+
+namespace Otter
+{
+	struct AllocationCounts
+	{
+		uint64_t allocations = 0;
+		uint64_t frees = 0;
+		uint64_t bytes = 0;		// Allocated, frees don't subtract.
+
+		AllocationCounts operator-(const AllocationCounts& other) const { return { allocations - other.allocations, frees - other.frees, bytes - other.bytes }; }
+		AllocationCounts& operator+=(const AllocationCounts& other) { allocations += other.allocations; frees += other.frees; bytes += other.bytes; return *this; }
+	};
+
+	/*
+		The tracker itself never allocates: scopes are kept in a fixed table, and the counters are plain atomics and thread locals.
+	*/
+	class AllocationTracker
+	{
+	public:
+		static const size_t MAX_SCOPES = 64;
+
+		struct ScopeCounts
+		{
+			const char* name = nullptr;
+			AllocationCounts current;	// Of the frame in progress.
+			AllocationCounts last;		// Of the last complete frame.
+		};
+
+		static AllocationTracker& Get();
+		static constexpr bool IsEnabled()
+		{
+		#ifdef OTTER_TRACK_ALLOCATIONS
+			return true;
+		#else
+			return false;
+		#endif
+		}
+
+		static AllocationCounts GetTotalCounts();	// Since startup, all threads.
+		static AllocationCounts GetThreadCounts();	// Since startup, calling thread only.
+		static void InstallImGuiAllocator();	// Before the first ImGui::CreateContext. No-op unless tracking is compiled in.
+
+		void BeginFrame();	// Closes the previous frame. Main thread only.
+		inline const AllocationCounts& GetLastFrameCounts() const { return lastFrame; }
+		inline uint64_t GetFrameCount() const { return frameCount; }
+		void RecordScope(const char* name, const AllocationCounts& counts);
+		size_t GetScopes(std::array<ScopeCounts, MAX_SCOPES>& scopes) const;	// Returns how many were copied.
+
+		void DrawImGui() const;
+
+	private:
+		AllocationCounts frameStart;
+		AllocationCounts lastFrame;
+		uint64_t frameCount = 0;
+
+		mutable std::mutex scopesMutex;
+		std::array<ScopeCounts, MAX_SCOPES> scopes;
+		size_t scopeCount = 0;
+	};
+
+	class AllocationScope
+	{
+	public:
+		AllocationScope(const char* name) : name(name), start(AllocationTracker::GetThreadCounts()) {}
+		~AllocationScope() { AllocationTracker::Get().RecordScope(name, AllocationTracker::GetThreadCounts() - start); }
+
+	private:
+		const char* name;
+		AllocationCounts start;
+	};
+}
@@ -3,6 +3,9 @@
 #include <vector>
 #include <string>
 #include "Otter/Core/Window.hpp"
+#include "Otter/Core/FrameLimiter.hpp"
+#include "Otter/Rendering/RenderDevice.hpp"
+#include "Otter/Utilities/CommandLine.hpp"
 #include "glm/vec2.hpp"
 
 namespace Otter 
@@ -15,34 +18,51 @@ namespace Otter
 		Application();
 		virtual ~Application();
 
-		void Run(int argc, char* argv[], char* envp[]);
+		int Run(int argc, char* argv[], char* envp[]);	// Returns the exit code.
 
 		virtual void OnStart() = 0;
 		virtual void OnTick(float deltaTime) = 0;
 		virtual void OnStop() = 0;
 
 		template<typename T>
-		bool CreateWindow(glm::vec2 size, std::string title);
+		std::shared_ptr<T> CreateWindow(glm::vec2 size, std::string title, bool headless = false);	// T is constructed with (size, title, imGuiAllowed, headless). All windows share one device, so don't mix headless and regular ones. Null on failure.
 		bool DestroyWindow(std::shared_ptr<Otter::Window> window);
+		inline void Quit(int exitCode = 0) { shouldTick = false; this->exitCode = exitCode; }	// Finishes the current frame, then shuts down.
+
+		inline const CommandLine& GetCommandLine() const { return commandLine; }	// Valid from OnStart on.
+		inline std::shared_ptr<Rendering::RenderDevice> GetRenderDevice() const { return renderDevice; }
+
+		inline void SetTargetFrameRate(float framesPerSecond) { frameLimiter.SetTargetFrameRate(framesPerSecond); }	// 0 = uncapped.
+		inline const FrameTimingStats& GetFrameTimingStats() const { return frameLimiter.GetStats(); }
+		inline void SetRenderThreadEnabled(bool enabled) { renderThreadEnabled = enabled; }	// Applies to windows created afterwards.
+		inline void SetFixedDeltaTime(float seconds) { fixedDeltaTime = seconds; }	// Ticks advance by this instead of the measured frame time, 0 = measured. For reproducible runs.
 
 	private:
 		std::vector<std::shared_ptr<Otter::Window>> windows;
+		std::shared_ptr<Rendering::RenderDevice> renderDevice;	// Shared by all windows, initialized by the first one.
+		FrameLimiter frameLimiter;
+		CommandLine commandLine;
+		bool renderThreadEnabled = false;
+		float fixedDeltaTime = 0.0f;
 		bool windowWasDestroyed = true;
 		bool shouldTick = true;
+		int exitCode = 0;
 	};
 
 	// To be defined in CLIENT
 	Application* CreateApplication();
 
 	template<typename T>
-	bool Application::CreateWindow(glm::vec2 size, std::string title)
+	std::shared_ptr<T> Application::CreateWindow(glm::vec2 size, std::string title, bool headless)
 	{
-		std::shared_ptr<T> window = std::make_shared<T>(size, title, windows.size() == 0);
+		std::shared_ptr<T> window = std::make_shared<T>(size, title, windows.size() == 0 && !headless, headless);
 		if (!window->IsValid())
-			return false;
+			return nullptr;
 
+		window->SetRenderDevice(renderDevice);
+		window->SetRenderThreadEnabled(renderThreadEnabled);
 		window->OnStart();
 		windows.push_back(window);
-		return true;
+		return window;
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <array>
 #include <cassert>
 #include <unordered_map>
+#include <utility>
 
 namespace Otter
 {
@@ -27,7 +28,7 @@ namespace Otter
 			size_t newIndex = mSize;
 			mEntityToIndexMap[entity] = newIndex;
 			mIndexToEntityMap[newIndex] = entity;
-			mComponentArray[newIndex] = component;
+			mComponentArray[newIndex] = std::move(component);
 			++mSize;
 		}
 
@@ -35,10 +36,11 @@ namespace Otter
 		{
 			assert(mEntityToIndexMap.find(entity) != mEntityToIndexMap.end() && "Removing non-existent component.");
 
-			// Copy element at end into deleted element's place to maintain density
+			// Move element at end into deleted element's place to maintain density, then reset the end so it holds on to nothing
 			size_t indexOfRemovedEntity = mEntityToIndexMap[entity];
 			size_t indexOfLastElement = mSize - 1;
-			mComponentArray[indexOfRemovedEntity] = mComponentArray[indexOfLastElement];
+			mComponentArray[indexOfRemovedEntity] = std::move(mComponentArray[indexOfLastElement]);
+			mComponentArray[indexOfLastElement] = T{};
 
 			// Update map to point to moved spot
 			Entity entityOfLastElement = mIndexToEntityMap[indexOfLastElement];
@@ -5,6 +5,7 @@
 #include <any>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 
 namespace Otter
 {
@@ -37,7 +38,7 @@ namespace Otter
 		template<typename T>
 		void AddComponent(Entity entity, T component)
 		{
-			GetComponentArray<T>()->InsertData(entity, component);
+			GetComponentArray<T>()->InsertData(entity, std::move(component));
 		}
 
 		template<typename T>
@@ -6,6 +6,7 @@
 #include "SystemManager.hpp"
 #include "Types.hpp"
 #include <memory>
+#include <utility>
 
 namespace Otter
 {
@@ -46,7 +47,7 @@ namespace Otter
 		template<typename T>
 		void AddComponent(Entity entity, T component)
 		{
-			mComponentManager->AddComponent<T>(entity, component);
+			mComponentManager->AddComponent<T>(entity, std::move(component));
 
 			auto signature = mEntityManager->GetSignature(entity);
 			signature.set(mComponentManager->GetComponentType<T>(), true);
@@ -73,6 +74,12 @@ namespace Otter
 			return mComponentManager->GetComponent<T>(entity);
 		}
 
+		template<typename T>
+		bool HasComponent(Entity entity)
+		{
+			return mEntityManager->GetSignature(entity).test(mComponentManager->GetComponentType<T>());
+		}
+
 		template<typename T>
 		ComponentType GetComponentType()
 		{
@@ -1,30 +1,63 @@
 #pragma once
 
 #include "Types.hpp"
+#include "FrameArena.hpp"
 #include <any>
-#include <unordered_map>
+#include <cassert>
+#include <memory_resource>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace Otter
 {
+	/*
+		Params live in the constructing thread's frame arena by default, as events carry a handful and are handled within the frame.
+		Such an event belongs to that thread and must not be used once frame N + MAX_FRAMES_IN_FLIGHT starts, N being the frame it
+		was made in; debug builds assert both. Pass std::pmr::get_default_resource() for an event that is kept longer or handed to
+		another thread. The params are std::any: small, nothrow movable values are stored inline, bigger ones (a std::string) still
+		go to the heap.
+	*/
 	class Event
 	{
 	public:
 		Event() = delete;
 
-		explicit Event(EventId type)
-			: mType(type)
-		{}
+		explicit Event(EventId type, std::pmr::memory_resource* resource = FrameArenas::GetResource())
+			: mType(type), mData(resource)
+		{
+		#ifndef NDEBUG
+			if (resource == FrameArenas::GetResource())
+			{
+				mArenaThread = std::this_thread::get_id();
+				mArenaFrame = FrameArenas::Get().GetFrame();
+			}
+		#endif
+		}
 
 		template<typename T>
 		void SetParam(EventId id, T value)
 		{
-			mData[id] = value;
+			AssertUsable();
+			for (auto& param : mData)
+				if (param.first == id)
+				{
+					param.second = value;
+					return;
+				}
+
+			mData.emplace_back(id, value);
 		}
 
 		template<typename T>
 		T GetParam(EventId id)
 		{
-			return std::any_cast<T>(mData[id]);
+			AssertUsable();
+			for (auto& param : mData)
+				if (param.first == id)
+					return std::any_cast<T>(param.second);
+
+			return std::any_cast<T>(std::any());	// Throws std::bad_any_cast, like a missing param always did.
 		}
 
 		EventId GetType() const
@@ -34,6 +67,18 @@ namespace Otter
 
 	private:
 		EventId mType{};
-		std::unordered_map<EventId, std::any> mData{};
+		std::pmr::vector<std::pair<ParamId, std::any>> mData;
+	#ifndef NDEBUG
+		std::thread::id mArenaThread;	// Default, no thread, unless the params are in a frame arena.
+		uint64_t mArenaFrame = 0;
+	#endif
+
+		void AssertUsable() const
+		{
+		#ifndef NDEBUG
+			assert((mArenaThread == std::thread::id() || mArenaThread == std::this_thread::get_id()) && "Event used on another thread than its frame arena's.");
+			assert((mArenaThread == std::thread::id() || FrameArenas::Get().GetFrame() < mArenaFrame + OTTER_MAX_FRAMES_IN_FLIGHT) && "Event used after its frame arena was reset.");
+		#endif
+		}
 	};
 }
\ No newline at end of file
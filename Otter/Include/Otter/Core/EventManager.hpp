@@ -18,9 +18,12 @@ namespace Otter
 
 		void SendEvent(Event& event)
 		{
-			uint32_t type = event.GetType();
+			// find instead of operator[], which would allocate an empty list for events nobody listens to.
+			auto it = listeners.find(event.GetType());
+			if (it == listeners.end())
+				return;
 
-			for (auto const& listener : listeners[type])
+			for (auto const& listener : it->second)
 			{
 				listener(event);
 			}
@@ -28,9 +31,12 @@ namespace Otter
 
 		void SendEvent(EventId eventId)
 		{
-			Event event(eventId);
+			auto it = listeners.find(eventId);
+			if (it == listeners.end())
+				return;
 
-			for (auto const& listener : listeners[eventId])
+			Event event(eventId);
+			for (auto const& listener : it->second)
 			{
 				listener(event);
 			}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Otter/Core/Types.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Otter
+{
+	/*
+		Bump allocator: allocating moves a pointer, individual frees do nothing and Reset releases everything at once.
+		Allocations that don't fit go to the heap until the next Reset, which then grows the block so it fits next time.
+		Not thread safe, give every thread its own.
+	*/
+	class LinearArena
+	{
+	public:
+		static const size_t DEFAULT_CAPACITY = 256 * 1024;
+
+		explicit LinearArena(size_t capacity = DEFAULT_CAPACITY);
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		template<typename T>
+		T* Allocate(size_t count = 1) { return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T))); }	// Uninitialized.
+		void Reset();
+
+		inline size_t GetUsedBytes() const { return offset + overflowBytes; }	// Since the last Reset.
+		inline size_t GetCapacity() const { return capacity; }
+		inline size_t GetPeakBytes() const { return peakBytes; }				// Most used between two resets.
+		inline uint64_t GetOverflowCount() const { return overflowCount; }		// Allocations that had to go to the heap, ever.
+
+	private:
+		std::unique_ptr<std::byte[]> block;
+		size_t capacity = 0;
+		size_t offset = 0;
+		size_t overflowBytes = 0;
+		size_t peakBytes = 0;
+		uint64_t overflowCount = 0;
+		std::vector<std::unique_ptr<std::byte[]>> overflow;
+	};
+
+	// Lets std::pmr containers allocate from a LinearArena. Deallocating is a no-op, the memory comes back when the arena resets.
+	class ArenaResource : public std::pmr::memory_resource
+	{
+	public:
+		explicit ArenaResource(LinearArena& arena) : arena(arena) {}
+		inline LinearArena& GetArena() const { return arena; }
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override { return arena.Allocate(bytes, alignment); }
+		void do_deallocate(void*, size_t, size_t) override {}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	private:
+		LinearArena& arena;
+	};
+
+	struct FrameArenaStats
+	{
+		size_t threads = 0;
+		size_t lastFrameBytes = 0;	// Summed over threads, of each thread's last finished frame.
+		size_t capacityBytes = 0;
+		size_t peakBytes = 0;		// Summed over threads, each thread's worst frame.
+		uint64_t overflows = 0;
+	};
+
+	/*
+		Scratch memory for data that lives no longer than a frame: temporary lists, events, command lists being built.
+		Every thread has one arena per frame in flight. A thread switches to the next one the first time it allocates in a new frame,
+		resetting it wholesale, so something allocated in frame N stays valid until frame N + MAX_FRAMES_IN_FLIGHT starts.
+		Threads only ever touch their own arenas, so allocating takes no lock. Entries of threads that exit are handed to new threads.
+
+			std::pmr::vector<VkPhysicalDevice> gpus(gpuCount, FrameArenas::GetResource());
+	*/
+	class FrameArenas
+	{
+	public:
+		static FrameArenas& Get();
+		static LinearArena& GetArena();					// The calling thread's arena for the current frame.
+		static std::pmr::memory_resource* GetResource();	// Same, for std::pmr containers.
+
+		inline void BeginFrame() { frame.fetch_add(1, std::memory_order_release); }	// Main thread, once per main loop iteration.
+		inline uint64_t GetFrame() const { return frame.load(std::memory_order_acquire); }
+		FrameArenaStats GetStats() const;
+
+		void DrawImGui() const;
+
+	private:
+		struct Slot
+		{
+			LinearArena arena;
+			ArenaResource resource{arena};
+		};
+
+		struct ThreadArenas
+		{
+			std::string name;
+			std::array<Slot, OTTER_MAX_FRAMES_IN_FLIGHT> slots;
+			uint64_t frame = 0;	// Owning thread only, the frame its arenas were last switched for.
+			std::atomic<bool> inUse = true;
+
+			// Published when a slot is reset, so other threads can read the stats without racing the owner.
+			std::atomic<size_t> lastFrameBytes = 0;
+			std::atomic<size_t> capacityBytes = 0;
+			std::atomic<size_t> peakBytes = 0;
+			std::atomic<uint64_t> overflows = 0;
+		};
+
+		std::atomic<uint64_t> frame = 0;
+		mutable std::mutex threadsMutex;
+		std::vector<std::unique_ptr<ThreadArenas>> threads;
+
+		FrameArenas() = default;
+		ThreadArenas& GetThreadArenas();
+		Slot& GetCurrentSlot();
+	};
+}
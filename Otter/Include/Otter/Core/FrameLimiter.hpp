@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace Otter
+{
+	// All values in milliseconds, calculated over the last FRAME_TIMING_HISTORY frames.
+	struct FrameTimingStats
+	{
+		float averageFrameTime = 0.0f;
+		float minFrameTime = 0.0f;
+		float maxFrameTime = 0.0f;
+		float jitter = 0.0f;			// Standard deviation of the frame time.
+		float averageWaitTime = 0.0f;	// Time the limiter spent sleeping/spinning per frame.
+		float averageOvershoot = 0.0f;	// How late the limiter woke up compared to the deadline.
+	};
+
+	static const size_t FRAME_TIMING_HISTORY = 128;
+
+	/*
+		Caps the frame rate without relying on vsync.
+		The OS scheduler can oversleep by a millisecond or more, so we sleep until we're close to the deadline and spin-wait the remainder.
+		How close we sleep is learned from how much previous sleeps overshot, so a coarse timer on one machine doesn't ruin pacing on another.
+		Deadlines are absolute: time spent simulating, recording and presenting (which can block) is subtracted from the wait automatically.
+	*/
+	class FrameLimiter
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		FrameLimiter();
+
+		void SetTargetFrameRate(float framesPerSecond);	// 0 or lower disables the limiter, frame timing is still recorded.
+		inline float GetTargetFrameRate() const { return targetFrameRate; }
+		inline const FrameTimingStats& GetStats() const { return stats; }
+
+		void WaitForNextFrame();	// Call once at the end of every frame.
+
+	private:
+		float targetFrameRate = 0.0f;
+		Clock::duration framePeriod = Clock::duration::zero();
+		Clock::time_point nextDeadline;
+		Clock::time_point lastFrameEnd;
+
+		// Running estimate of how much a 1ms sleep overshoots, used as the spin-wait window.
+		double sleepOvershootMean = 0.0;
+		double sleepOvershootVariance = 0.0;
+
+		std::array<float, FRAME_TIMING_HISTORY> frameTimes{};
+		std::array<float, FRAME_TIMING_HISTORY> waitTimes{};
+		std::array<float, FRAME_TIMING_HISTORY> overshoots{};
+		size_t historyIndex = 0;
+		size_t historyCount = 0;
+		FrameTimingStats stats{};
+
+		void SleepUntil(Clock::time_point deadline);
+		void RecordFrame(float frameTime, float waitTime, float overshoot);
+	};
+}
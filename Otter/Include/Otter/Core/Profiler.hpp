@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Scoped CPU markers, compiled out unless the OTTER_PROFILING CMake option is on (the default, so spikes can be caught in release builds too).
+	Names must outlive the profiler, use string literals.
+
+		OTTER_PROFILE_FRAME();				// Once at the start of every main loop iteration.
+		OTTER_PROFILE_SCOPE("Renderer::DrawFrame");
+*/
+#ifdef OTTER_PROFILING
+	#define OTTER_PROFILE_CONCAT_INNER(a, b) a##b
+	#define OTTER_PROFILE_CONCAT(a, b) OTTER_PROFILE_CONCAT_INNER(a, b)
+	#define OTTER_PROFILE_SCOPE(name) ::Otter::ProfileScope OTTER_PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define OTTER_PROFILE_FRAME() ::Otter::Profiler::Get().BeginFrame()
+#else
+	#define OTTER_PROFILE_SCOPE(name)
+	#define OTTER_PROFILE_FRAME()
+#endif
+
+namespace Otter
+{
+	struct ProfileEvent
+	{
+		const char* name;
+		uint64_t start;		// ns since the profiler was created.
+		uint64_t end;
+		uint32_t depth;		// Nesting level within its thread.
+		uint32_t thread;	// Index into the profiler's thread list.
+	};
+
+	/*
+		Every thread records into its own ring buffer, so markers never contend with each other.
+		The buffers are single producer: only the owning thread writes, any thread may read a copy of the recent events.
+		Old events are overwritten, a buffer holds the last THREAD_BUFFER_SIZE scopes of its thread.
+	*/
+	class Profiler
+	{
+	public:
+		static const size_t THREAD_BUFFER_SIZE = 1 << 15;
+		static const size_t FRAME_HISTORY = 256;
+
+		static Profiler& Get();
+		static uint64_t Now();
+
+		void BeginFrame();	// Closes the previous frame and checks it for spikes. Main thread only.
+		uint32_t PushScope();	// Returns the depth of the new scope on the calling thread.
+		void PopScope();
+		void Record(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+
+		// Timelines that aren't a CPU thread, like a GPU queue. Each track must only be recorded to from one thread at a time.
+		uint32_t CreateTrack(const std::string& name);
+		void RecordTrack(uint32_t track, const char* name, uint64_t start, uint64_t end, uint32_t depth);
+
+		inline void SetPaused(bool paused) { this->paused = paused; }
+		inline bool IsPaused() const { return paused; }
+
+		// Automatically export the last windowSeconds whenever a frame takes longer than thresholdMs. 0 disables.
+		inline void SetSpikeCapture(float thresholdMs, float windowSeconds = 2.0f) { spikeThresholdMs = thresholdMs; spikeWindowSeconds = windowSeconds; }
+
+		std::vector<ProfileEvent> Collect(uint64_t from, uint64_t to);
+		bool ExportChromeTrace(const std::string& path, float lastSeconds = 0.0f);	// 0 exports everything still buffered. Open in chrome://tracing or ui.perfetto.dev.
+		void ExportChromeTraceAsync(const std::string& path, float lastSeconds = 0.0f);	// Copies the events and writes the file on another thread.
+
+		void DrawImGui(bool* open = nullptr);
+
+	private:
+		struct ThreadBuffer
+		{
+			// Fields are atomics so a reader copying a slot the writer is overwriting is a stale value, not a data race. Relaxed, so plain moves on x86.
+			struct Slot
+			{
+				std::atomic<const char*> name;
+				std::atomic<uint64_t> start;
+				std::atomic<uint64_t> end;
+				std::atomic<uint32_t> depth;
+			};
+
+			std::string name;
+			uint32_t index = 0;
+			uint32_t depth = 0;	// Owning thread only.
+			std::atomic<uint64_t> writeCount = 0;
+			std::unique_ptr<Slot[]> slots;
+		};
+
+		struct FrameRecord
+		{
+			uint64_t start = 0;
+			uint64_t end = 0;
+		};
+
+		std::chrono::steady_clock::time_point origin;
+		std::mutex threadsMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threads;	// Never shrinks, threads that exit keep their history.
+		std::atomic<bool> paused = false;
+
+		std::array<FrameRecord, FRAME_HISTORY> frames;
+		uint64_t frameCount = 0;
+		uint64_t frameStart = 0;
+		int64_t selectedFrame = -1;	// -1 follows the newest frame.
+
+		float spikeThresholdMs = 0.0f;
+		float spikeWindowSeconds = 2.0f;
+		uint64_t lastSpikeCapture = 0;
+		std::future<void> pendingExport;
+
+		Profiler();
+		~Profiler();
+
+		ThreadBuffer& GetThreadBuffer();
+		ThreadBuffer* AddBuffer(const std::string& name);
+		void Write(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end, uint32_t depth);
+		std::vector<std::string> GetThreadNames();
+		static bool WriteChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events, const std::vector<std::string>& threadNames);
+		void DrawTimeline(const FrameRecord& frame);
+	};
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(const char* name);
+		~ProfileScope();
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* name;
+		uint64_t start;
+		uint32_t depth;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Otter
+{
+	/*
+		Collects how long each initialization step took, and when it started, so serialization in start up is easy to spot.
+		Steps can be recorded from any thread; Log prints them sorted by start time.
+	*/
+	class StartupTimeline
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		StartupTimeline(std::string name);
+
+		void Record(const std::string& step, Clock::time_point start, Clock::time_point end);
+		void Log();
+
+		template<typename F>
+		auto Measure(const std::string& step, F&& function)
+		{
+			Clock::time_point start = Clock::now();
+			if constexpr (std::is_void_v<decltype(function())>)
+			{
+				function();
+				Record(step, start, Clock::now());
+			}
+			else
+			{
+				auto result = function();
+				Record(step, start, Clock::now());
+				return result;
+			}
+		}
+
+	private:
+		struct Step
+		{
+			std::string name;
+			float startOffset;	// ms since the timeline was created.
+			float duration;		// ms
+			bool mainThread;
+		};
+
+		std::string name;
+		Clock::time_point origin;
+		std::thread::id ownerThread;
+		std::mutex stepsMutex;
+		std::vector<Step> steps;
+	};
+}
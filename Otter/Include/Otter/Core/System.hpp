@@ -15,5 +15,6 @@ namespace Otter
 		virtual void OnStart() = 0;
 		virtual void OnStop() = 0;
 		virtual void OnTick(float deltaTime) {};
+		virtual const char* GetName() const { return "System"; }	// For profiling and allocation tracking.
 	};
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Otter
+{
+	/*
+		Fixed set of worker threads for CPU heavy jobs (shader compilation, image decoding, mesh import, ...).
+		Tasks run in submission order as workers become free, results are handed back through std::future.
+	*/
+	class ThreadPool
+	{
+	public:
+		ThreadPool(size_t threadCount = 0);	// 0 picks one less than the hardware threads, leaving one for the main thread.
+		~ThreadPool();						// Finishes all queued tasks before returning.
+
+		template<typename F>
+		auto Submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+
+		inline size_t GetThreadCount() const { return workers.size(); }
+
+	private:
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+		std::mutex tasksMutex;
+		std::condition_variable tasksAvailable;
+		bool stopping = false;
+
+		void WorkerMain(size_t index);
+	};
+
+	template<typename F>
+	auto ThreadPool::Submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<F>>;
+
+		// std::function needs a copyable target, packaged_task is move only.
+		auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+		std::future<Result> future = packagedTask->get_future();
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			tasks.emplace([packagedTask]() { (*packagedTask)(); });
+		}
+		tasksAvailable.notify_one();
+
+		return future;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Otter
+{
+	static const uint8_t TRIPLE_BUFFER_SLOTS = 3;
+
+	/*
+		Lock-free single producer, single consumer hand-off of the latest value.
+		The writer always has a slot to fill and the reader always has a consistent slot to read, neither ever waits on the other.
+		If the writer publishes faster than the reader consumes, intermediate values are dropped and the reader gets the newest one.
+	*/
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() : middle(1) {}
+
+		// Writer side.
+		inline T& GetWriteBuffer() { return buffers[writeIndex]; }
+		void Publish()
+		{
+			// Swap our filled slot with the middle one and flag it as new.
+			uint8_t previous = middle.exchange(writeIndex | DIRTY_BIT, std::memory_order_acq_rel);
+			writeIndex = previous & INDEX_MASK;
+		}
+
+		// Reader side. Returns true if a newer value was published since the last call.
+		bool Consume()
+		{
+			if ((middle.load(std::memory_order_relaxed) & DIRTY_BIT) == 0)
+				return false;
+
+			uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+			readIndex = previous & INDEX_MASK;
+			return true;
+		}
+		inline T& GetReadBuffer() { return buffers[readIndex]; }
+
+	private:
+		static const uint8_t DIRTY_BIT = 0x4;
+		static const uint8_t INDEX_MASK = 0x3;
+
+		std::array<T, TRIPLE_BUFFER_SLOTS> buffers{};
+		uint8_t writeIndex = 0;
+		uint8_t readIndex = 2;
+		std::atomic<uint8_t> middle;
+	};
+}
@@ -4,6 +4,11 @@
 #include <cstdint>
 #include <glm/glm.hpp>
 
+// Set from CMake, defaulted here so code outside the renderer (frame arenas) can size per-frame data without including Vulkan.
+#ifndef OTTER_MAX_FRAMES_IN_FLIGHT
+#define OTTER_MAX_FRAMES_IN_FLIGHT 2
+#endif
+
 namespace Otter
 {
 	// Source: https://gist.github.com/Lee-R/3839813
@@ -21,6 +26,7 @@ namespace Otter
 	// ECS
 	using Entity = std::uint32_t;
 	const Entity MAX_ENTITIES = 5000;
+	const Entity INVALID_ENTITY = MAX_ENTITIES;
 	using ComponentType = std::uint8_t;
 	const ComponentType MAX_COMPONENTS = 32;
 	using Signature = std::bitset<MAX_COMPONENTS>;
@@ -64,4 +70,12 @@ namespace Otter
 		const ParamId WIDTH = "Events::Window::Resized::WIDTH"_hash;
 		const ParamId HEIGHT = "Events::Window::Resized::HEIGHT"_hash;
 	}
+
+	namespace Events::Assets {
+		const EventId LOADED = "Events::Assets::LOADED"_hash;
+	}
+
+	namespace Events::Assets::Loaded {
+		const ParamId ASSET = "Events::Assets::Loaded::ASSET"_hash;	// Rendering::AssetId, the hash of the path.
+	}
 }
\ No newline at end of file
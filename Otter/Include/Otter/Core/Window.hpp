@@ -4,19 +4,29 @@
 #include "SDL.h"
 #include "Otter/Core/Coordinator.hpp"
 #include "Otter/Systems/Renderer.hpp"
+#include "Otter/Systems/TransformSystem.hpp"
 
 namespace Otter
 {
 	class Window 
 	{
 	public:
-		Window(glm::vec2 size, std::string title, bool imGuiAllowed);
+		Window(glm::vec2 size, std::string title, bool imGuiAllowed, bool headless = false);	// Headless windows have no SDL window or ImGui, they render offscreen.
 		virtual ~Window();
 
 		virtual void OnStart();
 
-		inline bool IsValid() { return handle != nullptr && initialized; }
+		inline bool IsValid() { return (handle != nullptr || headless) && initialized; }
+		inline bool IsHeadless() { return headless; }
+		inline bool IsActive() { return shown && !minimized; }	// Inactive windows are not rendered.
 		inline uint32_t GetWindowId() { return windowId; }
+		inline void SetRenderDevice(std::shared_ptr<Rendering::RenderDevice> device) { renderer->SetRenderDevice(device); }
+		inline void SetRenderThreadEnabled(bool enabled) { renderer->SetRenderThreadEnabled(enabled); }
+		inline const Rendering::GpuProfiler& GetGpuProfiler() const { return renderer->GetGpuProfiler(); }
+		inline Systems::RenderStats GetRenderStats() const { return renderer->GetRenderStats(); }
+		inline void SetPresentMode(VkPresentModeKHR mode) { renderer->SetPresentMode(mode); }
+		inline void CaptureFrame(const std::string& path) { renderer->CaptureFrame(path); }	// Headless only, see Renderer::CaptureFrame.
+		inline void Close() { shouldBeDestroyed = true; }
 		bool ShouldBeDestroyed();
 
 		virtual void OnTick(float deltaTime);
@@ -28,9 +38,13 @@ namespace Otter
 	protected:
 		Coordinator coordinator;
 
+		template<typename T>
+		std::shared_ptr<T> RegisterSystem(Signature signature);	// Call from the constructor, before creating entities. Systems tick in registration order, the renderer last.
+
 	private:
 		bool initialized = false;
 		bool shouldBeDestroyed = false;
+		bool headless = false;
 		std::string title;
 
 		std::vector<std::shared_ptr<Otter::System>> systems;
@@ -47,4 +61,13 @@ namespace Otter
         bool minimized = false;
         bool shown = false;
 	};
+
+	template<typename T>
+	std::shared_ptr<T> Window::RegisterSystem(Signature signature)
+	{
+		std::shared_ptr<T> system = coordinator.RegisterSystem<T>();
+		coordinator.SetSystemSignature<T>(signature);
+		systems.push_back(system);
+		return system;
+	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@ extern Otter::Application* Otter::CreateApplication();
 int main(int argc, char* argv[], char* envp[])
 {
 	auto app = Otter::CreateApplication();
-	app->Run(argc, argv, envp);
+	int exitCode = app->Run(argc, argv, envp);
 	delete app;
+	return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#include "Otter/Core/TripleBuffer.hpp"
+#include "Otter/Core/Types.hpp"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Otter::Rendering
+{
+	class RenderDevice;
+
+	using AssetId = std::uint32_t;	// fnv1a_32 of the path, so "Assets/Meshes/x.obj"_hash is the same id.
+	const AssetId INVALID_ASSET = 0;
+
+	enum class AssetType : std::uint8_t
+	{
+		Mesh,
+		Texture,
+		Shader
+	};
+
+	// What components store instead of paths. Typed, so a texture can't end up where a mesh is expected.
+	template<AssetType Type>
+	struct AssetHandle
+	{
+		AssetId id = INVALID_ASSET;
+
+		inline bool IsValid() const { return id != INVALID_ASSET; }
+		inline bool operator==(const AssetHandle& other) const { return id == other.id; }
+		inline bool operator!=(const AssetHandle& other) const { return id != other.id; }
+	};
+
+	using MeshHandle = AssetHandle<AssetType::Mesh>;
+	using TextureHandle = AssetHandle<AssetType::Texture>;
+	using ShaderHandle = AssetHandle<AssetType::Shader>;
+
+	struct AssetStats
+	{
+		size_t assets = 0;		// Ever interned.
+		size_t referenced = 0;
+		size_t unused = 0;		// Unreferenced, waiting for eviction.
+		uint64_t residentBytes = 0;
+		uint64_t budgetBytes = 0;
+		uint64_t evictions = 0;
+	};
+
+	/*
+		Interns asset paths into compact ids and counts who uses what, so a thousand entities sharing a mesh share one handle,
+		one import and one upload. Acquiring a path that's already known is a hash and a lookup.
+		Handles are counted explicitly: every Acquire needs a Release. Components::MeshRenderer does that for entities, it owns its handles.
+		Loading stays with the RenderDevice, which caches by path. Assets nobody references are kept around for reuse, until the
+		device's resident bytes exceed the budget: then the ones released longest ago are unloaded first.
+		Ids are never forgotten, so paths returned by GetPath stay valid. Shaders are counted but never evicted, they're tiny.
+	*/
+	class AssetManager
+	{
+	public:
+		static constexpr uint64_t DEFAULT_BUDGET = 1024ull * 1024 * 1024;
+
+		static AssetManager& Get();
+
+		MeshHandle AcquireMesh(const std::string& path);
+		TextureHandle AcquireTexture(const std::string& path);
+		ShaderHandle AcquireShader(const std::string& name);
+		template<AssetType Type> void Acquire(AssetHandle<Type> handle) { AddReference(handle.id); }	// Another reference to the same asset.
+		template<AssetType Type> void Release(AssetHandle<Type> handle) { RemoveReference(handle.id); }
+		template<AssetType Type> const std::string& GetPath(AssetHandle<Type> handle) const { return GetPath(handle.id); }
+		const std::string& GetPath(AssetId id) const;
+
+		void Update(RenderDevice& device);	// Once a frame, on the main thread. Evicts unused assets while over budget.
+		inline void SetBudget(uint64_t bytes) { budgetBytes = bytes; }
+		AssetStats GetStats() const;
+		void DrawImGui() const;
+
+	private:
+		// A snapshot built before an asset's last release can sit in a renderer's TripleBuffer, then wait for a frame in flight
+		// before it's submitted. Once it is, the device's frame timeline keeps the GPU memory alive instead.
+		static const uint64_t EVICTION_DELAY_FRAMES = TRIPLE_BUFFER_SLOTS + OTTER_MAX_FRAMES_IN_FLIGHT;
+
+		struct Entry
+		{
+			std::string path;
+			AssetType type = AssetType::Mesh;
+			uint32_t references = 0;
+			uint64_t releasedFrame = 0;
+			std::list<AssetId>::iterator unused;	// Position in unusedAssets while references is 0.
+		};
+
+		mutable std::mutex mutex;
+		std::unordered_map<AssetId, Entry> entries;
+		std::list<AssetId> unusedAssets;	// Least recently released first.
+		uint64_t frame = 0;
+		uint64_t budgetBytes = DEFAULT_BUDGET;
+		uint64_t residentBytes = 0;			// As of the last Update.
+		uint64_t evictions = 0;
+
+		AssetId Intern(const std::string& path, AssetType type);	// Also adds a reference.
+		void AddReference(AssetId id);
+		void RemoveReference(AssetId id);
+	};
+}
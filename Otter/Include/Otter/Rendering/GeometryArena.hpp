@@ -0,0 +1,81 @@
+#pragma once
+#include "vulkan/vulkan.h"
+#include "vk_mem_alloc.h"
+#include <cstdint>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	// Everything needed to record a draw of a mesh, copied into snapshots so recording never touches the arena.
+	struct MeshDraw
+	{
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+		uint32_t indexCount = 0;
+		uint32_t firstIndex = 0;	// In indices of indexType, from the start of the index buffer.
+		int32_t vertexOffset = 0;	// In vertices, from the start of the vertex buffer.
+	};
+
+	struct GeometryAllocation
+	{
+		MeshDraw draw;
+		uint32_t page = 0;
+		VkDeviceSize vertexByteOffset = 0;
+		VkDeviceSize indexByteOffset = 0;
+		VmaVirtualAllocation vertexAllocation = VK_NULL_HANDLE;
+		VmaVirtualAllocation indexAllocation = VK_NULL_HANDLE;
+	};
+
+	/*
+		Sub-allocates the vertex and index data of meshes out of a few large device-local buffers, instead of a VkBuffer and
+		memory allocation per mesh, so consecutive draws of different meshes mostly don't need to rebind anything.
+		Buffers come in pages, created as needed (bigger than PAGE_*_BYTES for a mesh that wouldn't fit otherwise).
+		Ranges are tracked with VMA virtual blocks, so freed ranges are reused by later meshes.
+		16 and 32 bit indices share the index buffers, ranges are 4 byte aligned so either type can start anywhere.
+		With hostWritable (unified memory, resizable BAR) pages are placed in device-local memory the CPU can map, if VMA finds
+		any, so Write can fill a range without a staging copy. Otherwise filling ranges is up to the caller. Not thread safe.
+	*/
+	class GeometryArena
+	{
+	public:
+		static constexpr VkDeviceSize PAGE_VERTEX_BYTES = 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize PAGE_INDEX_BYTES = 32ull * 1024 * 1024;
+
+		void Create(VmaAllocator allocator, uint32_t vertexStride, bool hostWritable = false, const std::vector<uint32_t>& sharedQueueFamilies = {});	// Buffers are shared concurrently if there's more than one family.
+		void Destroy();
+
+		bool Allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, GeometryAllocation& allocation);
+		void Free(GeometryAllocation& allocation);	// The GPU must be done with the range.
+		bool Write(const GeometryAllocation& allocation, const void* vertices, VkDeviceSize vertexBytes, const void* indices, VkDeviceSize indexBytes);	// False if the page isn't mapped, stage the data instead.
+
+		inline uint32_t GetVertexStride() const { return vertexStride; }
+		inline size_t GetPageCount() const { return pages.size(); }
+		inline VkDeviceSize GetUsedBytes() const { return usedBytes; }
+		inline VkDeviceSize GetCapacityBytes() const { return capacityBytes; }
+
+	private:
+		struct Page
+		{
+			VkBuffer vertexBuffer = VK_NULL_HANDLE;
+			VmaAllocation vertexBufferAllocation = VK_NULL_HANDLE;
+			VmaVirtualBlock vertexBlock = VK_NULL_HANDLE;	// In vertices rather than bytes, so every range starts on a whole vertex.
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			VmaAllocation indexBufferAllocation = VK_NULL_HANDLE;
+			VmaVirtualBlock indexBlock = VK_NULL_HANDLE;		// In bytes.
+			uint8_t* mappedVertices = nullptr;	// Only if hostWritable and VMA found host visible memory for both buffers.
+			uint8_t* mappedIndices = nullptr;
+		};
+
+		VmaAllocator allocator = VK_NULL_HANDLE;
+		uint32_t vertexStride = 0;
+		bool hostWritable = false;
+		std::vector<uint32_t> sharedQueueFamilies;
+		std::vector<Page> pages;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize capacityBytes = 0;
+
+		void CreatePage(VkDeviceSize vertexCapacity, VkDeviceSize indexBytes);
+		bool AllocateInPage(uint32_t page, uint32_t vertexCount, VkDeviceSize indexBytes, GeometryAllocation& allocation);
+	};
+}
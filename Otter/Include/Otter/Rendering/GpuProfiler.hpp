@@ -0,0 +1,72 @@
+#pragma once
+#include "Otter/Rendering/RenderTypes.hpp"
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	class RenderDevice;
+
+	struct GpuPassTiming
+	{
+		const char* name = nullptr;
+		float milliseconds = 0.0f;
+		bool hasStatistics = false;
+		uint64_t vertexInvocations = 0;
+		uint64_t fragmentInvocations = 0;
+	};
+
+	/*
+		Timestamp and pipeline statistics queries around the passes of a renderer's command buffers.
+		Each frame in flight has its own range in the query pools. Results are read when that frame's slot comes around again,
+		after its fence was waited on, so reading never stalls: they lag MAX_FRAMES_IN_FLIGHT frames behind.
+		Everything but GetResults and DrawImGui must be called from the thread recording the command buffers.
+	*/
+	class GpuProfiler
+	{
+	public:
+		static const uint32_t MAX_PASSES = 8;	// Per frame.
+
+		void Create(RenderDevice& device, const std::string& name);	// Name of the track in the CPU profiler's timeline and exports.
+		void Destroy();
+		inline bool IsEnabled() const { return timestampPool != VK_NULL_HANDLE; }
+
+		void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);	// Outside a render pass, queries can't be reset inside one.
+		void BeginPass(VkCommandBuffer commandBuffer, const char* name);		// Name must be a string literal. Passes can't nest.
+		void EndPass(VkCommandBuffer commandBuffer);
+
+		std::vector<GpuPassTiming> GetResults(float* frameMilliseconds = nullptr, uint64_t* resolvedFrames = nullptr) const;	// Of the most recent frame the GPU finished. resolvedFrames counts frames read so far, to tell new results apart.
+		float GetFrameMilliseconds(uint64_t* resolvedFrames = nullptr) const;	// Same, without copying the passes.
+		void DrawImGui() const;
+
+	private:
+		struct FrameQueries
+		{
+			std::array<const char*, MAX_PASSES> passNames{};
+			uint32_t passCount = 0;
+			uint64_t recordTime = 0;	// Profiler clock when recording started, anchors the GPU timestamps on the CPU timeline.
+			bool pending = false;
+		};
+
+		std::string name;
+		VkDevice logicalDevice = VK_NULL_HANDLE;
+		VkQueryPool timestampPool = VK_NULL_HANDLE;
+		VkQueryPool statisticsPool = VK_NULL_HANDLE;	// Stays null if the device doesn't support pipelineStatisticsQuery.
+		float timestampPeriod = 1.0f;	// ns per tick.
+		uint64_t timestampMask = ~0ull;
+		uint32_t profilerTrack = 0;
+
+		std::array<FrameQueries, MAX_FRAMES_IN_FLIGHT> frames;
+		uint32_t currentFrame = 0;
+		bool passOpen = false;
+
+		mutable std::mutex resultsMutex;
+		std::vector<GpuPassTiming> results;
+		float frameMilliseconds = 0.0f;
+		uint64_t resolvedFrames = 0;
+
+		void ReadResults(uint32_t frameIndex);
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Otter/Rendering/RenderTypes.hpp"
+#include "Otter/Utilities/MappedFile.hpp"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	/*
+		Decoded on a worker thread, uploaded to the GPU on first GetTexture.
+		Either owns RGBA8 pixels decoded from a PNG/JPEG, or points into a memory mapped KTX2 file in whatever format it was cooked
+		to (see Ktx2). Use GetData and GetSize rather than pixels so both work.
+	*/
+	struct DecodedImage
+	{
+		std::vector<uint8_t> pixels;
+		std::shared_ptr<const MappedFile> cookedFile;
+		size_t cookedOffset = 0;		// Of the level data in cookedFile, the level offsets are relative to it.
+		size_t cookedSize = 0;
+		std::string sourcePath;			// Of the image a cooked texture was made from. Decoded instead if the device can't sample format.
+
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		Vec2D size = {0, 0};
+		std::vector<MipLevel> levels;	// Into the data, largest first. Levels past these are generated on upload.
+
+		inline const uint8_t* GetData() const { return cookedFile ? cookedFile->GetData() + cookedOffset : pixels.data(); }
+		inline size_t GetSize() const { return cookedFile ? cookedSize : pixels.size(); }
+	};
+
+	/*
+		Reads and writes KTX2 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html), the container cooked textures come in.
+		Only what the engine can upload as-is: a single 2D image with its mip levels, in RGBA8 or BC1/BC3/BC5/BC7.
+		No supercompression (Basis Universal, zstd), arrays, cube maps or 3D images. KTX2 is little endian, so is every target.
+		Textures are cooked offline by the TextureCooker tool, next to their source image. Cooked levels are copied straight from
+		the mapping into the staging ring.
+	*/
+	class Ktx2
+	{
+	public:
+		static const char* EXTENSION;	// ".ktx2"
+
+		static bool IsSupportedFormat(VkFormat format);
+		static bool Load(const std::filesystem::path& path, DecodedImage& image);	// False if the file is missing, malformed or uses something unsupported.
+		static bool Store(const std::filesystem::path& path, const DecodedImage& image);	// With the levels image has.
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Otter/Rendering/RenderTypes.hpp"
+#include "Otter/Utilities/MappedFile.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	// One triangle mesh of the imported file. Indices are already relative to the merged vertex data, so no base vertex.
+	struct SubMesh
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		uint32_t materialIndex = 0;	// As numbered by the source file.
+		Bounds bounds;
+	};
+
+	/*
+		Imported and optimized (see MeshOptimizer) on a worker thread, already in the layout the GPU wants, uploaded on first LoadMesh.
+		Either owns its vertex and index data (fresh import), or points into a memory mapped cooked mesh, see MeshCache.
+		Use the Get*Data accessors rather than the vectors so both work.
+	*/
+	struct MeshData
+	{
+		std::vector<GpuVertex> vertices;
+		std::vector<uint8_t> indices;	// uint16_t or uint32_t, as indexType says. 16 bit whenever the vertex count allows.
+		std::shared_ptr<const MappedFile> cookedFile;
+		size_t cookedVertexOffset = 0;
+		size_t cookedIndexOffset = 0;
+
+		uint32_t vertexCount = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+		uint32_t indexCount = 0;
+		Bounds bounds;
+		std::vector<SubMesh> subMeshes;
+
+		inline const void* GetVertexData() const { return cookedFile ? cookedFile->GetData() + cookedVertexOffset : static_cast<const void*>(vertices.data()); }
+		inline const void* GetIndexData() const { return cookedFile ? cookedFile->GetData() + cookedIndexOffset : static_cast<const void*>(indices.data()); }
+		inline size_t GetVertexBytes() const { return static_cast<size_t>(vertexCount) * sizeof(GpuVertex); }
+		inline size_t GetIndexBytes() const { return static_cast<size_t>(indexCount) * (indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2); }
+	};
+
+	/*
+		Cooked meshes: the result of an import written to disk as-is, so warm starts skip assimp entirely.
+		Files live in CookedMeshes/, next to CompiledShaders/, named after the source file's content hash mixed with the import
+		settings, the cooked format version and the GPU vertex layout. Changing any of those simply misses the cache.
+		A cooked mesh is memory mapped, the vertex and index data are copied straight from the mapping into the staging buffer.
+		Layout: header, submesh table, vertex data, index data. Sections are 16 byte aligned. Host endianness.
+	*/
+	class MeshCache
+	{
+	public:
+		static constexpr uint32_t VERSION = 2;	// Bump when the cooked layout or the import itself changes.
+
+		static std::string GetKey(const MappedFile& source, uint32_t importFlags);
+		static bool Load(const std::string& key, MeshData& mesh);	// False if there is no valid cooked mesh for the key.
+		static bool Store(const std::string& key, const MeshData& mesh);
+
+	private:
+		static std::filesystem::path GetPath(const std::string& key);
+	};
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Otter/Core/ThreadPool.hpp"
+#include "vulkan/vulkan.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <string>
+
+namespace Otter::Rendering
+{
+	/*
+		The driver's compiled pipelines, kept on disk so later runs skip shader compilation in the driver when creating pipelines.
+		Files live in CachedPipelines/, one per GPU, next to CookedMeshes/ and CachedTextures/. A file is only handed to the driver if
+		it was written for the same vendor, device, driver version and pipelineCacheUUID and its checksum matches, drivers don't all
+		survive foreign or damaged data. Anything else starts an empty cache, which replaces the file on the next Save.
+		The handle is internally synchronized, like any VkPipelineCache created without the externally synchronized flag, so pipelines
+		can be created while a background save reads it. The class isn't: call Save, SaveInBackground and Destroy from one thread at a time.
+	*/
+	class PipelineCache
+	{
+	public:
+		static constexpr uint32_t VERSION = 1;	// Bump when the file layout changes.
+
+		void Create(VkDevice device, const VkPhysicalDeviceProperties& properties);	// Seeded from this GPU's file if there's a valid one.
+		void Destroy();	// Waits for a background save, then saves.
+		bool Save();	// Writes what the driver has now, unless that's what was loaded or saved last.
+		void SaveInBackground(ThreadPool& threadPool);	// Save on a worker, skipped while one still runs. After creating pipelines, so a crash later on doesn't lose them.
+
+		inline VkPipelineCache GetHandle() const { return cache; }
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties properties{};
+		VkPipelineCache cache = VK_NULL_HANDLE;
+		std::string savedChecksum;	// Of the driver's data as last loaded or saved. Saving is skipped if that didn't change.
+		std::future<bool> pendingSave;
+
+		std::filesystem::path GetPath() const;
+		bool IsValid(const uint8_t* data, size_t size) const;	// A file of ours, for this GPU and driver.
+	};
+}
@@ -0,0 +1,255 @@
+#pragma once
+#include "Otter/Rendering/RenderTypes.hpp"
+#include "Otter/Rendering/GeometryArena.hpp"
+#include "Otter/Rendering/Ktx2.hpp"
+#include "Otter/Rendering/MeshCache.hpp"
+#include "Otter/Rendering/PipelineCache.hpp"
+#include "Otter/Rendering/UploadBatcher.hpp"
+#include "Otter/Core/StartupTimeline.hpp"
+#include "Otter/Core/ThreadPool.hpp"
+#include "SDL.h"
+#include "vk_mem_alloc.h"
+#include <atomic>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace Otter::Rendering
+{
+	struct Texture
+	{
+		VkImage image = VK_NULL_HANDLE;
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		Vec2D size = {0, 0};
+		uint32_t mipLevels = 1;
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		uint32_t textureIndex = 0;	// Its slot in the device's texture table, what shaders index with.
+
+		inline uint64_t GetBytes() const	// The whole mip chain.
+		{
+			uint64_t bytes = 0;
+			for (uint32_t level = 0; level < mipLevels; level++)
+				bytes += GetImageBytes(format, GetMipLevelSize(size, level));
+			return bytes;
+		}
+	};
+
+	// A mesh's place in the device's geometry arena.
+	struct Mesh
+	{
+		GeometryAllocation geometry;
+		uint32_t vertexCount = 0;
+		Bounds bounds;
+		std::vector<SubMesh> subMeshes;	// firstIndex is relative to the mesh's own range, add GetDraw().firstIndex to draw one.
+		glm::mat4 vertexTransform = glm::mat4(1.0f);	// Goes between the model matrix and the vertices. Undoes quantization, see QuantizedVertex.
+
+		inline bool IsResident() const { return geometry.vertexAllocation != VK_NULL_HANDLE; }
+		inline const MeshDraw& GetDraw() const { return geometry.draw; }
+	};
+
+	/*
+		Everything Vulkan that is not tied to a single window: instance, physical/logical device, queues, memory allocator,
+		and caches for resources that windows can share (shaders, render passes, pipelines, textures, geometry).
+		Owned by the Application, so assets are loaded once no matter how many windows show them.
+		Windows keep their own surface, swap chain and per-frame resources (see Systems::Renderer).
+		Renderers may run on their own thread: resource getters are thread safe, queue access must hold GetQueueMutex().
+		CPU side loading (shader compilation, image decoding, mesh import) can be prefetched on the device's thread pool, even before
+		Initialize, so it overlaps device and swap chain creation. The matching getter picks up the result.
+		Pipelines are created through a driver pipeline cache that persists across runs (see PipelineCache).
+		Imported meshes are cooked to disk (see MeshCache), later runs map those instead of importing again. Decoded textures likewise (see TextureCache).
+		Textures load the KTX2 file cooked next to them if there is one (see Ktx2), block compressed and with mips, when the GPU can sample it.
+		Every texture gets a slot in one bindless texture table (set 1, see GetTextureTable), draws pick theirs by index through push constants.
+		Streaming (Stream*) builds on the prefetches: UpdateStreaming uploads whatever finished loading, so a scene shows up right away
+		with placeholders and fills in over the next frames.
+	*/
+	class RenderDevice
+	{
+	public:
+		RenderDevice(std::string applicationName);
+		~RenderDevice();
+
+		bool Initialize(SDL_Window* window, VkSurfaceKHR& surface);	// Creates the instance, a surface for the first window, and a device that can present to it.
+		bool InitializeHeadless();	// No surface or swap chain support: needs no display, only renders to offscreen images.
+		void Shutdown();
+		inline bool IsInitialized() const { return initialized; }
+		inline bool IsHeadless() const { return headless; }
+
+		VkSurfaceKHR CreateSurface(SDL_Window* window);	// Surfaces for every following window. Destroy with vkDestroySurfaceKHR. Not available on a headless device.
+
+		inline VkInstance GetInstance() const { return vulkanInstance; }
+		inline VkPhysicalDevice GetPhysicalDevice() const { return physicalDevice; }
+		inline VkDevice GetLogicalDevice() const { return logicalDevice; }
+		inline VmaAllocator GetAllocator() const { return allocator; }
+		inline const QueueFamilyIndices& GetQueueFamilies() const { return queueFamilies; }
+		inline VkQueue GetGraphicsQueue() const { return graphicsQueue; }
+		inline VkQueue GetPresentQueue() const { return presentQueue; }
+		inline const VkPhysicalDeviceProperties& GetProperties() const { return properties; }
+		inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return enabledFeatures; }
+		inline bool HasUnifiedMemory() const { return unifiedMemory; }	// Assets are written straight into device-local memory, without staging.
+		inline uint32_t GetTimestampValidBits() const { return timestampValidBits; }	// Of the graphics queue, 0 if it can't write timestamps.
+		inline std::mutex& GetQueueMutex() { return queueMutex; }	// Vulkan requires external synchronization of queue submits and presents.
+		inline ThreadPool& GetThreadPool() { return threadPool; }
+		inline uint64_t GetUploadedBytes() const { return uploadedBytes; }	// Total copied to the GPU, staged or written directly.
+		uint64_t FlushUploads();	// Submits the uploads recorded so far. Submits reading device resources wait on GetUploadSemaphore at the returned value.
+		inline VkSemaphore GetUploadSemaphore() const { return uploadBatcher.GetSemaphore(); }	// Timeline.
+		inline const UploadBatcher& GetUploadBatcher() const { return uploadBatcher; }
+		inline VkSemaphore GetFrameSemaphore() const { return frameSemaphore; }	// Timeline, every frame submit signals it at a NextFrameValue.
+		uint64_t NextFrameValue();	// For the next graphics submit to signal. Call while holding GetQueueMutex, right before submitting.
+		inline uint64_t GetResidentAssetBytes() const { return residentAssetBytes; }	// Of loaded meshes and textures, what AssetManager budgets.
+		VkDeviceSize GetAllocatedBytes() const;	// GPU memory currently allocated by this device, over all heaps.
+		void WaitIdle();	// Flushes uploads first.
+
+		// Start loading on a worker thread. Safe to call before Initialize; no-op if already loaded or pending.
+		void PrefetchShader(const std::string& path, std::shared_ptr<StartupTimeline> timeline = nullptr);
+		void PrefetchGraphicsPipeline(const std::string& shader, std::shared_ptr<StartupTimeline> timeline = nullptr);	// Prefetches the shader stages GetGraphicsPipeline will ask for.
+		void PrefetchTexture(const std::string& path, std::shared_ptr<StartupTimeline> timeline = nullptr);
+		void PrefetchMesh(const std::string& path, std::shared_ptr<StartupTimeline> timeline = nullptr);
+
+		// Shared resources. Owned by the device, do not destroy them yourself.
+		VkShaderModule GetShaderModule(const std::string& path);
+		VkRenderPass GetRenderPass(VkFormat colorFormat);	// Leaves the color attachment ready to present, or to copy from on a headless device.
+		VkPipeline GetGraphicsPipeline(const std::string& shader, VkFormat colorFormat);	// Viewport and scissor are dynamic, so pipelines survive resizes and are shared across windows.
+		inline VkDescriptorSetLayout GetDescriptorSetLayout() const { return descriptorSetLayout; }	// Per frame data, set 0.
+		inline VkDescriptorSetLayout GetTextureTableLayout() const { return textureTableLayout; }	// Set 1.
+		inline VkDescriptorSet GetTextureTable() const { return textureTable; }	// Bind once per command buffer, slots are written as textures come and go.
+		inline uint32_t GetTextureTableSize() const { return textureTableSize; }
+		inline VkPipelineLayout GetPipelineLayout() const { return pipelineLayout; }
+		inline VkPipelineCache GetPipelineCache() const { return pipelineCache.GetHandle(); }	// For pipelines created elsewhere, like ImGui's.
+		const Texture& GetTexture(const std::string& path);
+		inline VkSampler GetTextureSampler() const { return textureSampler; }
+		const Mesh& LoadMesh(const std::string& path);	// The reference stays valid until Shutdown, also across UnloadMesh.
+		const Mesh& StreamMesh(const std::string& path);	// Like LoadMesh, but never blocks: starts loading and returns right away. Check IsResident, draw GetPlaceholderMesh meanwhile.
+		const Texture& StreamTexture(const std::string& path);	// The texture if it's resident, otherwise starts loading it and returns the placeholder.
+		void UpdateStreaming();	// Once a frame, on the main thread. Uploads what the workers finished loading, within a per frame budget.
+		inline const std::vector<std::string>& GetStreamedAssets() const { return streamedAssets; }	// Became resident in the last UpdateStreaming. Main thread only.
+		inline const Mesh& GetPlaceholderMesh() const { return placeholderMesh; }
+		inline const Texture& GetPlaceholderTexture() const { return placeholderTexture; }
+		// Unloading doesn't wait for the GPU. The GPU memory, and a texture's table slot, are freed by ReleaseUnloaded once the frames
+		// submitted and uploads recorded so far are done. Frames recorded after the unload must not draw the asset anymore.
+		void UnloadMesh(const std::string& path);		// Its range in the geometry arena goes to other meshes.
+		void UnloadTexture(const std::string& path);	// Invalidates references returned by GetTexture for it.
+		void ReleaseUnloaded();	// Once a frame, on the main thread. Frees what unloaded assets left on the GPU, once it's done with them.
+		inline const GeometryArena& GetGeometryArena() const { return geometryArena; }
+
+		VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
+		void CreateImage(Vec2D size, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkImage& image, VmaAllocation& imageMemory, const std::vector<uint32_t>& sharedQueueFamilies = {}, uint32_t mipLevels = 1);
+		VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+		VkFormat FindDepthFormat();
+
+	private:
+		bool initialized = false;
+		bool headless = false;
+		std::string applicationName;
+
+		VkInstance vulkanInstance = VK_NULL_HANDLE;
+		VkDebugUtilsMessengerEXT debugMessenger;
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties properties{};
+		VkPhysicalDeviceFeatures enabledFeatures{};
+		uint32_t timestampValidBits = 0;
+		bool unifiedMemory = false;		// Large device-local heap the CPU can map: integrated GPUs, software rasterizers, resizable BAR.
+		bool hostImageCopy = false;		// VK_EXT_host_image_copy, textures are copied by the CPU. Only used with unifiedMemory.
+	#ifdef VK_EXT_host_image_copy
+		PFN_vkCopyMemoryToImageEXT copyMemoryToImage = nullptr;
+		PFN_vkTransitionImageLayoutEXT transitionImageLayout = nullptr;
+	#endif
+		VkDevice logicalDevice = VK_NULL_HANDLE;
+		QueueFamilyIndices queueFamilies;
+		VkQueue graphicsQueue = VK_NULL_HANDLE;
+		VkQueue presentQueue = VK_NULL_HANDLE;
+		VkQueue transferQueue = VK_NULL_HANDLE;		// The graphics queue if there's no transfer-only family.
+		std::vector<uint32_t> uploadQueueFamilies;	// Graphics and transfer if they differ, so uploaded resources are shared between them.
+		VmaAllocator allocator = VK_NULL_HANDLE;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		std::mutex queueMutex;
+		std::mutex transferQueueMutex;	// Only used for a transfer queue of its own, otherwise that's queueMutex.
+		UploadBatcher uploadBatcher;
+		std::atomic<uint64_t> uploadedBytes = 0;
+		std::atomic<uint64_t> residentAssetBytes = 0;
+		VkSemaphore frameSemaphore = VK_NULL_HANDLE;
+		std::atomic<uint64_t> frameValue = 0;		// Last handed out by NextFrameValue.
+		std::recursive_mutex resourceMutex;	// Guards the caches below, recursive as pipelines pull in render passes and shaders.
+
+		VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		PipelineCache pipelineCache;
+		VkSampler textureSampler = VK_NULL_HANDLE;
+		VkDescriptorSetLayout textureTableLayout = VK_NULL_HANDLE;
+		VkDescriptorPool textureTablePool = VK_NULL_HANDLE;
+		VkDescriptorSet textureTable = VK_NULL_HANDLE;
+		uint32_t textureTableSize = 0;			// Slots, MAX_TEXTURE_TABLE_SIZE unless the device allows fewer.
+		uint32_t textureTableUsed = 0;			// Slots handed out so far, including freed ones.
+		std::vector<uint32_t> freeTextureSlots;	// Of unloaded textures, reused first.
+
+		std::unordered_map<std::string, VkShaderModule> shaderModules;
+		std::map<VkFormat, VkRenderPass> renderPasses;
+		std::map<std::pair<std::string, VkFormat>, VkPipeline> graphicsPipelines;
+		std::unordered_map<std::string, Texture> textures;
+		std::unordered_map<std::string, Mesh> meshes;	// Node based, so references handed out stay valid.
+		GeometryArena geometryArena;
+
+		ThreadPool threadPool;
+		std::unordered_map<std::string, std::shared_future<std::vector<uint32_t>>> pendingShaders;
+		std::unordered_map<std::string, std::shared_future<DecodedImage>> pendingTextures;
+		std::unordered_map<std::string, std::shared_future<MeshData>> pendingMeshes;
+		std::vector<std::string> streamedAssets;
+		Mesh placeholderMesh;		// A small cube.
+		Texture placeholderTexture;	// A single grey texel.
+
+		// GPU memory of an unloaded mesh or texture, waiting for the GPU to be done with it.
+		struct PendingRelease
+		{
+			uint64_t frameValue = 0;	// Frame submits up to this one may still read it.
+			uint64_t uploadValue = 0;	// Uploads up to this one may still write it.
+			GeometryAllocation geometry;
+			Texture texture;
+		};
+		std::deque<PendingRelease> pendingReleases;	// Oldest first, both values only ever grow.
+
+		bool CreateVulkanInstance(SDL_Window* window);
+		VkResult CreateDebugUtilsMessengerEXT(VkInstance vulkanInstance, const VkDebugUtilsMessengerCreateInfoEXT* createInfo, const VkAllocationCallbacks* allocator, VkDebugUtilsMessengerEXT* debugMessenger);
+		void DestroyDebugUtilsMessengerEXT(VkInstance vulkanInstance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* allocator);
+		bool CheckValidationLayerSupport();
+		std::vector<const char*> GetRequiredExtensions(SDL_Window* window);
+		void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
+		void SetupDebugMessenger();
+
+		bool InitializeDevice(VkSurfaceKHR surface);
+		void SelectPhysicalDevice(VkSurfaceKHR surface);	// Picks a GPU to run Vulkan on. Without a surface, present support is not required.
+		bool IsPhysicalDeviceSuitable(VkPhysicalDevice gpu, VkSurfaceKHR surface);
+		bool HasDeviceExtensionSupport(VkPhysicalDevice gpu);
+		std::vector<const char*> GetRequiredDeviceExtensions() const;
+		QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice gpu, VkSurfaceKHR surface);		// Everything in VK works with queues, we want to query what the GPU can do.
+		void DetectUnifiedMemory();
+		bool HasHostImageCopySupport();
+		bool HasSampledFormatSupport(VkFormat format);	// Textures in it can be sampled with linear filtering. BCn needs the textureCompressionBC feature.
+		bool HasLinearBlitSupport(VkFormat format);	// Mip levels of it can be generated on the GPU.
+		bool HasDescriptorIndexingSupport(VkPhysicalDevice gpu);	// What the texture table needs: runtime sized, partially bound, updated after bind.
+
+		void CreateLogicalDevice();
+		void CreateAllocator();
+		void CreateDescriptorSetLayout();
+		void CreatePipelineLayout();
+		void CreateTextureSampler();
+		void CreateTextureTable();
+		void WriteTextureSlot(uint32_t slot, VkImageView view);
+		void CreatePlaceholders();
+		void DeferRelease(PendingRelease release);	// Records the current frame and upload values with it.
+		void RetireReleases(bool all);	// Frees what the GPU is done with. With all, everything: the GPU must be idle.
+
+		static DecodedImage DecodeTextureImage(const std::string& path);	// The cooked KTX2 texture next to it if there is one, see Ktx2.
+		static DecodedImage DecodeSourceImage(const std::string& path);	// From the texture cache if it's there, otherwise through stb into RGBA8, caching the result.
+		static MeshData ImportMesh(const std::string& path);	// From the cooked mesh if there is one, otherwise through assimp, cooking the result.
+		static void PackMeshData(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, MeshData& data);	// Into the GPU layouts. data.bounds must be set.
+		Texture CreateTextureImage(const DecodedImage& image);
+		void UploadMesh(const MeshData& data, Mesh& mesh);
+		void UploadToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize offset);	// Through the upload batcher's staging ring, into device local memory.
+		bool WriteImage(const uint8_t* data, VkImage image, const std::vector<MipLevel>& levels);	// With host image copy, straight into the image, leaving it ready for shaders. False if unavailable.
+	};
+}
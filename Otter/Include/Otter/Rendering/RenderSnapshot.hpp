@@ -0,0 +1,86 @@
+#pragma once
+#include "Otter/Rendering/GeometryArena.hpp"
+#include "glm/glm.hpp"
+#include "imgui.h"
+#include <cstring>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	struct RenderCamera
+	{
+		glm::mat4 view = glm::mat4(1.0f);
+		float fieldOfView = 45.0f;	// Vertical, in degrees. The projection is built from this when recording, with the swap chain's aspect ratio.
+		float nearPlane = 0.1f;
+		float farPlane = 10.0f;
+	};
+
+	struct DrawItem
+	{
+		glm::mat4 model = glm::mat4(1.0f);
+		MeshDraw mesh;
+		uint32_t textureIndex = 0;	// Into the device's texture table. Slot 0 is the placeholder.
+	};
+
+	/*
+		ImGui's draw data is only valid until the next ImGui::NewFrame, which the main thread may call while we're still recording.
+		This keeps a copy of the draw lists so the snapshot can be recorded on another thread. The copies persist across frames and
+		are written in place, their buffers only grow when the UI does, so steady state capturing doesn't allocate.
+	*/
+	struct ImGuiSnapshot
+	{
+		ImDrawData drawData;
+		std::vector<ImDrawList*> drawLists;	// The first drawData.CmdListsCount are this frame's.
+
+		ImGuiSnapshot() = default;
+		ImGuiSnapshot(const ImGuiSnapshot&) = delete;
+		ImGuiSnapshot& operator=(const ImGuiSnapshot&) = delete;
+		~ImGuiSnapshot() { Clear(); }
+
+		void Capture(const ImDrawData* source)
+		{
+			drawData.Clear();
+			if (source == nullptr || !source->Valid)
+				return;
+
+			drawData = *source;
+			while (drawLists.size() < static_cast<size_t>(source->CmdListsCount))
+				drawLists.push_back(IM_NEW(ImDrawList)(source->CmdLists[drawLists.size()]->_Data));
+			for (int i = 0; i < source->CmdListsCount; i++)
+			{
+				const ImDrawList* list = source->CmdLists[i];
+				CopyInto(list->CmdBuffer, drawLists[i]->CmdBuffer);
+				CopyInto(list->IdxBuffer, drawLists[i]->IdxBuffer);
+				CopyInto(list->VtxBuffer, drawLists[i]->VtxBuffer);
+				drawLists[i]->Flags = list->Flags;
+			}
+			drawData.CmdLists = drawLists.data();
+		}
+
+		void Clear()	// Frees the copies as well.
+		{
+			for (auto drawList : drawLists)
+				IM_DELETE(drawList);
+			drawLists.clear();
+			drawData.Clear();
+		}
+
+	private:
+		template<typename T>
+		static void CopyInto(const ImVector<T>& source, ImVector<T>& destination)
+		{
+			destination.resize(source.Size);	// Keeps the capacity when shrinking.
+			if (source.Size > 0)
+				std::memcpy(destination.Data, source.Data, source.size_in_bytes());
+		}
+	};
+
+	// Everything a renderer needs to draw one frame, written by the main thread and read (only) by whoever records the frame.
+	struct RenderSnapshot
+	{
+		float deltaTime = 0.0f;
+		RenderCamera camera;
+		std::vector<DrawItem> draws;
+		ImGuiSnapshot imGui;
+	};
+}
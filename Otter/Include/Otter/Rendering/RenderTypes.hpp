@@ -0,0 +1,210 @@
+#pragma once
+#include "Otter/Core/Types.hpp"
+#include "vulkan/vulkan.h"
+#include "glm/glm.hpp"
+#include "loguru.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	static const std::vector<const char*> requiredValidationLayers = {
+		"VK_LAYER_KHRONOS_validation"
+	};
+
+	#ifdef NDEBUG
+	const bool enableValidationLayers = false;
+	#else
+	const bool enableValidationLayers = true;
+	#endif
+
+	// Configured from CMake (OTTER_MAX_FRAMES_IN_FLIGHT, default in Types.hpp), so benchmarks can compare values without editing code.
+	static const int MAX_FRAMES_IN_FLIGHT = OTTER_MAX_FRAMES_IN_FLIGHT;
+	static const std::vector<const char*> requiredPhysicalDeviceExtensions =
+	{
+		VK_KHR_SWAPCHAIN_EXTENSION_NAME
+	};
+
+	inline void check_vk_result(VkResult err)
+	{
+		if (err == 0)
+			return;
+
+		LOG_F(ERROR, "[vulkan] Error: VkResult = %d\n", err);
+
+		if (err < 0)
+			abort();
+	}
+
+	struct QueueFamilyIndices
+	{
+		//std::optional can query var.has_value() to see if its been modified i.e. if the queue family exists. This because 0 can be a valid queue family index.
+		std::optional<uint32_t> graphicsFamily;
+		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily;	// Transfer-only if the GPU has such a family (a DMA engine), the graphics family otherwise.
+
+		inline bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
+	};
+
+	struct Vertex {
+		glm::vec3 pos;
+		glm::vec3 color;
+		glm::vec2 texCoord;
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(Vertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(Vertex, pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(Vertex, color);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
+	/*
+		Half the size of Vertex, for when vertex memory and bandwidth matter more than precision.
+		Positions are 16 bit snorm within the mesh's bounds, the mesh's vertexTransform scales them back. 1/65536th of the mesh's size is
+		still well under a millimeter for anything smaller than a building. Colors are 8 bit unorm, UVs half floats so they can still tile.
+		The shaders see the same vec3/vec3/vec2 inputs as with Vertex.
+	*/
+	struct QuantizedVertex {
+		int16_t pos[4];		// w is unused, three 16 bit components aren't a format every GPU can fetch.
+		uint8_t color[4];
+		uint16_t texCoord[2];
+
+		static VkVertexInputBindingDescription getBindingDescription() {
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = 0;
+			bindingDescription.stride = sizeof(QuantizedVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+			attributeDescriptions[0].binding = 0;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+			attributeDescriptions[0].offset = offsetof(QuantizedVertex, pos);
+
+			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[1].offset = offsetof(QuantizedVertex, color);
+
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[2].offset = offsetof(QuantizedVertex, texCoord);
+
+			return attributeDescriptions;
+		}
+	};
+
+	// The layout meshes are stored in on the GPU. Import always works on Vertex, MeshOptimizer::QuantizeVertex converts.
+	#ifdef OTTER_QUANTIZE_VERTICES
+	using GpuVertex = QuantizedVertex;
+	#else
+	using GpuVertex = Vertex;
+	#endif
+
+	struct Bounds
+	{
+		glm::vec3 min = glm::vec3(0.0f);
+		glm::vec3 max = glm::vec3(0.0f);
+	};
+
+	// Where one mip level of an image sits in a block of texel data.
+	struct MipLevel
+	{
+		size_t offset = 0;	// In bytes.
+		Vec2D size = {0, 0};
+	};
+
+	inline uint32_t GetMipLevelCount(Vec2D size)	// Of a full chain, down to 1x1.
+	{
+		uint32_t levels = 1;
+		for (int extent = std::max(size.x, size.y); extent > 1; extent /= 2)
+			levels++;
+		return levels;
+	}
+
+	inline Vec2D GetMipLevelSize(Vec2D size, uint32_t level)
+	{
+		return { std::max(size.x >> level, 1), std::max(size.y >> level, 1) };
+	}
+
+	inline bool IsBlockCompressed(VkFormat format)	// In 4x4 texel blocks.
+	{
+		return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	// Of a texel, or of a 4x4 block for block compressed formats. 0 for formats textures don't come in.
+	inline uint32_t GetTexelBlockBytes(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return 4;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	inline size_t GetImageBytes(VkFormat format, Vec2D size)	// Of one mip level.
+	{
+		if (IsBlockCompressed(format))
+			return static_cast<size_t>((size.x + 3) / 4) * ((size.y + 3) / 4) * GetTexelBlockBytes(format);
+		return static_cast<size_t>(size.x) * size.y * GetTexelBlockBytes(format);
+	}
+
+	struct UniformBufferObject {
+		alignas(16) glm::mat4 view;
+		alignas(16) glm::mat4 proj;
+	};
+
+	// Per draw data, small enough to push instead of going through a descriptor.
+	struct ObjectPushConstants {
+		alignas(16) glm::mat4 model;
+		uint32_t textureIndex;	// Into the device's texture table, see RenderDevice::GetTextureTable.
+	};
+}
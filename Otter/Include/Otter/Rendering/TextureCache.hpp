@@ -0,0 +1,31 @@
+#pragma once
+#include "Otter/Rendering/Ktx2.hpp"
+#include "Otter/Utilities/MappedFile.hpp"
+#include <filesystem>
+#include <string>
+
+namespace Otter::Rendering
+{
+	/*
+		Decoded textures: PNG/JPEG decoded to RGBA8 with their mip chain generated, written to disk so warm starts skip stb entirely.
+		Like cooked meshes (see MeshCache) and compiled shaders, files are named after the source image's content hash, mixed with the
+		cache version. They live in CachedTextures/ as uncompressed KTX2 (see Ktx2), which is memory mapped and copied straight from
+		the mapping into the staging ring.
+		Textures cooked offline next to their source don't go through here, they're loaded as they are.
+	*/
+	class TextureCache
+	{
+	public:
+		static constexpr uint32_t VERSION = 1;	// Bump when the decoding or the mip filter changes.
+
+		static std::string GetKey(const MappedFile& source);
+		static bool Load(const std::string& key, DecodedImage& image);	// False if there is no valid cached texture for the key.
+		static bool Store(const std::string& key, const DecodedImage& image);
+
+		// Appends the rest of the chain to an RGBA8 image that has only its first level. With srgb, color is filtered in linear space.
+		static void GenerateMips(DecodedImage& image, bool srgb);
+
+	private:
+		static std::filesystem::path GetPath(const std::string& key);
+	};
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "Otter/Rendering/RenderTypes.hpp"
+#include "vulkan/vulkan.h"
+#include "vk_mem_alloc.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	/*
+		Records uploads into one command buffer and submits them together, instead of a submit and a queue wait per copy.
+		Source data is copied into a persistently mapped staging ring. A submitted batch signals its value on a timeline semaphore,
+		after which its part of the ring and its command buffer are reused. The CPU only waits when the ring is full.
+		Uploads bigger than the whole ring get a staging buffer of their own, freed with their batch.
+		Mip levels the data doesn't have are generated with linear blits. Transfer-only queues can't blit, so with one of those a
+		SetBlitQueue submit follows the copies, waiting on them through the same semaphore.
+		Readers don't wait on the CPU either: their submits wait on GetSemaphore at the value Flush returned.
+		Nothing is visible to the GPU before Flush, so flush before submitting work that reads the uploads.
+		Thread safe.
+	*/
+	class UploadBatcher
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_RING_BYTES = 64ull * 1024 * 1024;
+
+		// On a transfer-only family the destination resources must be shared concurrently with the families that read them.
+		void Create(VkDevice device, VmaAllocator allocator, uint32_t queueFamily, VkQueue queue, std::mutex& queueMutex, VkDeviceSize ringBytes = DEFAULT_RING_BYTES);
+		void SetBlitQueue(uint32_t queueFamily, VkQueue queue, std::mutex& queueMutex);	// Only needed if the upload queue can't blit.
+		void Destroy();	// Waits for everything submitted.
+
+		void CopyToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize offset);
+		// Copies levels out of data, then blits each following level from the one before, down to mipLevels. The format must
+		// support linear blits if that's more than levels has. Leaves the image in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+		void CopyToImage(const void* data, VkDeviceSize size, VkImage image, const std::vector<MipLevel>& levels, uint32_t mipLevels);
+
+		uint64_t Flush();	// Submits what was recorded since the last flush. Returns the value that signals once all uploads so far are done.
+		void Wait(uint64_t value);
+		inline VkSemaphore GetSemaphore() const { return semaphore; }
+		inline uint64_t GetBatchCount() const { return batchCount; }	// Submitted so far.
+		inline uint64_t GetStallCount() const { return stallCount; }	// Times the CPU had to wait for the ring to drain.
+
+	private:
+		struct Batch
+		{
+			uint64_t value = 0;					// Signalled on the timeline once the GPU is done with it.
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer blitCommandBuffer = VK_NULL_HANDLE;	// On the blit queue, if there is a separate one.
+			VkDeviceSize ringBytes = 0;			// Taken from the ring, including what was skipped when wrapping around.
+			std::vector<std::pair<VkBuffer, VmaAllocation>> ownBuffers;	// For uploads that didn't fit the ring.
+		};
+
+		VkDevice device = VK_NULL_HANDLE;
+		VmaAllocator allocator = VK_NULL_HANDLE;
+		VkQueue queue = VK_NULL_HANDLE;
+		std::mutex* queueMutex = nullptr;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		VkQueue blitQueue = VK_NULL_HANDLE;
+		std::mutex* blitQueueMutex = nullptr;
+		VkCommandPool blitCommandPool = VK_NULL_HANDLE;
+
+		VkBuffer ring = VK_NULL_HANDLE;
+		VmaAllocation ringAllocation = VK_NULL_HANDLE;
+		uint8_t* ringData = nullptr;
+		VkDeviceSize ringSize = 0;
+		VkDeviceSize ringHead = 0;		// Where the next upload goes.
+		VkDeviceSize ringUsed = 0;		// By the recording batch and the ones in flight.
+
+		std::mutex mutex;
+		Batch recording;				// commandBuffer is null until something is recorded.
+		std::deque<Batch> inFlight;		// Oldest first.
+		std::vector<VkCommandBuffer> freeCommandBuffers;
+		std::vector<VkCommandBuffer> freeBlitCommandBuffers;
+		uint64_t submittedValue = 0;
+		bool lastSubmitBlitted = false;	// The next copies wait for it, so values are signalled in order.
+		std::atomic<uint64_t> batchCount = 0;
+		std::atomic<uint64_t> stallCount = 0;
+
+		VkCommandBuffer GetCommandBuffer();
+		VkCommandBuffer GetBlitCommandBuffer();	// The copy command buffer, unless there's a separate blit queue.
+		VkCommandBuffer BeginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+		VkDeviceSize Stage(const void* data, VkDeviceSize size, VkBuffer& source);	// Returns the offset of the copy in source.
+		uint64_t Submit();
+		void SubmitCommandBuffer(VkQueue queue, std::mutex& queueMutex, VkCommandBuffer commandBuffer, uint64_t waitValue, uint64_t signalValue);	// No wait if waitValue is 0.
+		void Retire(bool wait);		// Recycles finished batches. With wait, blocks until at least the oldest one is.
+	};
+}
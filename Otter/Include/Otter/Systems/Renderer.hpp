@@ -1,106 +1,47 @@
 #pragma once
 #include "Otter/Core/System.hpp"
 #include "Otter/Core/Types.hpp"
+#include "Otter/Core/TripleBuffer.hpp"
+#include "Otter/Rendering/AssetManager.hpp"
+#include "Otter/Rendering/GpuProfiler.hpp"
+#include "Otter/Rendering/RenderDevice.hpp"
+#include "Otter/Rendering/RenderSnapshot.hpp"
 #include "vulkan/vulkan.hpp"
 #include "SDL.h"
 #include "glm/glm.hpp"
 #include "imgui_impl_vulkan.h"
 #include "vk_mem_alloc.h"
-#include <optional>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace Otter::Systems
 {
-	static const std::vector<const char*> requiredValidationLayers = {
-		"VK_LAYER_KHRONOS_validation"
-	};	
-
-	#ifdef NDEBUG
-	const bool enableValidationLayers = false;
-	#else
-	const bool enableValidationLayers = true;
-	#endif
-
-	static const int MAX_FRAMES_IN_FLIGHT = 2;
-	static const std::vector<const char*> requiredPhysicalDeviceExtensions =
-	{
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME
-	};
-
-	struct QueueFamilyIndices
-	{
-		//std::optional can query var.has_value() to see if its been modified i.e. if the queue family exists. This because 0 can be a valid queue family index.
-		std::optional<uint32_t> graphicsFamily;
-		std::optional<uint32_t> presentFamily;
-
-		inline bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
-	};
-
 	struct SwapChainSupportDetails {
 		VkSurfaceCapabilitiesKHR capabilities;
 		std::vector<VkSurfaceFormatKHR> formats;
 		std::vector<VkPresentModeKHR> presentModes;
 	};	
 
-	struct Vertex {
-		glm::vec3 pos;
-		glm::vec3 color;
-		glm::vec2 texCoord;
-
-		static VkVertexInputBindingDescription getBindingDescription() {
-			VkVertexInputBindingDescription bindingDescription{};
-			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-			return bindingDescription;
-		}
-
-		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-
-			attributeDescriptions[0].binding = 0;
-			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-			attributeDescriptions[1].binding = 0;
-			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-			attributeDescriptions[2].binding = 0;
-			attributeDescriptions[2].location = 2;
-			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-			attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
-
-			return attributeDescriptions;
-		}
-	};
-
-	struct UniformBufferObject {
-		alignas(16) glm::mat4 model;
-		alignas(16) glm::mat4 view;
-		alignas(16) glm::mat4 proj;
-	};
-
-	// Temporary mesh data.
-	const std::vector<Vertex> vertices = {
-		{{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-		{{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-		{{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-		{{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}},
-
-		{{-0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-		{{0.5f, -0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-		{{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-		{{-0.5f, 0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
-	};
-
-	const std::vector<uint16_t> indices = {
-		0, 1, 2, 2, 3, 0,
-		4, 5, 6, 6, 7, 4
+	// Totals since the renderer started, diff two readings to get the numbers of a range of frames.
+	struct RenderStats
+	{
+		uint64_t renderedFrames = 0;
+		uint64_t skippedFrames = 0;
+		uint64_t drawCalls = 0;		// Scene and ImGui.
+		uint64_t triangles = 0;
 	};
 
+	/*
+		Draws the entities of a window.
+		OnTick runs on the main thread and only captures a RenderSnapshot (draw list, camera, ImGui output).
+		Recording, submitting and presenting happen in DrawFrame, either right after on the main thread,
+		or on a dedicated render thread (SetRenderThreadEnabled) so the next frame's simulation overlaps with this frame's rendering.
+		Headless renderers (SetHeadless) draw into offscreen images instead of a window's swap chain, and can write frames to disk.
+	*/
 	class Event;
 	class Renderer : public System
 	{
@@ -109,142 +50,134 @@ namespace Otter::Systems
 		virtual void OnStop();
 		virtual void OnTick(float deltaTime);
 		virtual void OnSDLEvent(SDL_Event* event);
+		virtual const char* GetName() const { return "Renderer"; }
 
 		inline void InvalidateFramebuffer() { framebufferResized = true; }
 		inline void SetImGuiAllowed() { imGuiAllowed = true; }
 		inline void SetWindowHandle(SDL_Window* windowHandle) { this->handle = windowHandle; }
+		inline void SetTitle(const std::string& title) { this->title = title; }
+		inline void SetHeadless(Vec2D size) { headless = true; headlessSize = size; }	// Must be called before OnStart.
+		inline bool IsHeadless() const { return headless; }
 		inline void SetFrameBufferResizedCallback(std::function<void(glm::vec2)> onFramebufferResized) { this->onFramebufferResized = onFramebufferResized; }
 		inline void SetDrawImGuiCallback(std::function<void()> onDrawImGui) { this->onDrawImGui = onDrawImGui; }
+		inline void SetRenderDevice(std::shared_ptr<Rendering::RenderDevice> device) { this->device = device; }
+		inline void SetRenderThreadEnabled(bool enabled) { renderThreadEnabled = enabled; }	// Must be called before OnStart.
+		inline void SetPresentMode(VkPresentModeKHR mode) { preferredPresentMode = mode; framebufferResized = true; }	// Used if the surface supports it, otherwise FIFO. Recreates the swap chain.
+		inline uint64_t GetSkippedFrameCount() const { return skippedFrameCount; }
+		RenderStats GetRenderStats() const;
+		inline const Rendering::GpuProfiler& GetGpuProfiler() const { return gpuProfiler; }
+		void CaptureFrame(const std::string& path);	// Writes the next rendered frame to a PNG once the GPU finished it. Headless only.
 
 	private:
 		bool imGuiAllowed = false;
 		bool initialized = false;
-		float deltaTime = 0;
-		UniformBufferObject quad{};
+		Rendering::RenderCamera camera;
+		glm::mat4 spin = glm::mat4(1.0f);	// Temporary animation applied to every draw.
 		std::function<void(glm::vec2)> onFramebufferResized;
 		std::function<void()> onDrawImGui;
 
 		SDL_Window* handle = nullptr;
-		VkInstance vulkanInstance = VK_NULL_HANDLE;
-		VkDebugUtilsMessengerEXT debugMessenger;
+		std::string title;
+		bool headless = false;
+		Vec2D headlessSize = {0, 0};
+		std::shared_ptr<Rendering::RenderDevice> device;
+		VkDevice logicalDevice = VK_NULL_HANDLE;	// Cached from the device, as it's used everywhere.
+		VmaAllocator allocator = VK_NULL_HANDLE;
 		VkSurfaceKHR surface = VK_NULL_HANDLE;
 
-		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-		VkDevice logicalDevice = VK_NULL_HANDLE;
-
-		VkQueue graphicsQueue = VK_NULL_HANDLE;
-		VkQueue presentQueue = VK_NULL_HANDLE;
-
-		VkShaderModule vert = VK_NULL_HANDLE;
-		VkShaderModule frag = VK_NULL_HANDLE;
-
-		VkSwapchainKHR swapChain;
+		VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+		SwapChainSupportDetails swapChainSupportDetails;	// Reused by FindSwapChainSupport.
+		std::atomic<VkPresentModeKHR> preferredPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
 		std::vector<VkImage> swapChainImages;
+		std::vector<VmaAllocation> offscreenImageAllocations;	// Headless only, the swap chain owns its own images.
 		VkFormat swapChainImageFormat;
 		VkExtent2D swapChainExtent;
 		std::vector<VkImageView> swapChainImageViews;
 
-		VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
-		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkRenderPass renderPass = VK_NULL_HANDLE;			// Owned by the device.
+		VkPipeline graphicsPipeline = VK_NULL_HANDLE;		// Owned by the device.
+		Rendering::ShaderHandle defaultShader;			// Held so the assets the renderer draws with are never evicted.
+		Rendering::TextureHandle defaultTexture;
 		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
 		VkDescriptorPool imguiDescriptorPool = VK_NULL_HANDLE;
 		std::vector<VkDescriptorSet> descriptorSets;
-		VkPipeline graphicsPipeline = VK_NULL_HANDLE;
 		
-		bool framebufferResized;
+		std::atomic<bool> framebufferResized = false;
+		std::atomic<bool> swapChainRecreated = false;	// Set by the recording thread, the resize callback is fired from OnTick.
 		std::vector<VkFramebuffer> swapChainFramebuffers;
 		VkCommandPool commandPool = VK_NULL_HANDLE;
 		std::vector<VkCommandBuffer> commandBuffers;
 
-		//std::vector<Vertex> vertices;
-		//std::vector<uint32_t> indices;
-		VmaAllocator allocator = VK_NULL_HANDLE;
-		VkBuffer vertexBuffer = VK_NULL_HANDLE;
-		VmaAllocation vertexBufferAllocation = VK_NULL_HANDLE;
-		VkBuffer indexBuffer = VK_NULL_HANDLE;
-		VmaAllocation indexBufferAllocation = VK_NULL_HANDLE;
 		std::vector<VkBuffer> uniformBuffers;
 		std::vector<VmaAllocation> uniformBufferAllocations;
 
-		VkImage textureImage = VK_NULL_HANDLE;
-		VmaAllocation textureImageMemory = VK_NULL_HANDLE;
-		VkImageView textureImageView = VK_NULL_HANDLE;
-		VkSampler textureSampler = VK_NULL_HANDLE;
-
 		VkImage depthImage = VK_NULL_HANDLE;
 		VmaAllocation depthImageMemory = VK_NULL_HANDLE;
 		VkImageView depthImageView = VK_NULL_HANDLE;
 
+		// Headless captures: one host readable buffer per frame in flight, written out once that frame's fence signals.
+		struct FrameReadback
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VmaAllocation allocation = VK_NULL_HANDLE;
+			std::string path;	// Empty if this frame isn't captured.
+		};
+		std::vector<FrameReadback> readbacks;
+		std::mutex captureMutex;
+		std::string requestedCapture;
+
 		std::vector<VkSemaphore> imageAvailableSemaphores;
 		std::vector<VkSemaphore> renderFinishedSemaphores;
 		std::vector<VkFence> inFlightFences;
 		uint32_t currentFrame = 0;
 		const int minImageCount = 2;
-		int imageCount = 2;	// FIXME look at example in imgui where this comes from...
-
-
-		bool CreateVulkanInstance();
-		VkResult CreateDebugUtilsMessengerEXT(VkInstance vulkanInstance, const VkDebugUtilsMessengerCreateInfoEXT* createInfo, const VkAllocationCallbacks* allocator, VkDebugUtilsMessengerEXT* debugMessenger);
-		void DestroyDebugUtilsMessengerEXT(VkInstance vulkanInstance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* allocator);
-		bool CheckValidationLayerSupport();
-		std::vector<const char*> GetRequiredExtensions();
-		void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
-		void SetupDebugMessenger();
-
-		void CreateSurface();
-
-		void SelectPhysicalDevice();	// Picks a GPU to run Vulkan on.
-		bool IsPhysicalDeviceSuitable(VkPhysicalDevice gpu);
-		bool HasDeviceExtensionSupport(VkPhysicalDevice gpu);
-		QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice gpu);		// Everything in VK works with queues, we want to query what the GPU can do.
-
-		void CreateLogicalDevice();
+		const int imageCount = std::max(Rendering::MAX_FRAMES_IN_FLIGHT, minImageCount);	// ImGui rotates its vertex and index buffers over this, one per frame in flight.
+
+		TripleBuffer<Rendering::RenderSnapshot> snapshots;
+		bool renderThreadEnabled = false;
+		std::atomic<uint64_t> skippedFrameCount = 0;
+		std::atomic<uint64_t> renderedFrameCount = 0;
+		std::atomic<uint64_t> drawCallCount = 0;
+		std::atomic<uint64_t> triangleCount = 0;
+		Rendering::GpuProfiler gpuProfiler;
+		std::thread renderThread;
+		std::atomic<bool> renderThreadRunning = false;
+		std::mutex snapshotMutex;
+		std::condition_variable snapshotAvailable;
+		bool snapshotPending = false;
 
 		void CreateSwapChain();
 		void DestroySwapChain();	// Also destroys things reliant on the swap chain, like the framebuffer.
 		void RecreateSwapChain();
-		SwapChainSupportDetails FindSwapChainSupport(VkPhysicalDevice gpu);
+		const SwapChainSupportDetails& FindSwapChainSupport(VkPhysicalDevice gpu);	// Valid until the next call.
 		VkSurfaceFormatKHR SelectSwapChainSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR SelectSwapChainPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 		VkExtent2D SelectSwapChainExtent(const VkSurfaceCapabilitiesKHR& capabilities); // Return the canvas size in actual pixels, not in screen coordinates.
-		VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
 		void CreateImageViews();
+		void CreateOffscreenTargets();	// Headless replacement of CreateSwapChain.
+		void WriteCapture(FrameReadback& readback);
 
-		void LoadMeshes();
-
-		void CreateRenderPass();
-		void CreateDescriptorSetLayout();
-		void CreateGraphicsPipeline();
+		void StreamMeshes();
 		void CreateFrameBuffers();
-
-		void CreateVertexBuffer();
-		void CreateIndexBuffer();
 		void CreateUniformBuffers();
-		void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);	// Record and execute a command buffer to copy from a staging buffer to destination.
-		VkCommandBuffer BeginSingleTimeCommands();
-		void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 
 		void CreateDescriptorPool();
 		void CreateDescriptorSets();
 
 		void CreateCommandPool();
 		void CreateCommandBuffer();
-		void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, Rendering::RenderSnapshot& snapshot);
 
 		void CreateDepthResources();
-		VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-		VkFormat FindDepthFormat();
-
-		void CreateTextureImage();
-		void CreateImage(Vec2D size, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkImage& image, VmaAllocation& imageMemory);
- 		void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-		void CopyBufferToImage(VkBuffer buffer, VkImage image, Vec2D size);
-		void CreateTextureSampler();
 
 		void CreateSyncObjects();
-		void DrawFrame();
-		void UpdateUniformBuffer(uint32_t currentImage);
+		void BuildSnapshot(float deltaTime);
+		bool DrawFrame(Rendering::RenderSnapshot& snapshot);	// False if the frame was skipped because the GPU or swap chain wasn't ready.
+		void UpdateUniformBuffer(uint32_t currentImage, const Rendering::RenderSnapshot& snapshot);
+
+		void StartRenderThread();
+		void StopRenderThread();
+		void RenderThreadMain();
 
 		void SetupImGui();
 	};
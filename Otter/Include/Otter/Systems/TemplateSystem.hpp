@@ -10,5 +10,6 @@ namespace Otter::Systems
 		virtual void OnStart();
 		virtual void OnStop();
 		virtual void OnTick(float deltaTime);
+		virtual const char* GetName() const { return "TemplateSystem"; }
 	};
 }
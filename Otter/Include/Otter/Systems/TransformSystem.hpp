@@ -0,0 +1,26 @@
+#pragma once
+#include "Otter/Core/System.hpp"
+#include "glm/mat4x4.hpp"
+#include <vector>
+
+namespace Otter::Systems
+{
+	/*
+		Computes the world matrix of every Transform from its local values and its parent's world matrix.
+		Ticks before the renderer, so what's drawn is never a frame behind what the other systems set.
+	*/
+	class TransformSystem : public System
+	{
+	public:
+		virtual void OnStart();
+		virtual void OnStop();
+		virtual void OnTick(float deltaTime);
+		virtual const char* GetName() const { return "TransformSystem"; }
+
+	private:
+		uint64_t tick = 0;
+		std::vector<uint64_t> updatedTick;	// Per entity, the tick its world matrix was last computed in.
+
+		const glm::mat4& UpdateWorld(Entity entity);
+	};
+}
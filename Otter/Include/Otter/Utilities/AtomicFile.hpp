@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace Otter
+{
+	// A piece of a file to write. Gaps between chunks are filled with zeros, so offsets can be aligned.
+	struct FileChunk
+	{
+		uint64_t offset;	// From the start of the file, at or after the end of the previous chunk.
+		const void* data;
+		size_t size;
+	};
+
+	/*
+		Writes the chunks to a temporary file next to path, named after the process and thread, flushes it to disk and renames it
+		over path. Readers, like the caches that map these files back in, see the old file or all of the new one, also after a crash.
+		Writers of the same path don't share a temporary file, the last one to finish wins. False (and logged) if anything failed.
+	*/
+	bool WriteFileAtomically(const std::filesystem::path& path, const std::vector<FileChunk>& chunks);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Otter
+{
+	/*
+		Options given to the executable as "--name value" or "--name=value". An option without a value ("--headless") is a flag.
+		Anything not starting with "--" that doesn't belong to an option ends up in the positional arguments.
+	*/
+	class CommandLine
+	{
+	public:
+		CommandLine() {}
+		CommandLine(int argc, char* argv[]);
+
+		bool Has(const std::string& name) const;
+		std::string GetString(const std::string& name, const std::string& fallback = "") const;
+		int GetInt(const std::string& name, int fallback = 0) const;		// Fallback if the option is missing or not a number.
+		float GetFloat(const std::string& name, float fallback = 0.0f) const;
+		inline const std::vector<std::string>& GetPositional() const { return positional; }
+
+	private:
+		std::unordered_map<std::string, std::string> options;
+		std::vector<std::string> positional;
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace Otter
+{
+	/*
+		A file mapped read-only into memory. Pages are read in by the OS as they're touched, so copying straight out of the mapping
+		(into a staging buffer, say) skips the intermediate read buffer.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		bool Open(const std::filesystem::path& path);	// False if the file is missing, empty or can't be mapped.
+		void Close();
+
+		inline bool IsOpen() const { return data != nullptr; }
+		inline const uint8_t* GetData() const { return data; }
+		inline size_t GetSize() const { return size; }
+
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	#ifdef _WIN32
+		void* mapping = nullptr;	// HANDLE of the file mapping object.
+	#endif
+	};
+}
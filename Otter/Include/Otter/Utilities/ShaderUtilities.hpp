@@ -12,6 +12,7 @@ namespace Otter
 	public:
 		static bool LoadShaderCode(std::string path, std::vector<uint32_t>& result);
 		static VkShaderModule LoadShaderModule(std::string path, VkDevice logicalDevice); // Loads a new shader as a vulkan module for a logical device. Call vkDestroyShaderModule after use.
+		static VkShaderModule CreateShaderModule(const std::vector<uint32_t>& shaderCode, std::string path, VkDevice logicalDevice); // Same, for code already loaded with LoadShaderCode.
 
 	private:
 		static std::vector<uint32_t> CompileShaderToSPIRV_Vulkan(const glslang_stage_t stage, const char* shaderSource, const char* fileName);
@@ -0,0 +1,252 @@
+#include "Otter/Core/AllocationTracker.hpp"
+#include "imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace Otter
+{
+	static std::atomic<uint64_t> totalAllocations = 0;
+	static std::atomic<uint64_t> totalFrees = 0;
+	static std::atomic<uint64_t> totalBytes = 0;
+	static thread_local AllocationCounts threadCounts;	// Trivial, so touching it from operator new can't allocate itself.
+
+	static void CountAllocation(size_t size)
+	{
+		totalAllocations.fetch_add(1, std::memory_order_relaxed);
+		totalBytes.fetch_add(size, std::memory_order_relaxed);
+		threadCounts.allocations++;
+		threadCounts.bytes += size;
+	}
+
+	static void CountFree()
+	{
+		totalFrees.fetch_add(1, std::memory_order_relaxed);
+		threadCounts.frees++;
+	}
+
+	AllocationTracker& AllocationTracker::Get()
+	{
+		static AllocationTracker tracker;
+		return tracker;
+	}
+
+	AllocationCounts AllocationTracker::GetTotalCounts()
+	{
+		return { totalAllocations.load(std::memory_order_relaxed), totalFrees.load(std::memory_order_relaxed), totalBytes.load(std::memory_order_relaxed) };
+	}
+
+	AllocationCounts AllocationTracker::GetThreadCounts()
+	{
+		return threadCounts;
+	}
+
+	void AllocationTracker::BeginFrame()
+	{
+		AllocationCounts now = GetTotalCounts();
+		if (frameCount > 0)
+			lastFrame = now - frameStart;
+		frameStart = now;
+		frameCount++;
+
+		std::lock_guard<std::mutex> lock(scopesMutex);
+		for (size_t i = 0; i < scopeCount; i++)
+		{
+			scopes[i].last = scopes[i].current;
+			scopes[i].current = {};
+		}
+	}
+
+	void AllocationTracker::RecordScope(const char* name, const AllocationCounts& counts)
+	{
+		std::lock_guard<std::mutex> lock(scopesMutex);
+		for (size_t i = 0; i < scopeCount; i++)
+		{
+			if (scopes[i].name == name || std::strcmp(scopes[i].name, name) == 0)
+			{
+				scopes[i].current += counts;
+				return;
+			}
+		}
+
+		// Full table: drop it rather than allocate from inside the tracker.
+		if (scopeCount == MAX_SCOPES)
+			return;
+
+		scopes[scopeCount].name = name;
+		scopes[scopeCount].current = counts;
+		scopeCount++;
+	}
+
+	size_t AllocationTracker::GetScopes(std::array<ScopeCounts, MAX_SCOPES>& scopes) const
+	{
+		std::lock_guard<std::mutex> lock(scopesMutex);
+		std::copy(this->scopes.begin(), this->scopes.begin() + scopeCount, scopes.begin());
+		return scopeCount;
+	}
+
+	void AllocationTracker::DrawImGui() const
+	{
+		if (!ImGui::Begin("Allocations"))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!IsEnabled())
+		{
+			ImGui::Text("Build with the OTTER_TRACK_ALLOCATIONS CMake option to count allocations.");
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Text("Last frame: %llu allocations, %llu frees, %llu bytes", (unsigned long long)lastFrame.allocations, (unsigned long long)lastFrame.frees, (unsigned long long)lastFrame.bytes);
+
+		std::array<ScopeCounts, MAX_SCOPES> copy;
+		size_t count = GetScopes(copy);
+		if (ImGui::BeginTable("Scopes", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Scope");
+			ImGui::TableSetupColumn("Allocations");
+			ImGui::TableSetupColumn("Frees");
+			ImGui::TableSetupColumn("Bytes");
+			ImGui::TableHeadersRow();
+
+			for (size_t i = 0; i < count; i++)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", copy[i].name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)copy[i].last.allocations);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)copy[i].last.frees);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)copy[i].last.bytes);
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
+#ifdef OTTER_TRACK_ALLOCATIONS
+	static void* TrackedAllocate(size_t size)
+	{
+		void* pointer = std::malloc(size != 0 ? size : 1);
+		if (pointer != nullptr)
+			CountAllocation(size);
+		return pointer;
+	}
+
+	static void* TrackedAllocateAligned(size_t size, size_t alignment)
+	{
+		size = size != 0 ? size : 1;
+	#ifdef _WIN32
+		void* pointer = _aligned_malloc(size, alignment);
+	#else
+		void* pointer = nullptr;
+		if (posix_memalign(&pointer, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) != 0)
+			pointer = nullptr;
+	#endif
+		if (pointer != nullptr)
+			CountAllocation(size);
+		return pointer;
+	}
+
+	static void TrackedFree(void* pointer)
+	{
+		if (pointer == nullptr)
+			return;
+
+		CountFree();
+		std::free(pointer);
+	}
+
+	static void TrackedFreeAligned(void* pointer)
+	{
+		if (pointer == nullptr)
+			return;
+
+		CountFree();
+	#ifdef _WIN32
+		_aligned_free(pointer);
+	#else
+		std::free(pointer);
+	#endif
+	}
+#endif
+
+	void AllocationTracker::InstallImGuiAllocator()
+	{
+	#ifdef OTTER_TRACK_ALLOCATIONS
+		ImGui::SetAllocatorFunctions(
+			[](size_t size, void*) { return TrackedAllocate(size); },
+			[](void* pointer, void*) { TrackedFree(pointer); });
+	#endif
+	}
+}
+
+#ifdef OTTER_TRACK_ALLOCATIONS
+// Replacements for every global operator new/delete, so nothing in the process slips past the counters.
+void* operator new(std::size_t size)
+{
+	void* pointer = Otter::TrackedAllocate(size);
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Otter::TrackedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Otter::TrackedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	void* pointer = Otter::TrackedAllocateAligned(size, static_cast<size_t>(alignment));
+	if (pointer == nullptr)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return Otter::TrackedAllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return Otter::TrackedAllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept { Otter::TrackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { Otter::TrackedFree(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { Otter::TrackedFree(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { Otter::TrackedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { Otter::TrackedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { Otter::TrackedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { Otter::TrackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { Otter::TrackedFreeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { Otter::TrackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { Otter::TrackedFreeAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { Otter::TrackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { Otter::TrackedFreeAligned(pointer); }
+#endif
@@ -1,4 +1,9 @@
 #include "Otter/Core/Application.hpp"
+#include "Otter/Core/AllocationTracker.hpp"
+#include "Otter/Core/FrameArena.hpp"
+#include "Otter/Core/Profiler.hpp"
+#include "Otter/Rendering/AssetManager.hpp"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <loguru.hpp>
@@ -7,6 +12,8 @@
 
 namespace Otter {
 
+	static const int IDLE_EVENT_TIMEOUT = 100;	// ms, how often OnTick still runs while every window is minimized or hidden.
+
 	Application::Application()
 	{
 		appName = "OtterApplication";
@@ -16,48 +23,77 @@ namespace Otter {
 	{
 	}
 
-	void Application::Run(int argc, char* argv[], char* envp[])
+	int Application::Run(int argc, char* argv[], char* envp[])
 	{
 		loguru::init(argc, argv);
 		loguru::add_file("otter.log", loguru::FileMode::Truncate, loguru::Verbosity_MAX);
+		commandLine = CommandLine(argc, argv);	// After loguru, which strips its own -v option.
 
-		SDL_Init(SDL_INIT_EVERYTHING);
+		// Without a display (CI, render servers) video fails to start; headless windows can still run on the rest.
+		if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+		{
+			LOG_F(WARNING, "SDL_Init failed (%s), continuing without video", SDL_GetError());
+			SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS);
+		}
 		glslang_initialize_process();
+		renderDevice = std::make_shared<Rendering::RenderDevice>(appName);
 		OnStart();
 
 		std::vector<std::shared_ptr<Otter::Window>> windowsToBeDestroyed;
 		float dt = 0.0f;
 		while (shouldTick)
 		{
+			OTTER_PROFILE_FRAME();
+			OTTER_ALLOCATION_FRAME();
+			FrameArenas::Get().BeginFrame();
 			auto startTime = std::chrono::high_resolution_clock::now();
 
-			SDL_Event event;
-			while (SDL_PollEvent(&event))
+			// With nothing to draw, sleep until the OS has something for us instead of spinning on the event queue.
+			bool idle = !windows.empty() && std::none_of(windows.begin(), windows.end(), [](const auto& window) { return window->IsActive(); });
+
 			{
-				switch(event.type)
+				OTTER_PROFILE_SCOPE("Application::PollEvents");
+				OTTER_ALLOCATION_SCOPE("Application::PollEvents");
+				SDL_Event event;
+				bool hasEvent = idle ? SDL_WaitEventTimeout(&event, IDLE_EVENT_TIMEOUT) : SDL_PollEvent(&event);
+				while (hasEvent)
 				{
-					case SDL_QUIT:
+					switch(event.type)
 					{
-						for(auto window : windows)
-							windowsToBeDestroyed.push_back(window);
-					}
-					case SDL_WINDOWEVENT:
-					{
-						for(auto window : windows)
-							if(window->GetWindowId() == event.window.windowID)
-								window->OnWindowEvent(&event.window);
-					}
-					default:
-					{
-						for(auto window : windows)
-							window->OnSDLEvent(&event);
+						case SDL_QUIT:
+						{
+							for(const auto& window : windows)
+								windowsToBeDestroyed.push_back(window);
+						}
+						case SDL_WINDOWEVENT:
+						{
+							for(const auto& window : windows)
+								if(window->GetWindowId() == event.window.windowID)
+									window->OnWindowEvent(&event.window);
+						}
+						default:
+						{
+							for(const auto& window : windows)
+								window->OnSDLEvent(&event);
+						}
 					}
+
+					hasEvent = SDL_PollEvent(&event);
 				}
 			}
 
-			OnTick(dt);
+			float tickDelta = fixedDeltaTime > 0.0f ? fixedDeltaTime : dt;
+			{
+				OTTER_PROFILE_SCOPE("Application::OnTick");
+				OTTER_ALLOCATION_SCOPE("Application::OnTick");
+				OnTick(tickDelta);
+			}
+
+			// Before the windows tick, so their renderers see this frame's uploads.
+			if (renderDevice->IsInitialized())
+				renderDevice->UpdateStreaming();
 
-			for(auto window : windows)
+			for(const auto& window : windows)
 			{
 				if (window->ShouldBeDestroyed())
 				{
@@ -65,25 +101,40 @@ namespace Otter {
 					continue;
 				}
 
-				window->OnTick(dt);
+				window->OnTick(tickDelta);
 			}
 			
-			for(auto window : windowsToBeDestroyed)
+			for(const auto& window : windowsToBeDestroyed)
 				DestroyWindow(window);
 			windowsToBeDestroyed.clear();
 
+			if (renderDevice->IsInitialized())
+			{
+				OTTER_PROFILE_SCOPE("AssetManager::Update");
+				Rendering::AssetManager::Get().Update(*renderDevice);
+				renderDevice->ReleaseUnloaded();
+			}
+
 			if (windows.empty())	// this causes the app to quit when the last window is closed.
 				shouldTick = false;
 
+			{
+				OTTER_PROFILE_SCOPE("FrameLimiter::WaitForNextFrame");
+				frameLimiter.WaitForNextFrame();
+			}
+
 			auto stopTime = std::chrono::high_resolution_clock::now();
 			dt = std::chrono::duration<float, std::chrono::seconds::period>(stopTime - startTime).count();
 		}
 
 		windows.clear();
+		renderDevice->Shutdown();
+		renderDevice.reset();
 
 		OnStop();
 		glslang_finalize_process();
 		SDL_Quit();
+		return exitCode;
 	}
 
 	bool Application::DestroyWindow(std::shared_ptr<Otter::Window> window)
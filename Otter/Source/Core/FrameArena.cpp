@@ -0,0 +1,201 @@
+#include "Otter/Core/FrameArena.hpp"
+#include "imgui.h"
+#include "loguru.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace Otter
+{
+	static uintptr_t AlignUp(uintptr_t address, size_t alignment)
+	{
+		return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+
+	LinearArena::LinearArena(size_t capacity)
+		: block(std::make_unique<std::byte[]>(capacity)), capacity(capacity)
+	{
+	}
+
+	void* LinearArena::Allocate(size_t size, size_t alignment)
+	{
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+		uintptr_t start = AlignUp(base + offset, alignment);
+		if (start + size <= base + capacity)
+		{
+			offset = start + size - base;
+			return reinterpret_cast<void*>(start);
+		}
+
+		// Doesn't fit. Rare after the first few frames, since Reset grows the block to what was needed.
+		overflow.push_back(std::make_unique<std::byte[]>(size + alignment - 1));
+		overflowBytes += size + alignment - 1;
+		overflowCount++;
+		return reinterpret_cast<void*>(AlignUp(reinterpret_cast<uintptr_t>(overflow.back().get()), alignment));
+	}
+
+	void LinearArena::Reset()
+	{
+		size_t used = GetUsedBytes();
+		peakBytes = std::max(peakBytes, used);
+
+		if (!overflow.empty())
+		{
+			size_t newCapacity = capacity;
+			while (newCapacity < used)
+				newCapacity *= 2;
+
+			overflow.clear();
+			block = std::make_unique<std::byte[]>(newCapacity);
+			capacity = newCapacity;
+		}
+
+		offset = 0;
+		overflowBytes = 0;
+	}
+
+	FrameArenas& FrameArenas::Get()
+	{
+		static FrameArenas arenas;
+		return arenas;
+	}
+
+	LinearArena& FrameArenas::GetArena()
+	{
+		return Get().GetCurrentSlot().arena;
+	}
+
+	std::pmr::memory_resource* FrameArenas::GetResource()
+	{
+		return &Get().GetCurrentSlot().resource;
+	}
+
+	FrameArenas::ThreadArenas& FrameArenas::GetThreadArenas()
+	{
+		// Hands the entry back when the thread exits, so short lived threads (a window's render thread) don't pile up arenas.
+		struct Owner
+		{
+			ThreadArenas* arenas = nullptr;
+			~Owner() { if (arenas != nullptr) arenas->inUse = false; }
+		};
+
+		thread_local Owner owner;
+		if (owner.arenas != nullptr)
+			return *owner.arenas;
+
+		// First allocation on this thread, the only time this takes a lock.
+		char threadName[64];
+		loguru::get_thread_name(threadName, sizeof(threadName), false);
+
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (const auto& arenas : threads)
+		{
+			bool expected = false;
+			if (arenas->inUse.compare_exchange_strong(expected, true))
+			{
+				for (auto& slot : arenas->slots)
+					slot.arena.Reset();
+				arenas->name = threadName;
+				arenas->frame = GetFrame();
+				owner.arenas = arenas.get();
+				return *owner.arenas;
+			}
+		}
+
+		threads.push_back(std::make_unique<ThreadArenas>());
+		owner.arenas = threads.back().get();
+		owner.arenas->name = threadName;
+		owner.arenas->frame = GetFrame();
+		owner.arenas->capacityBytes = LinearArena::DEFAULT_CAPACITY * OTTER_MAX_FRAMES_IN_FLIGHT;
+		return *owner.arenas;
+	}
+
+	FrameArenas::Slot& FrameArenas::GetCurrentSlot()
+	{
+		ThreadArenas& arenas = GetThreadArenas();
+		uint64_t currentFrame = GetFrame();
+		Slot& slot = arenas.slots[currentFrame % OTTER_MAX_FRAMES_IN_FLIGHT];
+		if (arenas.frame == currentFrame)
+			return slot;
+
+		// First allocation of a new frame on this thread. Whatever this slot holds is at least MAX_FRAMES_IN_FLIGHT frames old.
+		arenas.lastFrameBytes.store(arenas.slots[arenas.frame % OTTER_MAX_FRAMES_IN_FLIGHT].arena.GetUsedBytes(), std::memory_order_relaxed);
+		slot.arena.Reset();
+		arenas.frame = currentFrame;
+
+		size_t capacity = 0, peak = 0;
+		uint64_t overflows = 0;
+		for (const auto& s : arenas.slots)
+		{
+			capacity += s.arena.GetCapacity();
+			peak = std::max(peak, s.arena.GetPeakBytes());
+			overflows += s.arena.GetOverflowCount();
+		}
+		arenas.capacityBytes.store(capacity, std::memory_order_relaxed);
+		arenas.peakBytes.store(peak, std::memory_order_relaxed);
+		arenas.overflows.store(overflows, std::memory_order_relaxed);
+		return slot;
+	}
+
+	FrameArenaStats FrameArenas::GetStats() const
+	{
+		FrameArenaStats stats;
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (const auto& arenas : threads)
+		{
+			if (!arenas->inUse)
+				continue;
+
+			stats.threads++;
+			stats.lastFrameBytes += arenas->lastFrameBytes.load(std::memory_order_relaxed);
+			stats.capacityBytes += arenas->capacityBytes.load(std::memory_order_relaxed);
+			stats.peakBytes += arenas->peakBytes.load(std::memory_order_relaxed);
+			stats.overflows += arenas->overflows.load(std::memory_order_relaxed);
+		}
+		return stats;
+	}
+
+	void FrameArenas::DrawImGui() const
+	{
+		if (!ImGui::Begin("Frame Arenas"))
+		{
+			ImGui::End();
+			return;
+		}
+
+		FrameArenaStats stats = GetStats();
+		ImGui::Text("%zu threads, %.1f KiB last frame, %.1f KiB peak, %.1f KiB reserved, %llu overflows",
+			stats.threads, stats.lastFrameBytes / 1024.0f, stats.peakBytes / 1024.0f, stats.capacityBytes / 1024.0f, (unsigned long long)stats.overflows);
+
+		if (ImGui::BeginTable("Threads", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Thread");
+			ImGui::TableSetupColumn("Last frame (KiB)");
+			ImGui::TableSetupColumn("Peak (KiB)");
+			ImGui::TableSetupColumn("Reserved (KiB)");
+			ImGui::TableSetupColumn("Overflows");
+			ImGui::TableHeadersRow();
+
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			for (const auto& arenas : threads)
+			{
+				if (!arenas->inUse)
+					continue;
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", arenas->name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", arenas->lastFrameBytes.load(std::memory_order_relaxed) / 1024.0f);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", arenas->peakBytes.load(std::memory_order_relaxed) / 1024.0f);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", arenas->capacityBytes.load(std::memory_order_relaxed) / 1024.0f);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)arenas->overflows.load(std::memory_order_relaxed));
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+}
@@ -0,0 +1,113 @@
+#include "Otter/Core/FrameLimiter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Otter
+{
+	static const double INITIAL_SLEEP_OVERSHOOT = 1.0;	// ms, pessimistic until we've measured the scheduler.
+	static const double SLEEP_OVERSHOOT_SMOOTHING = 0.05;
+
+	FrameLimiter::FrameLimiter()
+	{
+		sleepOvershootMean = INITIAL_SLEEP_OVERSHOOT;
+		lastFrameEnd = Clock::now();
+		nextDeadline = lastFrameEnd;
+	}
+
+	void FrameLimiter::SetTargetFrameRate(float framesPerSecond)
+	{
+		targetFrameRate = std::max(framesPerSecond, 0.0f);
+		if (targetFrameRate > 0.0f)
+			framePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFrameRate));
+		else
+			framePeriod = Clock::duration::zero();
+
+		nextDeadline = Clock::now() + framePeriod;
+	}
+
+	void FrameLimiter::WaitForNextFrame()
+	{
+		Clock::time_point waitStart = Clock::now();
+		float overshoot = 0.0f;
+
+		if (framePeriod > Clock::duration::zero())
+		{
+			// If we're more than a full frame late, don't try to catch up by rendering a burst of unlimited frames.
+			if (waitStart - nextDeadline > framePeriod)
+				nextDeadline = waitStart;
+
+			SleepUntil(nextDeadline);
+
+			Clock::time_point woke = Clock::now();
+			overshoot = std::chrono::duration<float, std::milli>(woke - nextDeadline).count();
+			nextDeadline += framePeriod;
+		}
+
+		Clock::time_point frameEnd = Clock::now();
+		float frameTime = std::chrono::duration<float, std::milli>(frameEnd - lastFrameEnd).count();
+		float waitTime = std::chrono::duration<float, std::milli>(frameEnd - waitStart).count();
+		lastFrameEnd = frameEnd;
+
+		RecordFrame(frameTime, waitTime, std::max(overshoot, 0.0f));
+	}
+
+	void FrameLimiter::SleepUntil(Clock::time_point deadline)
+	{
+		// Sleep in 1ms steps as long as the worst expected oversleep still lands before the deadline.
+		const auto sleepStep = std::chrono::milliseconds(1);
+		while (true)
+		{
+			double spinWindow = sleepOvershootMean + 2.0 * std::sqrt(sleepOvershootVariance);
+			auto remaining = std::chrono::duration<double, std::milli>(deadline - Clock::now()).count();
+			if (remaining <= 1.0 + spinWindow)
+				break;
+
+			Clock::time_point sleepStart = Clock::now();
+			std::this_thread::sleep_for(sleepStep);
+			double slept = std::chrono::duration<double, std::milli>(Clock::now() - sleepStart).count();
+
+			// Exponentially weighted mean/variance of the oversleep, so the estimate follows changes in system load.
+			double delta = (slept - 1.0) - sleepOvershootMean;
+			sleepOvershootMean += SLEEP_OVERSHOOT_SMOOTHING * delta;
+			sleepOvershootVariance = (1.0 - SLEEP_OVERSHOOT_SMOOTHING) * (sleepOvershootVariance + SLEEP_OVERSHOOT_SMOOTHING * delta * delta);
+		}
+
+		// Spin the rest for sub-millisecond accuracy.
+		while (Clock::now() < deadline)
+			std::this_thread::yield();
+	}
+
+	void FrameLimiter::RecordFrame(float frameTime, float waitTime, float overshoot)
+	{
+		frameTimes[historyIndex] = frameTime;
+		waitTimes[historyIndex] = waitTime;
+		overshoots[historyIndex] = overshoot;
+		historyIndex = (historyIndex + 1) % FRAME_TIMING_HISTORY;
+		historyCount = std::min(historyCount + 1, FRAME_TIMING_HISTORY);
+
+		float sumFrame = 0.0f, sumWait = 0.0f, sumOvershoot = 0.0f;
+		float minFrame = frameTimes[0], maxFrame = frameTimes[0];
+		for (size_t i = 0; i < historyCount; i++)
+		{
+			sumFrame += frameTimes[i];
+			sumWait += waitTimes[i];
+			sumOvershoot += overshoots[i];
+			minFrame = std::min(minFrame, frameTimes[i]);
+			maxFrame = std::max(maxFrame, frameTimes[i]);
+		}
+
+		float count = static_cast<float>(historyCount);
+		float mean = sumFrame / count;
+		float variance = 0.0f;
+		for (size_t i = 0; i < historyCount; i++)
+			variance += (frameTimes[i] - mean) * (frameTimes[i] - mean);
+
+		stats.averageFrameTime = mean;
+		stats.minFrameTime = minFrame;
+		stats.maxFrameTime = maxFrame;
+		stats.jitter = std::sqrt(variance / count);
+		stats.averageWaitTime = sumWait / count;
+		stats.averageOvershoot = sumOvershoot / count;
+	}
+}
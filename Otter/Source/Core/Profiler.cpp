@@ -0,0 +1,384 @@
+#include "Otter/Core/Profiler.hpp"
+#include "loguru.hpp"
+#include "imgui.h"
+#include <algorithm>
+#include <fstream>
+
+namespace Otter
+{
+	static const uint64_t SPIKE_CAPTURE_COOLDOWN = 5000000000ull;	// ns, so one hitch doesn't dump a trace every frame.
+
+	Profiler& Profiler::Get()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler::Profiler()
+	{
+		origin = std::chrono::steady_clock::now();
+	}
+
+	Profiler::~Profiler()
+	{
+		if (pendingExport.valid())
+			pendingExport.wait();
+	}
+
+	uint64_t Profiler::Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Get().origin).count();
+	}
+
+	Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer != nullptr)
+			return *buffer;
+
+		// First marker on this thread, the only time recording takes a lock.
+		char threadName[64];
+		loguru::get_thread_name(threadName, sizeof(threadName), false);
+		buffer = AddBuffer(threadName);
+		return *buffer;
+	}
+
+	Profiler::ThreadBuffer* Profiler::AddBuffer(const std::string& name)
+	{
+		auto newBuffer = std::make_unique<ThreadBuffer>();
+		newBuffer->slots = std::make_unique<ThreadBuffer::Slot[]>(THREAD_BUFFER_SIZE);
+		newBuffer->name = name;
+
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		newBuffer->index = static_cast<uint32_t>(threads.size());
+		threads.push_back(std::move(newBuffer));
+		return threads.back().get();
+	}
+
+	uint32_t Profiler::CreateTrack(const std::string& name)
+	{
+		return AddBuffer(name)->index;
+	}
+
+	uint32_t Profiler::PushScope()
+	{
+		return GetThreadBuffer().depth++;
+	}
+
+	void Profiler::PopScope()
+	{
+		GetThreadBuffer().depth--;
+	}
+
+	void Profiler::Record(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		if (paused)
+			return;
+
+		Write(GetThreadBuffer(), name, start, end, depth);
+	}
+
+	void Profiler::RecordTrack(uint32_t track, const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		if (paused)
+			return;
+
+		ThreadBuffer* buffer = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			if (track < threads.size())
+				buffer = threads[track].get();
+		}
+
+		if (buffer != nullptr)
+			Write(*buffer, name, start, end, depth);
+	}
+
+	void Profiler::Write(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		uint64_t index = buffer.writeCount.load(std::memory_order_relaxed);
+		ThreadBuffer::Slot& slot = buffer.slots[index % THREAD_BUFFER_SIZE];
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		slot.depth.store(depth, std::memory_order_relaxed);
+		buffer.writeCount.store(index + 1, std::memory_order_release);
+	}
+
+	void Profiler::BeginFrame()
+	{
+		uint64_t now = Now();
+		if (frameStart != 0 && !paused)
+		{
+			frames[frameCount % FRAME_HISTORY] = { frameStart, now };
+			frameCount++;
+
+			float frameMs = (now - frameStart) / 1000000.0f;
+			if (spikeThresholdMs > 0.0f && frameMs > spikeThresholdMs && (lastSpikeCapture == 0 || now - lastSpikeCapture > SPIKE_CAPTURE_COOLDOWN))
+			{
+				lastSpikeCapture = now;
+				std::string path = "otter_spike_" + std::to_string(frameCount) + ".json";
+				LOG_F(WARNING, "Frame %llu took %.2f ms (threshold %.2f ms), writing the last %.1f s to %s", (unsigned long long)frameCount, frameMs, spikeThresholdMs, spikeWindowSeconds, path.c_str());
+				ExportChromeTraceAsync(path, spikeWindowSeconds);
+			}
+		}
+
+		frameStart = now;
+	}
+
+	std::vector<ProfileEvent> Profiler::Collect(uint64_t from, uint64_t to)
+	{
+		std::vector<ThreadBuffer*> buffers;
+		{
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			for (auto& thread : threads)
+				buffers.push_back(thread.get());
+		}
+
+		std::vector<ProfileEvent> events;
+		for (ThreadBuffer* buffer : buffers)
+		{
+			uint64_t count = buffer->writeCount.load(std::memory_order_acquire);
+			uint64_t oldest = count > THREAD_BUFFER_SIZE ? count - THREAD_BUFFER_SIZE : 0;
+			size_t firstEvent = events.size();
+			uint64_t lastIndex = count;
+
+			// Events are stored as scopes close, so going back from the newest we can stop at the first one that ended before 'from'.
+			for (uint64_t i = count; i > oldest; i--)
+			{
+				const ThreadBuffer::Slot& slot = buffer->slots[(i - 1) % THREAD_BUFFER_SIZE];
+				ProfileEvent event;
+				event.name = slot.name.load(std::memory_order_relaxed);
+				event.start = slot.start.load(std::memory_order_relaxed);
+				event.end = slot.end.load(std::memory_order_relaxed);
+				event.depth = slot.depth.load(std::memory_order_relaxed);
+				event.thread = buffer->index;
+
+				lastIndex = i - 1;
+				if (event.end < from)
+					break;
+				if (event.start <= to)
+					events.push_back(event);
+			}
+
+			// The owner may have lapped us while we were copying. If it reached the slots we read last, throw this thread's copy away.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t countAfter = buffer->writeCount.load(std::memory_order_relaxed);
+			if (countAfter > THREAD_BUFFER_SIZE && lastIndex < countAfter - THREAD_BUFFER_SIZE)
+				events.resize(firstEvent);
+		}
+
+		return events;
+	}
+
+	std::vector<std::string> Profiler::GetThreadNames()
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		std::vector<std::string> names;
+		for (auto& thread : threads)
+			names.push_back(thread->name);
+
+		return names;
+	}
+
+	bool Profiler::ExportChromeTrace(const std::string& path, float lastSeconds)
+	{
+		uint64_t to = Now();
+		uint64_t window = static_cast<uint64_t>(lastSeconds * 1000000000.0);
+		uint64_t from = lastSeconds > 0.0f && window < to ? to - window : 0;
+
+		return WriteChromeTrace(path, Collect(from, to), GetThreadNames());
+	}
+
+	void Profiler::ExportChromeTraceAsync(const std::string& path, float lastSeconds)
+	{
+		if (pendingExport.valid() && pendingExport.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			LOG_F(WARNING, "Skipping trace export to %s, the previous one is still being written", path.c_str());
+			return;
+		}
+
+		// Copying is quick, formatting and writing the file is what we don't want on this thread.
+		uint64_t to = Now();
+		uint64_t window = static_cast<uint64_t>(lastSeconds * 1000000000.0);
+		uint64_t from = lastSeconds > 0.0f && window < to ? to - window : 0;
+		std::vector<ProfileEvent> events = Collect(from, to);
+		std::vector<std::string> threadNames = GetThreadNames();
+
+		pendingExport = std::async(std::launch::async, [path, events = std::move(events), threadNames = std::move(threadNames)]() {
+			loguru::set_thread_name("Profiler export");
+			WriteChromeTrace(path, events, threadNames);
+		});
+	}
+
+	static void WriteJsonString(std::ofstream& file, const char* text)
+	{
+		file << '"';
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				file << '\\';
+			file << *c;
+		}
+		file << '"';
+	}
+
+	bool Profiler::WriteChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events, const std::vector<std::string>& threadNames)
+	{
+		std::ofstream file(path, std::ios::out | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_F(ERROR, "Failed to open %s for writing the profiler trace", path.c_str());
+			return false;
+		}
+
+		// Trace event format, "X" are complete events with a duration. Timestamps are in microseconds.
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		bool first = true;
+		for (size_t i = 0; i < threadNames.size(); i++)
+		{
+			file << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":";
+			WriteJsonString(file, threadNames[i].c_str());
+			file << "}}";
+			first = false;
+		}
+
+		file.setf(std::ios::fixed);
+		file.precision(3);
+		for (const auto& event : events)
+		{
+			file << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":";
+			WriteJsonString(file, event.name);
+			file << ",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			first = false;
+		}
+		file << "\n]}\n";
+
+		LOG_F(INFO, "Wrote %zu profiler events to %s", events.size(), path.c_str());
+		return true;
+	}
+
+	ProfileScope::ProfileScope(const char* name)
+	{
+		this->name = name;
+		depth = Profiler::Get().PushScope();
+		start = Profiler::Now();
+	}
+
+	ProfileScope::~ProfileScope()
+	{
+		uint64_t end = Profiler::Now();
+		Profiler& profiler = Profiler::Get();
+		profiler.PopScope();
+		profiler.Record(name, start, end, depth);
+	}
+
+	void Profiler::DrawImGui(bool* open)
+	{
+		if (!ImGui::Begin("Profiler", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		bool isPaused = paused;
+		if (ImGui::Checkbox("Pause", &isPaused))
+			SetPaused(isPaused);
+		ImGui::SameLine();
+		if (ImGui::Button("Export trace"))
+			ExportChromeTraceAsync("otter_trace.json");
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(150.0f);
+		ImGui::DragFloat("Spike capture (ms)", &spikeThresholdMs, 0.1f, 0.0f, 1000.0f, spikeThresholdMs > 0.0f ? "%.1f" : "off");
+
+		size_t frameTotal = static_cast<size_t>(std::min<uint64_t>(frameCount, FRAME_HISTORY));
+		if (frameTotal == 0)
+		{
+			ImGui::End();
+			return;
+		}
+
+		// Frame times, oldest on the left. Click a bar to inspect that frame.
+		std::array<float, FRAME_HISTORY> frameTimes{};
+		float maxFrameTime = 0.0f;
+		uint64_t firstFrame = frameCount - frameTotal;
+		for (size_t i = 0; i < frameTotal; i++)
+		{
+			const FrameRecord& frame = frames[(firstFrame + i) % FRAME_HISTORY];
+			frameTimes[i] = (frame.end - frame.start) / 1000000.0f;
+			maxFrameTime = std::max(maxFrameTime, frameTimes[i]);
+		}
+
+		ImGui::PlotHistogram("##FrameTimes", frameTimes.data(), static_cast<int>(frameTotal), 0, nullptr, 0.0f, maxFrameTime * 1.1f, ImVec2(-1.0f, 60.0f));
+		if (ImGui::IsItemClicked())
+		{
+			float t = (ImGui::GetMousePos().x - ImGui::GetItemRectMin().x) / ImGui::GetItemRectSize().x;
+			selectedFrame = firstFrame + static_cast<uint64_t>(std::clamp(t, 0.0f, 0.999f) * frameTotal);
+			SetPaused(true);
+		}
+
+		if (selectedFrame < static_cast<int64_t>(firstFrame) || !paused)
+			selectedFrame = -1;
+
+		uint64_t frameIndex = selectedFrame >= 0 ? static_cast<uint64_t>(selectedFrame) : frameCount - 1;
+		const FrameRecord& frame = frames[frameIndex % FRAME_HISTORY];
+		ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frameIndex, (frame.end - frame.start) / 1000000.0f);
+
+		DrawTimeline(frame);
+		ImGui::End();
+	}
+
+	void Profiler::DrawTimeline(const FrameRecord& frame)
+	{
+		const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+		const float labelWidth = 140.0f;
+
+		std::vector<ProfileEvent> events = Collect(frame.start, frame.end);
+		std::vector<std::string> threadNames = GetThreadNames();
+
+		std::vector<uint32_t> threadDepth(threadNames.size(), 0);
+		for (const auto& event : events)
+			threadDepth[event.thread] = std::max(threadDepth[event.thread], event.depth + 1);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 1.0f);
+		double scale = width / static_cast<double>(std::max<uint64_t>(frame.end - frame.start, 1));
+
+		// One lane per thread that did something this frame, nested scopes stacked below their parent.
+		std::vector<float> threadY(threadNames.size(), 0.0f);
+		float y = origin.y;
+		for (size_t i = 0; i < threadNames.size(); i++)
+		{
+			if (threadDepth[i] == 0)
+				continue;
+
+			threadY[i] = y;
+			drawList->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text), threadNames[i].c_str());
+			y += threadDepth[i] * rowHeight + 4.0f;
+		}
+
+		const ProfileEvent* hovered = nullptr;
+		ImVec2 mouse = ImGui::GetMousePos();
+		for (const auto& event : events)
+		{
+			uint64_t start = std::max(event.start, frame.start);
+			uint64_t end = std::min(event.end, frame.end);
+			ImVec2 min(origin.x + labelWidth + static_cast<float>((start - frame.start) * scale), threadY[event.thread] + event.depth * rowHeight);
+			ImVec2 max(std::max(origin.x + labelWidth + static_cast<float>((end - frame.start) * scale), min.x + 1.0f), min.y + rowHeight - 1.0f);
+
+			// Same name, same color, across frames.
+			float hue = static_cast<float>(std::hash<const void*>{}(event.name) % 360) / 360.0f;
+			drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.75f));
+			if (max.x - min.x > ImGui::CalcTextSize(event.name).x + 4.0f)
+				drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_BLACK, event.name);
+
+			if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+				hovered = &event;
+		}
+
+		ImGui::Dummy(ImVec2(labelWidth + width, y - origin.y));
+		if (hovered != nullptr && ImGui::IsItemHovered())
+			ImGui::SetTooltip("%s\n%.3f ms", hovered->name, (hovered->end - hovered->start) / 1000000.0f);
+	}
+}
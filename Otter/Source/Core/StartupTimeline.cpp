@@ -0,0 +1,41 @@
+#include "Otter/Core/StartupTimeline.hpp"
+#include "loguru.hpp"
+#include <algorithm>
+
+namespace Otter
+{
+	StartupTimeline::StartupTimeline(std::string name)
+	{
+		this->name = name;
+		origin = Clock::now();
+		ownerThread = std::this_thread::get_id();
+	}
+
+	void StartupTimeline::Record(const std::string& step, Clock::time_point start, Clock::time_point end)
+	{
+		Step entry;
+		entry.name = step;
+		entry.startOffset = std::chrono::duration<float, std::milli>(start - origin).count();
+		entry.duration = std::chrono::duration<float, std::milli>(end - start).count();
+		entry.mainThread = std::this_thread::get_id() == ownerThread;
+
+		std::lock_guard<std::mutex> lock(stepsMutex);
+		steps.push_back(entry);
+	}
+
+	void StartupTimeline::Log()
+	{
+		std::lock_guard<std::mutex> lock(stepsMutex);
+		std::sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) { return a.startOffset < b.startOffset; });
+
+		float total = std::chrono::duration<float, std::milli>(Clock::now() - origin).count();
+		float serial = 0.0f;
+		for (const auto& step : steps)
+			if (step.mainThread)
+				serial += step.duration;
+
+		LOG_F(INFO, "Startup timeline for '%s': %.1f ms total, %.1f ms on the main thread", name.c_str(), total, serial);
+		for (const auto& step : steps)
+			LOG_F(INFO, "  [%8.1f ms] %8.1f ms  %-6s %s", step.startOffset, step.duration, step.mainThread ? "main" : "worker", step.name.c_str());
+	}
+}
@@ -0,0 +1,54 @@
+#include "Otter/Core/ThreadPool.hpp"
+#include "loguru.hpp"
+#include <algorithm>
+#include <string>
+
+namespace Otter
+{
+	ThreadPool::ThreadPool(size_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			size_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = std::max<size_t>(hardwareThreads > 1 ? hardwareThreads - 1 : 1, 1);
+		}
+
+		workers.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; i++)
+			workers.emplace_back(&ThreadPool::WorkerMain, this, i);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(tasksMutex);
+			stopping = true;
+		}
+		tasksAvailable.notify_all();
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	void ThreadPool::WorkerMain(size_t index)
+	{
+		std::string threadName = "Worker " + std::to_string(index);
+		loguru::set_thread_name(threadName.c_str());
+
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(tasksMutex);
+				tasksAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (stopping && tasks.empty())
+					return;
+
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
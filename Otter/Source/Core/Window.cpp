@@ -1,5 +1,7 @@
 #include "Otter/Core/Window.hpp"
 #include "Otter/Components/ComponentRegister.hpp"
+#include "Otter/Core/AllocationTracker.hpp"
+#include "Otter/Core/Profiler.hpp"
 #include "loguru.hpp"
 
 namespace Otter 
@@ -13,36 +15,50 @@ namespace Otter
 		abort();
 	}
 
-	Window::Window(glm::vec2 size, std::string title, bool imGuiAllowed)
+	Window::Window(glm::vec2 size, std::string title, bool imGuiAllowed, bool headless)
 	{
 		this->handle = NULL;
 		this->windowId = 0;
+		this->headless = headless;
 
-		//TODO high DPI support (SDL_WINDOW_ALLOW_HIGHDPI)
-		handle = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, size.x, size.y, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-		AssertSDLError(handle != NULL);
+		if (!headless)
+		{
+			//TODO high DPI support (SDL_WINDOW_ALLOW_HIGHDPI)
+			handle = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, size.x, size.y, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+			AssertSDLError(handle != NULL);
 
-		windowId = SDL_GetWindowID(handle);
-		AssertSDLError(windowId != 0);
+			windowId = SDL_GetWindowID(handle);
+			AssertSDLError(windowId != 0);
+		}
+		else
+			imGuiAllowed = false;	// ImGui's platform backend needs a real window to get input from.
 
 		this->size = {size.x, size.y};
 		this->title = title;
 		this->mouseFocus = true;
         this->keyboardFocus = true;
+		this->shown = true;		// Created with SDL_WINDOW_SHOWN.
 
-		LOG_F(INFO, "Initialized new window \'%s\' with size %gx%g and id %u", title.c_str(), size.x, size.y, windowId);
+		LOG_F(INFO, "Initialized new %swindow \'%s\' with size %gx%g and id %u", headless ? "headless " : "", title.c_str(), size.x, size.y, windowId);
 
 		// Set up Components
 		ComponentRegister::RegisterComponentsWithCoordinator(&coordinator);
 
 		// Set up Systems
-		renderer = coordinator.RegisterSystem<Systems::Renderer>();
+		{
+			Signature signature;
+			signature.set(coordinator.GetComponentType<Components::Transform>());
+			RegisterSystem<Systems::TransformSystem>(signature);
+		}
 		{
 			Signature signature;
 			signature.set(coordinator.GetComponentType<Components::MeshRenderer>());
-			coordinator.SetSystemSignature<Systems::Renderer>(signature);
+			renderer = RegisterSystem<Systems::Renderer>(signature);
 		}
 		renderer->SetWindowHandle(handle);
+		renderer->SetTitle(title);
+		if (headless)
+			renderer->SetHeadless(this->size);
 		renderer->SetFrameBufferResizedCallback([this](glm::vec2 newSize) {
 			OnWindowResized(newSize);
 		});
@@ -53,7 +69,6 @@ namespace Otter
 				OnDrawImGui();
 			});
 		}
-		systems.push_back(renderer);
 
 		// Done. Let's go!
 		initialized = true;
@@ -67,17 +82,19 @@ namespace Otter
 			return;
 		}
 
-		for(auto system : systems)
+		for(const auto& system : systems)
 			system->OnStop();
 
-		SDL_DestroyWindow(handle);
+		if (handle != nullptr)
+			SDL_DestroyWindow(handle);
 
 		LOG_F(INFO, "Closed window %s", title.c_str());
 	}
 
 	void Window::OnStart()
 	{
-		renderer->OnStart();
+		for(const auto& system : systems)
+			system->OnStart();
 	}
 
 	bool Window::ShouldBeDestroyed()
@@ -90,11 +107,25 @@ namespace Otter
 
 	void Window::OnTick(float deltaTime)
 	{
+		OTTER_PROFILE_SCOPE("Window::OnTick");
 		if (!IsValid())
 			return;
 
-		for(const auto system : systems)
+		for(const auto& system : systems)
+		{
+			if (system == renderer)
+				continue;
+
+			OTTER_ALLOCATION_SCOPE(system->GetName());
 			system->OnTick(deltaTime);
+		}
+
+		// Nothing to see, don't spend CPU and GPU time on recording and presenting.
+		if (IsActive())
+		{
+			OTTER_ALLOCATION_SCOPE(renderer->GetName());
+			renderer->OnTick(deltaTime);
+		}
 	}
 
 	void Window::OnSDLEvent(SDL_Event* event)
@@ -104,6 +135,9 @@ namespace Otter
 
 	void Window::OnWindowEvent(SDL_WindowEvent* windowEvent)
 	{
+		if (headless)
+			return;
+
 		switch (windowEvent->event)
         {
         case SDL_WINDOWEVENT_SHOWN:
@@ -117,6 +151,8 @@ namespace Otter
 			renderer->InvalidateFramebuffer();
             break;
         case SDL_WINDOWEVENT_EXPOSED:
+			// Not every platform sends RESTORED after a minimize, but the window is always exposed again.
+			minimized = (SDL_GetWindowFlags(handle) & SDL_WINDOW_MINIMIZED) != 0;
 			renderer->InvalidateFramebuffer();
             break;
         case SDL_WINDOWEVENT_ENTER:
@@ -132,7 +168,7 @@ namespace Otter
             keyboardFocus = false;
             break;
         case SDL_WINDOWEVENT_MINIMIZED:
-            minimized = true;				//TODO this doesnt go back false after restore?
+            minimized = true;
             break;
         case SDL_WINDOWEVENT_MAXIMIZED:
             minimized = false;
@@ -0,0 +1,192 @@
+#include "Otter/Rendering/AssetManager.hpp"
+#include "Otter/Rendering/RenderDevice.hpp"
+#include "Otter/Core/Types.hpp"
+#include "imgui.h"
+#include "loguru.hpp"
+
+namespace Otter::Rendering
+{
+	static const char* GetTypeName(AssetType type)
+	{
+		switch (type)
+		{
+			case AssetType::Mesh: return "Mesh";
+			case AssetType::Texture: return "Texture";
+			case AssetType::Shader: return "Shader";
+		}
+		return "Unknown";
+	}
+
+	AssetManager& AssetManager::Get()
+	{
+		static AssetManager assets;
+		return assets;
+	}
+
+	MeshHandle AssetManager::AcquireMesh(const std::string& path)
+	{
+		return { Intern(path, AssetType::Mesh) };
+	}
+
+	TextureHandle AssetManager::AcquireTexture(const std::string& path)
+	{
+		return { Intern(path, AssetType::Texture) };
+	}
+
+	ShaderHandle AssetManager::AcquireShader(const std::string& name)
+	{
+		return { Intern(name, AssetType::Shader) };
+	}
+
+	const std::string& AssetManager::GetPath(AssetId id) const
+	{
+		static const std::string none;
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(id);
+		return it != entries.end() ? it->second.path : none;
+	}
+
+	AssetId AssetManager::Intern(const std::string& path, AssetType type)
+	{
+		AssetId id = fnv1a_32(path.c_str(), path.size());
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(id);
+		if (it == entries.end())
+		{
+			Entry& entry = entries[id];
+			entry.path = path;
+			entry.type = type;
+			entry.references = 1;
+			entry.unused = unusedAssets.end();
+			return id;
+		}
+
+		Entry& entry = it->second;
+		if (entry.path != path || entry.type != type)
+		{
+			LOG_F(ERROR, "Asset %s (%s) collides with %s (%s), rename one of them", path.c_str(), GetTypeName(type), entry.path.c_str(), GetTypeName(entry.type));
+			abort();
+		}
+
+		if (entry.references++ == 0 && entry.unused != unusedAssets.end())
+		{
+			unusedAssets.erase(entry.unused);
+			entry.unused = unusedAssets.end();
+		}
+		return id;
+	}
+
+	void AssetManager::AddReference(AssetId id)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(id);
+		if (it == entries.end())
+			return;
+
+		Entry& entry = it->second;
+		if (entry.references++ == 0 && entry.unused != unusedAssets.end())
+		{
+			unusedAssets.erase(entry.unused);
+			entry.unused = unusedAssets.end();
+		}
+	}
+
+	void AssetManager::RemoveReference(AssetId id)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(id);
+		if (it == entries.end())
+			return;
+
+		Entry& entry = it->second;
+		if (entry.references == 0)
+		{
+			LOG_F(ERROR, "Asset %s released more often than it was acquired", entry.path.c_str());
+			return;
+		}
+
+		if (--entry.references == 0 && entry.type != AssetType::Shader)
+		{
+			entry.releasedFrame = frame;
+			entry.unused = unusedAssets.insert(unusedAssets.end(), id);
+		}
+	}
+
+	void AssetManager::Update(RenderDevice& device)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		frame++;
+		residentBytes = device.GetResidentAssetBytes();
+
+		while (residentBytes > budgetBytes && !unusedAssets.empty())
+		{
+			Entry& entry = entries[unusedAssets.front()];
+			if (frame - entry.releasedFrame < EVICTION_DELAY_FRAMES)
+				break;	// Everything after was released even later.
+
+			unusedAssets.pop_front();
+			entry.unused = unusedAssets.end();
+			if (entry.type == AssetType::Mesh)
+				device.UnloadMesh(entry.path);
+			else if (entry.type == AssetType::Texture)
+				device.UnloadTexture(entry.path);
+
+			evictions++;
+			residentBytes = device.GetResidentAssetBytes();
+		}
+	}
+
+	AssetStats AssetManager::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		AssetStats stats;
+		stats.assets = entries.size();
+		stats.unused = unusedAssets.size();
+		for (const auto& pair : entries)
+			if (pair.second.references > 0)
+				stats.referenced++;
+		stats.residentBytes = residentBytes;
+		stats.budgetBytes = budgetBytes;
+		stats.evictions = evictions;
+		return stats;
+	}
+
+	void AssetManager::DrawImGui() const
+	{
+		if (!ImGui::Begin("Assets"))
+		{
+			ImGui::End();
+			return;
+		}
+
+		AssetStats stats = GetStats();
+		ImGui::Text("%zu assets, %zu referenced, %zu unused, %llu evicted", stats.assets, stats.referenced, stats.unused, (unsigned long long)stats.evictions);
+		ImGui::Text("%.1f / %.1f MiB resident", stats.residentBytes / (1024.0f * 1024.0f), stats.budgetBytes / (1024.0f * 1024.0f));
+
+		if (ImGui::BeginTable("Assets", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Id");
+			ImGui::TableSetupColumn("Type");
+			ImGui::TableSetupColumn("References");
+			ImGui::TableSetupColumn("Path");
+			ImGui::TableHeadersRow();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& pair : entries)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%08x", pair.first);
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", GetTypeName(pair.second.type));
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", pair.second.references);
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", pair.second.path.c_str());
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+}
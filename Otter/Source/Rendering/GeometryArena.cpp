@@ -0,0 +1,170 @@
+#include "Otter/Rendering/GeometryArena.hpp"
+#include "Otter/Rendering/RenderTypes.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Otter::Rendering
+{
+	static const VkDeviceSize INDEX_ALIGNMENT = 4;	// Lets a range hold either index type.
+
+	static VkDeviceSize GetIndexSize(VkIndexType indexType)
+	{
+		return indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2;
+	}
+
+	void GeometryArena::Create(VmaAllocator allocator, uint32_t vertexStride, bool hostWritable, const std::vector<uint32_t>& sharedQueueFamilies)
+	{
+		this->allocator = allocator;
+		this->vertexStride = vertexStride;
+		this->hostWritable = hostWritable;
+		this->sharedQueueFamilies = sharedQueueFamilies;
+	}
+
+	void GeometryArena::Destroy()
+	{
+		for (auto& page : pages)
+		{
+			// Whatever is still allocated goes with the page, a virtual block won't be destroyed with live allocations.
+			vmaClearVirtualBlock(page.vertexBlock);
+			vmaClearVirtualBlock(page.indexBlock);
+			vmaDestroyVirtualBlock(page.vertexBlock);
+			vmaDestroyVirtualBlock(page.indexBlock);
+			vmaDestroyBuffer(allocator, page.vertexBuffer, page.vertexBufferAllocation);
+			vmaDestroyBuffer(allocator, page.indexBuffer, page.indexBufferAllocation);
+		}
+		pages.clear();
+		usedBytes = 0;
+		capacityBytes = 0;
+	}
+
+	bool GeometryArena::Allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType, GeometryAllocation& allocation)
+	{
+		VkDeviceSize indexBytes = static_cast<VkDeviceSize>(indexCount) * GetIndexSize(indexType);
+		if (vertexCount == 0 || indexCount == 0)
+			return false;
+
+		uint32_t page = 0;
+		while (page < pages.size() && !AllocateInPage(page, vertexCount, indexBytes, allocation))
+			page++;
+
+		if (page == pages.size())
+		{
+			CreatePage(std::max<VkDeviceSize>(PAGE_VERTEX_BYTES / vertexStride, vertexCount), std::max(PAGE_INDEX_BYTES, indexBytes));
+			if (!AllocateInPage(page, vertexCount, indexBytes, allocation))
+				return false;
+		}
+
+		const Page& owner = pages[page];
+		allocation.page = page;
+		allocation.draw.vertexBuffer = owner.vertexBuffer;
+		allocation.draw.indexBuffer = owner.indexBuffer;
+		allocation.draw.indexType = indexType;
+		allocation.draw.indexCount = indexCount;
+		allocation.draw.firstIndex = static_cast<uint32_t>(allocation.indexByteOffset / GetIndexSize(indexType));
+		allocation.draw.vertexOffset = static_cast<int32_t>(allocation.vertexByteOffset / vertexStride);
+		usedBytes += static_cast<VkDeviceSize>(vertexCount) * vertexStride + indexBytes;
+		return true;
+	}
+
+	void GeometryArena::Free(GeometryAllocation& allocation)
+	{
+		if (allocation.vertexAllocation == VK_NULL_HANDLE)
+			return;
+
+		const Page& page = pages[allocation.page];
+		VmaVirtualAllocationInfo vertexInfo{}, indexInfo{};
+		vmaGetVirtualAllocationInfo(page.vertexBlock, allocation.vertexAllocation, &vertexInfo);
+		vmaGetVirtualAllocationInfo(page.indexBlock, allocation.indexAllocation, &indexInfo);
+		usedBytes -= vertexInfo.size * vertexStride + indexInfo.size;
+
+		vmaVirtualFree(page.vertexBlock, allocation.vertexAllocation);
+		vmaVirtualFree(page.indexBlock, allocation.indexAllocation);
+		allocation = {};
+	}
+
+	bool GeometryArena::Write(const GeometryAllocation& allocation, const void* vertices, VkDeviceSize vertexBytes, const void* indices, VkDeviceSize indexBytes)
+	{
+		const Page& page = pages[allocation.page];
+		if (page.mappedVertices == nullptr)
+			return false;
+
+		// Host writes are visible to everything submitted afterwards, no barrier needed.
+		memcpy(page.mappedVertices + allocation.vertexByteOffset, vertices, (size_t)vertexBytes);
+		memcpy(page.mappedIndices + allocation.indexByteOffset, indices, (size_t)indexBytes);
+		vmaFlushAllocation(allocator, page.vertexBufferAllocation, allocation.vertexByteOffset, vertexBytes);	// No-op on coherent memory.
+		vmaFlushAllocation(allocator, page.indexBufferAllocation, allocation.indexByteOffset, indexBytes);
+		return true;
+	}
+
+	void GeometryArena::CreatePage(VkDeviceSize vertexCapacity, VkDeviceSize indexBytes)
+	{
+		Page page;
+		VmaAllocationCreateInfo allocCreateInfo{};
+		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+		if (hostWritable)	// VMA still picks device-local memory first, and may fall back to memory we can only copy to.
+			allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferInfo.size = vertexCapacity * vertexStride;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		bufferInfo.sharingMode = sharedQueueFamilies.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+		bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedQueueFamilies.size());
+		bufferInfo.pQueueFamilyIndices = sharedQueueFamilies.data();
+		VmaAllocationInfo vertexInfo{};
+		VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &page.vertexBuffer, &page.vertexBufferAllocation, &vertexInfo);
+		check_vk_result(result);
+
+		bufferInfo.size = indexBytes;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		VmaAllocationInfo indexInfo{};
+		result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &page.indexBuffer, &page.indexBufferAllocation, &indexInfo);
+		check_vk_result(result);
+
+		VkMemoryPropertyFlags vertexMemory = 0, indexMemory = 0;
+		vmaGetAllocationMemoryProperties(allocator, page.vertexBufferAllocation, &vertexMemory);
+		vmaGetAllocationMemoryProperties(allocator, page.indexBufferAllocation, &indexMemory);
+		if ((vertexMemory & indexMemory & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && vertexInfo.pMappedData && indexInfo.pMappedData)
+		{
+			page.mappedVertices = static_cast<uint8_t*>(vertexInfo.pMappedData);
+			page.mappedIndices = static_cast<uint8_t*>(indexInfo.pMappedData);
+		}
+
+		VmaVirtualBlockCreateInfo blockInfo{};
+		blockInfo.size = vertexCapacity;
+		result = vmaCreateVirtualBlock(&blockInfo, &page.vertexBlock);
+		check_vk_result(result);
+
+		blockInfo.size = indexBytes;
+		result = vmaCreateVirtualBlock(&blockInfo, &page.indexBlock);
+		check_vk_result(result);
+
+		capacityBytes += vertexCapacity * vertexStride + indexBytes;
+		pages.push_back(page);
+		LOG_F(INFO, "Geometry arena page %zu: %.1f MiB vertices, %.1f MiB indices%s", pages.size() - 1,
+			vertexCapacity * vertexStride / (1024.0f * 1024.0f), indexBytes / (1024.0f * 1024.0f), page.mappedVertices ? ", host writable" : "");
+	}
+
+	bool GeometryArena::AllocateInPage(uint32_t page, uint32_t vertexCount, VkDeviceSize indexBytes, GeometryAllocation& allocation)
+	{
+		const Page& candidate = pages[page];
+
+		VmaVirtualAllocationCreateInfo vertexRequest{};
+		vertexRequest.size = vertexCount;
+		VkDeviceSize vertexOffset = 0;
+		if (vmaVirtualAllocate(candidate.vertexBlock, &vertexRequest, &allocation.vertexAllocation, &vertexOffset) != VK_SUCCESS)
+			return false;
+
+		VmaVirtualAllocationCreateInfo indexRequest{};
+		indexRequest.size = indexBytes;
+		indexRequest.alignment = INDEX_ALIGNMENT;
+		if (vmaVirtualAllocate(candidate.indexBlock, &indexRequest, &allocation.indexAllocation, &allocation.indexByteOffset) != VK_SUCCESS)
+		{
+			vmaVirtualFree(candidate.vertexBlock, allocation.vertexAllocation);
+			allocation.vertexAllocation = VK_NULL_HANDLE;
+			return false;
+		}
+
+		allocation.vertexByteOffset = vertexOffset * vertexStride;
+		return true;
+	}
+}
@@ -0,0 +1,230 @@
+#include "Otter/Rendering/GpuProfiler.hpp"
+#include "Otter/Rendering/RenderDevice.hpp"
+#include "Otter/Core/Profiler.hpp"
+#include "imgui.h"
+
+namespace Otter::Rendering
+{
+	static const VkQueryPipelineStatisticFlags PIPELINE_STATISTICS = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+	static const uint32_t PIPELINE_STATISTICS_COUNT = 2;	// Results come in bit order: vertex, then fragment invocations.
+
+	void GpuProfiler::Create(RenderDevice& device, const std::string& name)
+	{
+		logicalDevice = device.GetLogicalDevice();
+		this->name = name;
+
+		uint32_t validBits = device.GetTimestampValidBits();
+		if (validBits == 0)
+		{
+			LOG_F(WARNING, "The graphics queue can't write timestamps, GPU profiling is disabled for %s", name.c_str());
+			return;
+		}
+
+		timestampPeriod = device.GetProperties().limits.timestampPeriod;
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * MAX_PASSES * 2;
+		VkResult result = vkCreateQueryPool(logicalDevice, &poolInfo, nullptr, &timestampPool);
+		check_vk_result(result);
+
+		if (device.GetEnabledFeatures().pipelineStatisticsQuery)
+		{
+			poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			poolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * MAX_PASSES;
+			poolInfo.pipelineStatistics = PIPELINE_STATISTICS;
+			result = vkCreateQueryPool(logicalDevice, &poolInfo, nullptr, &statisticsPool);
+			check_vk_result(result);
+		}
+
+		profilerTrack = Profiler::Get().CreateTrack(name);
+		frames = {};
+		currentFrame = 0;
+		passOpen = false;
+	}
+
+	void GpuProfiler::Destroy()
+	{
+		if (statisticsPool != VK_NULL_HANDLE)
+			vkDestroyQueryPool(logicalDevice, statisticsPool, nullptr);
+		if (timestampPool != VK_NULL_HANDLE)
+			vkDestroyQueryPool(logicalDevice, timestampPool, nullptr);
+
+		statisticsPool = VK_NULL_HANDLE;
+		timestampPool = VK_NULL_HANDLE;
+	}
+
+	void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!IsEnabled())
+			return;
+
+		// The fence of this frame slot was just waited on, so whatever it recorded last time is done.
+		ReadResults(frameIndex);
+
+		currentFrame = frameIndex;
+		FrameQueries& frame = frames[currentFrame];
+		frame.passCount = 0;
+		frame.recordTime = Profiler::Now();
+		frame.pending = true;
+
+		vkCmdResetQueryPool(commandBuffer, timestampPool, currentFrame * MAX_PASSES * 2, MAX_PASSES * 2);
+		if (statisticsPool != VK_NULL_HANDLE)
+			vkCmdResetQueryPool(commandBuffer, statisticsPool, currentFrame * MAX_PASSES, MAX_PASSES);
+	}
+
+	void GpuProfiler::BeginPass(VkCommandBuffer commandBuffer, const char* name)
+	{
+		FrameQueries& frame = frames[currentFrame];
+		if (!IsEnabled() || passOpen || frame.passCount >= MAX_PASSES)
+			return;
+
+		uint32_t pass = frame.passCount;
+		frame.passNames[pass] = name;
+		passOpen = true;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, (currentFrame * MAX_PASSES + pass) * 2);
+		if (statisticsPool != VK_NULL_HANDLE)
+			vkCmdBeginQuery(commandBuffer, statisticsPool, currentFrame * MAX_PASSES + pass, 0);
+	}
+
+	void GpuProfiler::EndPass(VkCommandBuffer commandBuffer)
+	{
+		if (!IsEnabled() || !passOpen)
+			return;
+
+		FrameQueries& frame = frames[currentFrame];
+		uint32_t pass = frame.passCount;
+		if (statisticsPool != VK_NULL_HANDLE)
+			vkCmdEndQuery(commandBuffer, statisticsPool, currentFrame * MAX_PASSES + pass);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, (currentFrame * MAX_PASSES + pass) * 2 + 1);
+
+		frame.passCount++;
+		passOpen = false;
+	}
+
+	void GpuProfiler::ReadResults(uint32_t frameIndex)
+	{
+		FrameQueries& frame = frames[frameIndex];
+		if (!frame.pending || frame.passCount == 0)
+			return;
+		frame.pending = false;
+
+		// No VK_QUERY_RESULT_WAIT_BIT: if a result isn't there after all we'd rather drop this frame's numbers than stall.
+		std::array<uint64_t, MAX_PASSES * 2> timestamps{};
+		VkResult result = vkGetQueryPoolResults(logicalDevice, timestampPool, frameIndex * MAX_PASSES * 2, frame.passCount * 2,
+			sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result == VK_NOT_READY)
+			return;
+		check_vk_result(result);
+
+		std::array<uint64_t, MAX_PASSES * PIPELINE_STATISTICS_COUNT> statistics{};
+		bool hasStatistics = false;
+		if (statisticsPool != VK_NULL_HANDLE)
+		{
+			result = vkGetQueryPoolResults(logicalDevice, statisticsPool, frameIndex * MAX_PASSES, frame.passCount,
+				sizeof(statistics), statistics.data(), sizeof(uint64_t) * PIPELINE_STATISTICS_COUNT, VK_QUERY_RESULT_64_BIT);
+			hasStatistics = result == VK_SUCCESS;
+		}
+
+		// GPU ticks have their own time base; place the frame on the CPU timeline starting where its recording started.
+		uint64_t frameStart = timestamps[0] & timestampMask;
+		auto toNanoseconds = [&](uint64_t timestamp) { return static_cast<uint64_t>(((timestamp & timestampMask) - frameStart) * static_cast<double>(timestampPeriod)); };
+
+		std::array<GpuPassTiming, MAX_PASSES> passes{};
+		for (uint32_t i = 0; i < frame.passCount; i++)
+		{
+			uint64_t start = toNanoseconds(timestamps[i * 2]);
+			uint64_t end = toNanoseconds(timestamps[i * 2 + 1]);
+
+			passes[i].name = frame.passNames[i];
+			passes[i].milliseconds = (end - start) / 1000000.0f;
+			passes[i].hasStatistics = hasStatistics;
+			passes[i].vertexInvocations = statistics[i * PIPELINE_STATISTICS_COUNT];
+			passes[i].fragmentInvocations = statistics[i * PIPELINE_STATISTICS_COUNT + 1];
+
+			Profiler::Get().RecordTrack(profilerTrack, frame.passNames[i], frame.recordTime + start, frame.recordTime + end, 0);
+		}
+
+		// assign reuses the vector's storage, so reading results doesn't allocate once it has seen the most passes a frame has.
+		std::lock_guard<std::mutex> lock(resultsMutex);
+		results.assign(passes.begin(), passes.begin() + frame.passCount);
+		frameMilliseconds = toNanoseconds(timestamps[frame.passCount * 2 - 1]) / 1000000.0f;
+		resolvedFrames++;
+	}
+
+	std::vector<GpuPassTiming> GpuProfiler::GetResults(float* frameMilliseconds, uint64_t* resolvedFrames) const
+	{
+		std::lock_guard<std::mutex> lock(resultsMutex);
+		if (frameMilliseconds != nullptr)
+			*frameMilliseconds = this->frameMilliseconds;
+		if (resolvedFrames != nullptr)
+			*resolvedFrames = this->resolvedFrames;
+
+		return results;
+	}
+
+	float GpuProfiler::GetFrameMilliseconds(uint64_t* resolvedFrames) const
+	{
+		std::lock_guard<std::mutex> lock(resultsMutex);
+		if (resolvedFrames != nullptr)
+			*resolvedFrames = this->resolvedFrames;
+
+		return frameMilliseconds;
+	}
+
+	void GpuProfiler::DrawImGui() const
+	{
+		std::string title = "GPU " + name;
+		if (!ImGui::Begin(title.c_str()))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!IsEnabled())
+		{
+			ImGui::Text("Timestamps are not supported on this queue.");
+			ImGui::End();
+			return;
+		}
+
+		// If this is close to the CPU frame time we're GPU bound, if it's much lower the CPU is holding things up.
+		float gpuFrame = 0.0f;
+		std::vector<GpuPassTiming> passes = GetResults(&gpuFrame);
+		ImGui::Text("GPU frame: %.3f ms", gpuFrame);
+
+		if (ImGui::BeginTable("Passes", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("Pass");
+			ImGui::TableSetupColumn("ms");
+			ImGui::TableSetupColumn("Vertex invocations");
+			ImGui::TableSetupColumn("Fragment invocations");
+			ImGui::TableHeadersRow();
+
+			for (const auto& pass : passes)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", pass.name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", pass.milliseconds);
+				ImGui::TableNextColumn();
+				if (pass.hasStatistics)
+					ImGui::Text("%llu", (unsigned long long)pass.vertexInvocations);
+				else
+					ImGui::TextDisabled("n/a");
+				ImGui::TableNextColumn();
+				if (pass.hasStatistics)
+					ImGui::Text("%llu", (unsigned long long)pass.fragmentInvocations);
+				else
+					ImGui::TextDisabled("n/a");
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+}
@@ -0,0 +1,236 @@
+#include "Otter/Rendering/Ktx2.hpp"
+#include "Otter/Utilities/AtomicFile.hpp"
+#include "loguru.hpp"
+#include <cstring>
+#include <numeric>
+
+namespace Otter::Rendering
+{
+	const char* Ktx2::EXTENSION = ".ktx2";
+
+	static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };	// "«KTX 20»\r\n\x1A\n"
+
+	struct Ktx2Header
+	{
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;			// 0 for 2D images.
+		uint32_t layerCount;			// 0 when not an array.
+		uint32_t faceCount;
+		uint32_t levelCount;			// 0 asks the loader to generate the mips.
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must match the file layout");
+
+	struct Ktx2Level
+	{
+		uint64_t byteOffset;			// From the start of the file.
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	// Data format descriptor (Khronos Data Format spec, section 5), mandatory in KTX2 even though loaders mostly go by vkFormat.
+	enum : uint8_t
+	{
+		DF_MODEL_RGBSDA = 1,
+		DF_MODEL_BC1A = 128,
+		DF_MODEL_BC3 = 130,
+		DF_MODEL_BC5 = 132,
+		DF_MODEL_BC7 = 134,
+		DF_PRIMARIES_BT709 = 1,
+		DF_TRANSFER_LINEAR = 1,
+		DF_TRANSFER_SRGB = 2,
+		DF_CHANNEL_ALPHA = 15,
+		DF_SAMPLE_LINEAR = 0x10,	// Qualifier on an sRGB format's alpha channel, which isn't sRGB encoded.
+	};
+
+	struct DfdSample
+	{
+		uint8_t channel;
+		uint16_t bitOffset;
+		uint8_t bitLength;
+		uint32_t upper;
+	};
+
+	static std::vector<uint32_t> BuildDataFormatDescriptor(VkFormat format)
+	{
+		bool srgb = format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+			format == VK_FORMAT_BC3_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+
+		uint8_t model = DF_MODEL_RGBSDA;
+		std::vector<DfdSample> samples;
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			samples = { { 0, 0, 8, 255 }, { 1, 8, 8, 255 }, { 2, 16, 8, 255 }, { DF_CHANNEL_ALPHA, 24, 8, 255 } };
+			break;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = DF_MODEL_BC1A;
+			samples = { { 0, 0, 64, UINT32_MAX } };		// Color.
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			model = DF_MODEL_BC1A;
+			samples = { { 1, 0, 64, UINT32_MAX } };		// Color with punch-through alpha.
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			model = DF_MODEL_BC3;
+			samples = { { DF_CHANNEL_ALPHA, 0, 64, UINT32_MAX }, { 0, 64, 64, UINT32_MAX } };
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			model = DF_MODEL_BC5;
+			samples = { { 0, 0, 64, UINT32_MAX }, { 1, 64, 64, UINT32_MAX } };	// Red, green.
+			break;
+		default:	// BC7
+			model = DF_MODEL_BC7;
+			samples = { { 0, 0, 128, UINT32_MAX } };
+			break;
+		}
+
+		uint32_t blockDimension = IsBlockCompressed(format) ? 3 | (3 << 8) : 0;	// Minus one, per axis.
+		uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+		std::vector<uint32_t> words = {
+			4 + blockSize,											// Total size, including this word.
+			0,														// Vendor (Khronos), descriptor type (basic).
+			2 | (blockSize << 16),									// Version, block size.
+			static_cast<uint32_t>(model | (DF_PRIMARIES_BT709 << 8) | ((srgb ? DF_TRANSFER_SRGB : DF_TRANSFER_LINEAR) << 16)),	// Straight alpha.
+			blockDimension,
+			GetTexelBlockBytes(format),								// Bytes in plane 0.
+			0
+		};
+
+		for (const DfdSample& sample : samples)
+		{
+			uint8_t channel = sample.channel;
+			if (srgb && channel == DF_CHANNEL_ALPHA && model == DF_MODEL_RGBSDA)
+				channel |= DF_SAMPLE_LINEAR;
+			words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (static_cast<uint32_t>(channel) << 24));
+			words.push_back(0);				// Sample position.
+			words.push_back(0);				// Lower.
+			words.push_back(sample.upper);
+		}
+		return words;
+	}
+
+	static uint64_t AlignUp(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	bool Ktx2::IsSupportedFormat(VkFormat format)
+	{
+		return GetTexelBlockBytes(format) != 0;
+	}
+
+	bool Ktx2::Load(const std::filesystem::path& path, DecodedImage& image)
+	{
+		auto file = std::make_shared<MappedFile>();
+		if (!file->Open(path))
+			return false;
+
+		// Like cooked meshes, everything is checked against the file size. A bad file is a miss, the source image is used instead.
+		const uint8_t* data = file->GetData();
+		size_t size = file->GetSize();
+		if (size < sizeof(Ktx2Header) || std::memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		{
+			LOG_F(WARNING, "Ignoring %s, it is not a KTX2 file", path.string().c_str());
+			return false;
+		}
+
+		const Ktx2Header* header = reinterpret_cast<const Ktx2Header*>(data);
+		VkFormat format = static_cast<VkFormat>(header->vkFormat);
+		if (!IsSupportedFormat(format) || header->supercompressionScheme != 0 || header->pixelWidth == 0 || header->pixelHeight == 0 ||
+			header->pixelDepth != 0 || header->layerCount > 1 || header->faceCount != 1)
+		{
+			LOG_F(WARNING, "Ignoring %s, only uncompressed 2D RGBA8 or BC1/3/5/7 KTX2 files are supported", path.string().c_str());
+			return false;
+		}
+
+		Vec2D imageSize = { static_cast<int>(header->pixelWidth), static_cast<int>(header->pixelHeight) };
+		uint32_t levelCount = std::max(header->levelCount, 1u);
+		if (levelCount > GetMipLevelCount(imageSize) || sizeof(Ktx2Header) + levelCount * sizeof(Ktx2Level) > size)
+		{
+			LOG_F(WARNING, "Ignoring %s, its level index is malformed", path.string().c_str());
+			return false;
+		}
+
+		// Levels are stored smallest first, so the data of the whole chain is one range ending with the largest level.
+		const Ktx2Level* levels = reinterpret_cast<const Ktx2Level*>(data + sizeof(Ktx2Header));
+		uint64_t begin = UINT64_MAX;
+		uint64_t end = 0;
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			if (levels[level].byteOffset + levels[level].byteLength > size || levels[level].byteLength < GetImageBytes(format, GetMipLevelSize(imageSize, level)))
+			{
+				LOG_F(WARNING, "Ignoring %s, it is truncated", path.string().c_str());
+				return false;
+			}
+			begin = std::min(begin, levels[level].byteOffset);
+			end = std::max(end, levels[level].byteOffset + levels[level].byteLength);
+		}
+
+		image = DecodedImage();
+		image.format = format;
+		image.size = imageSize;
+		for (uint32_t level = 0; level < levelCount; level++)
+			image.levels.push_back({ static_cast<size_t>(levels[level].byteOffset - begin), GetMipLevelSize(imageSize, level) });
+		image.cookedOffset = static_cast<size_t>(begin);
+		image.cookedSize = static_cast<size_t>(end - begin);
+		image.cookedFile = std::move(file);
+		return true;
+	}
+
+	bool Ktx2::Store(const std::filesystem::path& path, const DecodedImage& image)
+	{
+		VkFormat format = image.format;
+		const std::vector<MipLevel>& levels = image.levels;
+		if (!IsSupportedFormat(format) || levels.empty())
+			return false;
+
+		std::vector<uint32_t> dfd = BuildDataFormatDescriptor(format);
+
+		Ktx2Header header{};
+		std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+		header.vkFormat = static_cast<uint32_t>(format);
+		header.typeSize = 1;	// 8 bit channels, and what the spec asks for block compressed formats.
+		header.pixelWidth = static_cast<uint32_t>(image.size.x);
+		header.pixelHeight = static_cast<uint32_t>(image.size.y);
+		header.faceCount = 1;
+		header.levelCount = static_cast<uint32_t>(levels.size());
+		header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + levels.size() * sizeof(Ktx2Level));
+		header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+		// Levels go smallest first, each aligned to a whole number of blocks and to 4 bytes.
+		uint64_t alignment = std::lcm<uint64_t>(GetTexelBlockBytes(format), 4);
+		std::vector<Ktx2Level> index(levels.size());
+		uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			uint64_t levelBytes = GetImageBytes(format, levels[level].size);
+			offset = AlignUp(offset, alignment);
+			index[level] = { offset, levelBytes, levelBytes };
+			offset += levelBytes;
+		}
+
+		std::vector<FileChunk> chunks = {
+			{ 0, &header, sizeof(header) },
+			{ sizeof(header), index.data(), index.size() * sizeof(Ktx2Level) },
+			{ header.dfdByteOffset, dfd.data(), dfd.size() * sizeof(uint32_t) }
+		};
+		for (size_t level = levels.size(); level-- > 0;)
+			chunks.push_back({ index[level].byteOffset, image.GetData() + levels[level].offset, static_cast<size_t>(index[level].byteLength) });
+		return WriteFileAtomically(path, chunks);
+	}
+}
@@ -0,0 +1,180 @@
+#include "Otter/Rendering/MeshCache.hpp"
+#include "Otter/Utilities/AtomicFile.hpp"
+#include "Otter/Utilities/MD5.hpp"
+#include "loguru.hpp"
+
+namespace Otter::Rendering
+{
+	static const uint32_t COOKED_MESH_MAGIC = 0x4853454D;	// "MESH"
+	static const size_t SECTION_ALIGNMENT = 16;
+
+	struct CookedBounds
+	{
+		float min[3];
+		float max[3];
+	};
+
+	struct CookedMeshHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexType;		// VkIndexType
+		uint32_t indexCount;
+		uint32_t subMeshCount;
+		uint32_t reserved;
+		CookedBounds bounds;
+		uint64_t subMeshOffset;	// In bytes, from the start of the file.
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+	};
+
+	struct CookedSubMesh
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t materialIndex;
+		uint32_t reserved;
+		CookedBounds bounds;
+	};
+
+	static size_t AlignUp(size_t offset)
+	{
+		return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+	}
+
+	static CookedBounds ToCooked(const Bounds& bounds)
+	{
+		return { { bounds.min.x, bounds.min.y, bounds.min.z }, { bounds.max.x, bounds.max.y, bounds.max.z } };
+	}
+
+	static Bounds FromCooked(const CookedBounds& bounds)
+	{
+		return { glm::vec3(bounds.min[0], bounds.min[1], bounds.min[2]), glm::vec3(bounds.max[0], bounds.max[1], bounds.max[2]) };
+	}
+
+	template<typename Index>
+	static bool IndicesInRange(const uint8_t* data, uint32_t indexCount, uint32_t vertexCount)
+	{
+		const Index* indices = reinterpret_cast<const Index*>(data);
+		for (uint32_t i = 0; i < indexCount; i++)
+			if (indices[i] >= vertexCount)
+				return false;
+
+		return true;
+	}
+
+	std::string MeshCache::GetKey(const MappedFile& source, uint32_t importFlags)
+	{
+		uint32_t settings[] = { importFlags, VERSION, static_cast<uint32_t>(sizeof(GpuVertex)) };
+
+		MD5 hash;
+		hash.update(source.GetData(), static_cast<MD5::size_type>(source.GetSize()));
+		hash.update(reinterpret_cast<const unsigned char*>(settings), sizeof(settings));
+		hash.finalize();
+		return hash.hexdigest();
+	}
+
+	bool MeshCache::Load(const std::string& key, MeshData& mesh)
+	{
+		auto file = std::make_shared<MappedFile>();
+		if (!file->Open(GetPath(key)))
+			return false;
+
+		// Everything is checked against the file size and the header, a truncated, damaged or foreign file is treated as a miss and cooked again.
+		const uint8_t* data = file->GetData();
+		size_t size = file->GetSize();
+		if (size < sizeof(CookedMeshHeader))
+			return false;
+
+		const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(data);
+		if (header->magic != COOKED_MESH_MAGIC || header->version != VERSION || header->vertexStride != sizeof(GpuVertex))
+		{
+			LOG_F(WARNING, "Ignoring cooked mesh %s, it was written by a different version", key.c_str());
+			return false;
+		}
+
+		if (header->indexType != VK_INDEX_TYPE_UINT16 && header->indexType != VK_INDEX_TYPE_UINT32)
+		{
+			LOG_F(WARNING, "Ignoring cooked mesh %s, it is damaged", key.c_str());
+			return false;
+		}
+
+		size_t indexSize = header->indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2;
+		if (header->subMeshOffset % SECTION_ALIGNMENT != 0 || header->vertexOffset % SECTION_ALIGNMENT != 0 || header->indexOffset % SECTION_ALIGNMENT != 0 ||
+			header->subMeshOffset > size || header->vertexOffset > size || header->indexOffset > size ||
+			header->subMeshCount * sizeof(CookedSubMesh) > size - header->subMeshOffset ||
+			static_cast<uint64_t>(header->vertexCount) * sizeof(GpuVertex) > size - header->vertexOffset ||
+			static_cast<uint64_t>(header->indexCount) * indexSize > size - header->indexOffset)
+		{
+			LOG_F(WARNING, "Ignoring cooked mesh %s, it is truncated", key.c_str());
+			return false;
+		}
+
+		// The data goes straight to the GPU, an index past the vertex data or a submesh past the index data would read out of bounds there.
+		const CookedSubMesh* subMeshes = reinterpret_cast<const CookedSubMesh*>(data + header->subMeshOffset);
+		bool valid = header->indexType == VK_INDEX_TYPE_UINT32 ?
+			IndicesInRange<uint32_t>(data + header->indexOffset, header->indexCount, header->vertexCount) :
+			IndicesInRange<uint16_t>(data + header->indexOffset, header->indexCount, header->vertexCount);
+		for (uint32_t i = 0; i < header->subMeshCount && valid; i++)
+			valid = static_cast<uint64_t>(subMeshes[i].firstIndex) + subMeshes[i].indexCount <= header->indexCount;
+
+		if (!valid)
+		{
+			LOG_F(WARNING, "Ignoring cooked mesh %s, it is damaged", key.c_str());
+			return false;
+		}
+
+		mesh = MeshData();
+		mesh.vertexCount = header->vertexCount;
+		mesh.indexType = static_cast<VkIndexType>(header->indexType);
+		mesh.indexCount = header->indexCount;
+		mesh.bounds = FromCooked(header->bounds);
+
+		mesh.subMeshes.reserve(header->subMeshCount);
+		for (uint32_t i = 0; i < header->subMeshCount; i++)
+			mesh.subMeshes.push_back({ subMeshes[i].firstIndex, subMeshes[i].indexCount, subMeshes[i].materialIndex, FromCooked(subMeshes[i].bounds) });
+
+		mesh.cookedVertexOffset = static_cast<size_t>(header->vertexOffset);
+		mesh.cookedIndexOffset = static_cast<size_t>(header->indexOffset);
+		mesh.cookedFile = std::move(file);
+		return true;
+	}
+
+	bool MeshCache::Store(const std::string& key, const MeshData& mesh)
+	{
+		CookedMeshHeader header{};
+		header.magic = COOKED_MESH_MAGIC;
+		header.version = VERSION;
+		header.vertexStride = sizeof(GpuVertex);
+		header.vertexCount = mesh.vertexCount;
+		header.indexType = static_cast<uint32_t>(mesh.indexType);
+		header.indexCount = mesh.indexCount;
+		header.subMeshCount = static_cast<uint32_t>(mesh.subMeshes.size());
+		header.bounds = ToCooked(mesh.bounds);
+		header.subMeshOffset = AlignUp(sizeof(CookedMeshHeader));
+		header.vertexOffset = AlignUp(header.subMeshOffset + header.subMeshCount * sizeof(CookedSubMesh));
+		header.indexOffset = AlignUp(header.vertexOffset + mesh.GetVertexBytes());
+
+		std::vector<CookedSubMesh> subMeshes;
+		subMeshes.reserve(mesh.subMeshes.size());
+		for (const SubMesh& subMesh : mesh.subMeshes)
+			subMeshes.push_back({ subMesh.firstIndex, subMesh.indexCount, subMesh.materialIndex, 0, ToCooked(subMesh.bounds) });
+
+		return WriteFileAtomically(GetPath(key), {
+			{ 0, &header, sizeof(header) },
+			{ header.subMeshOffset, subMeshes.data(), subMeshes.size() * sizeof(CookedSubMesh) },
+			{ header.vertexOffset, mesh.GetVertexData(), mesh.GetVertexBytes() },
+			{ header.indexOffset, mesh.GetIndexData(), mesh.GetIndexBytes() }
+		});
+	}
+
+	std::filesystem::path MeshCache::GetPath(const std::string& key)
+	{
+		std::filesystem::path path("CookedMeshes/");
+		std::error_code error;
+		std::filesystem::create_directories(path, error);
+		return path / (key + ".mesh");
+	}
+}
@@ -0,0 +1,290 @@
+#include "Otter/Rendering/MeshOptimizer.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Otter::Rendering
+{
+	static const uint32_t SCORING_CACHE_SIZE = 32;	// Bigger than most real caches, the scores only need the relative order right.
+	static const uint32_t CLUSTER_CACHE_SIZE = 16;
+	static const float MIN_QUANTIZATION_EXTENT = 1e-6f;	// Flat meshes would otherwise divide by zero.
+
+	static float GetVertexScore(int cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		// The last triangle's vertices get a fixed score, so the next triangle doesn't simply repeat two of them.
+		float score = 0.0f;
+		if (cachePosition >= 0)
+			score = cachePosition < 3 ? 0.75f : std::pow(1.0f - (cachePosition - 3) / float(SCORING_CACHE_SIZE - 3), 1.5f);
+
+		// Vertices with few triangles left are finished first, so they don't end up as lone triangles later.
+		return score + 2.0f / std::sqrt(float(remainingTriangles));
+	}
+
+	// Transforms each triangle costs with a FIFO cache, which is roughly what GPUs have.
+	static void SimulateCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>& triangleMisses)
+	{
+		std::vector<uint32_t> cachedAt(vertexCount, 0);	// Time stamp of when the vertex entered the cache, 0 if never.
+		uint32_t time = cacheSize + 1;
+		triangleMisses.assign(indexCount / 3, 0);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t vertex = indices[i];
+			if (time - cachedAt[vertex] > cacheSize)
+			{
+				cachedAt[vertex] = time++;
+				triangleMisses[i / 3]++;
+			}
+		}
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		// Triangles of each vertex, the first remainingTriangles[v] entries are the ones not emitted yet.
+		std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; i++)
+			remainingTriangles[indices[i]]++;
+
+		std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			firstTriangle[v + 1] = firstTriangle[v] + remainingTriangles[v];
+
+		std::vector<uint32_t> vertexTriangles(indexCount);
+		std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+			vertexTriangles[filled[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+			vertexScore[v] = GetVertexScore(-1, remainingTriangles[v]);
+
+		std::vector<float> triangleScore(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		for (size_t t = 0; t < triangleCount; t++)
+			triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		uint32_t cache[SCORING_CACHE_SIZE + 3];
+		uint32_t cacheCount = 0;
+		size_t nextUnemitted = 0;
+		size_t best = std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin();
+
+		while (result.size() < indexCount)
+		{
+			// Nothing in the cache has triangles left, start over at the first triangle not emitted yet.
+			if (best == triangleCount)
+			{
+				while (emitted[nextUnemitted])
+					nextUnemitted++;
+				best = nextUnemitted;
+			}
+
+			const uint32_t* triangle = &indices[best * 3];
+			emitted[best] = true;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertex = triangle[corner];
+				result.push_back(vertex);
+
+				uint32_t* begin = &vertexTriangles[firstTriangle[vertex]];
+				uint32_t* end = begin + remainingTriangles[vertex];
+				uint32_t* found = std::find(begin, end, static_cast<uint32_t>(best));
+				if (found != end)
+				{
+					std::swap(*found, *(end - 1));
+					remainingTriangles[vertex]--;
+				}
+			}
+
+			// The triangle's vertices move to the front of the LRU cache, whatever falls off the end leaves it.
+			uint32_t newCache[SCORING_CACHE_SIZE + 3] = { triangle[0], triangle[1], triangle[2] };
+			uint32_t newCount = 3;
+			for (uint32_t i = 0; i < cacheCount; i++)
+				if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+					newCache[newCount++] = cache[i];
+
+			for (uint32_t i = 0; i < newCount; i++)
+			{
+				uint32_t vertex = newCache[i];
+				cachePosition[vertex] = i < SCORING_CACHE_SIZE ? static_cast<int>(i) : -1;
+				float score = GetVertexScore(cachePosition[vertex], remainingTriangles[vertex]);
+				float delta = score - vertexScore[vertex];
+				vertexScore[vertex] = score;
+				for (uint32_t t = 0; t < remainingTriangles[vertex]; t++)
+					triangleScore[vertexTriangles[firstTriangle[vertex] + t]] += delta;
+			}
+
+			cacheCount = std::min(newCount, SCORING_CACHE_SIZE);
+			std::copy(newCache, newCache + cacheCount, cache);
+
+			// Only triangles of cached vertices changed score, the best next one is among them.
+			best = triangleCount;
+			float bestScore = -1.0f;
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				uint32_t vertex = cache[i];
+				for (uint32_t t = 0; t < remainingTriangles[vertex]; t++)
+				{
+					uint32_t candidate = vertexTriangles[firstTriangle[vertex] + t];
+					if (triangleScore[candidate] > bestScore)
+					{
+						bestScore = triangleScore[candidate];
+						best = candidate;
+					}
+				}
+			}
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount, float threshold)
+	{
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		// Hard boundaries: triangles missing on all three vertices, the cache has nothing to lose there.
+		std::vector<uint32_t> triangleMisses;
+		SimulateCache(indices, indexCount, vertexCount, CLUSTER_CACHE_SIZE, triangleMisses);
+
+		std::vector<size_t> hardClusters;
+		for (size_t t = 0; t < triangleCount; t++)
+			if (t == 0 || triangleMisses[t] == 3)
+				hardClusters.push_back(t);
+		hardClusters.push_back(triangleCount);
+
+		// Soft boundaries: split a hard cluster further wherever its miss ratio so far is within threshold of the whole cluster's.
+		std::vector<size_t> clusters;
+		for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+		{
+			size_t start = hardClusters[c], end = hardClusters[c + 1];
+			uint32_t clusterMisses = 0;
+			for (size_t t = start; t < end; t++)
+				clusterMisses += triangleMisses[t];
+			float clusterRatio = clusterMisses / float(end - start);
+
+			clusters.push_back(start);
+			uint32_t misses = 0;
+			size_t softStart = start;
+			for (size_t t = start; t < end; t++)
+			{
+				misses += triangleMisses[t];
+				if (t + 1 < end && misses <= clusterRatio * threshold * (t + 1 - softStart) && triangleMisses[t + 1] >= 2)
+				{
+					clusters.push_back(t + 1);
+					softStart = t + 1;
+					misses = 0;
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+
+		// Sort clusters by how far out and outward facing they are, relative to the middle of the mesh.
+		glm::vec3 meshCenter(0.0f);
+		float meshArea = 0.0f;
+		std::vector<glm::vec3> clusterCenters(clusters.size() - 1, glm::vec3(0.0f));
+		std::vector<glm::vec3> clusterNormals(clusters.size() - 1, glm::vec3(0.0f));
+		std::vector<float> clusterAreas(clusters.size() - 1, 0.0f);
+		for (size_t c = 0; c + 1 < clusters.size(); c++)
+		{
+			for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+			{
+				const glm::vec3& a = vertices[indices[t * 3]].pos;
+				const glm::vec3& b = vertices[indices[t * 3 + 1]].pos;
+				const glm::vec3& d = vertices[indices[t * 3 + 2]].pos;
+				glm::vec3 normal = glm::cross(b - a, d - a);	// Length is twice the area.
+				float area = glm::length(normal);
+				clusterCenters[c] += (a + b + d) * (area / 3.0f);
+				clusterNormals[c] += normal;
+				clusterAreas[c] += area;
+			}
+
+			meshCenter += clusterCenters[c];
+			meshArea += clusterAreas[c];
+			clusterCenters[c] = clusterAreas[c] > 0.0f ? clusterCenters[c] / clusterAreas[c] : vertices[indices[clusters[c] * 3]].pos;
+			float normalLength = glm::length(clusterNormals[c]);
+			clusterNormals[c] = normalLength > 0.0f ? clusterNormals[c] / normalLength : glm::vec3(0.0f);
+		}
+		if (meshArea > 0.0f)
+			meshCenter /= meshArea;
+
+		std::vector<float> sortKeys(clusters.size() - 1);
+		for (size_t c = 0; c < sortKeys.size(); c++)
+			sortKeys[c] = glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c]);
+
+		std::vector<size_t> order(sortKeys.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		for (size_t c : order)
+			result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, uint32_t* indices, size_t indexCount)
+	{
+		std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+		std::vector<Vertex> result;
+		result.reserve(vertices.size());
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t& newIndex = remap[indices[i]];
+			if (newIndex == UINT32_MAX)
+			{
+				newIndex = static_cast<uint32_t>(result.size());
+				result.push_back(vertices[indices[i]]);
+			}
+			indices[i] = newIndex;
+		}
+		vertices.swap(result);
+	}
+
+	float MeshOptimizer::GetAverageCacheMissRatio(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		if (indexCount < 3)
+			return 0.0f;
+
+		std::vector<uint32_t> triangleMisses;
+		SimulateCache(indices, indexCount, vertexCount, cacheSize, triangleMisses);
+		return std::accumulate(triangleMisses.begin(), triangleMisses.end(), 0u) / float(triangleMisses.size());
+	}
+
+	QuantizedVertex MeshOptimizer::QuantizeVertex(const Vertex& vertex, const Bounds& bounds)
+	{
+		glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+		glm::vec3 halfExtent = glm::max((bounds.max - bounds.min) * 0.5f, glm::vec3(MIN_QUANTIZATION_EXTENT));
+		glm::vec3 position = (vertex.pos - center) / halfExtent;
+
+		QuantizedVertex quantized{};
+		for (int i = 0; i < 3; i++)
+		{
+			quantized.pos[i] = static_cast<int16_t>(glm::packSnorm1x16(position[i]));
+			quantized.color[i] = static_cast<uint8_t>(std::lround(glm::clamp(vertex.color[i], 0.0f, 1.0f) * 255.0f));
+		}
+		quantized.pos[3] = INT16_MAX;
+		quantized.color[3] = UINT8_MAX;
+		quantized.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+		quantized.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+		return quantized;
+	}
+
+	glm::mat4 MeshOptimizer::GetDequantizeTransform(const Bounds& bounds)
+	{
+		glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+		glm::vec3 halfExtent = glm::max((bounds.max - bounds.min) * 0.5f, glm::vec3(MIN_QUANTIZATION_EXTENT));
+		return glm::scale(glm::translate(glm::mat4(1.0f), center), halfExtent);
+	}
+}
@@ -0,0 +1,178 @@
+#include "Otter/Rendering/PipelineCache.hpp"
+#include "Otter/Rendering/RenderTypes.hpp"
+#include "Otter/Utilities/AtomicFile.hpp"
+#include "Otter/Utilities/MappedFile.hpp"
+#include "Otter/Utilities/MD5.hpp"
+#include "loguru.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace Otter::Rendering
+{
+	static const uint32_t PIPELINE_CACHE_MAGIC = 0x45504950;	// "PIPE"
+
+	// Ours, in front of the driver's data. The driver's own header says much the same, but it's only trusted once this matches.
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint32_t reserved;
+		uint64_t dataSize;
+		char checksum[32];		// MD5 of the driver's data, as hex.
+	};
+
+	static std::string GetChecksum(const uint8_t* data, size_t size)
+	{
+		MD5 hash;
+		hash.update(data, static_cast<MD5::size_type>(size));
+		hash.finalize();
+		return hash.hexdigest();
+	}
+
+	void PipelineCache::Create(VkDevice device, const VkPhysicalDeviceProperties& properties)
+	{
+		this->device = device;
+		this->properties = properties;
+
+		MappedFile file;
+		const uint8_t* initialData = nullptr;
+		size_t initialSize = 0;
+		savedChecksum.clear();
+		if (file.Open(GetPath()) && IsValid(file.GetData(), file.GetSize()))
+		{
+			initialData = file.GetData() + sizeof(PipelineCacheFileHeader);
+			initialSize = file.GetSize() - sizeof(PipelineCacheFileHeader);
+			const PipelineCacheFileHeader* header = reinterpret_cast<const PipelineCacheFileHeader*>(file.GetData());
+			savedChecksum.assign(header->checksum, sizeof(header->checksum));	// IsValid checked it against the data.
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = initialSize;
+		cacheInfo.pInitialData = initialData;
+		VkResult result = vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache);
+		if (result != VK_SUCCESS && initialData != nullptr)
+		{
+			LOG_F(WARNING, "The driver rejected the pipeline cache, starting an empty one");
+			cacheInfo.initialDataSize = 0;
+			cacheInfo.pInitialData = nullptr;
+			initialSize = 0;
+			savedChecksum.clear();
+			result = vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache);
+		}
+		check_vk_result(result);
+
+		if (initialSize > 0)
+			LOG_F(INFO, "Pipeline cache seeded with %.1f KiB", initialSize / 1024.0f);
+	}
+
+	void PipelineCache::Destroy()
+	{
+		if (cache == VK_NULL_HANDLE)
+			return;
+
+		if (pendingSave.valid())
+			pendingSave.wait();
+		Save();
+		vkDestroyPipelineCache(device, cache, nullptr);
+		cache = VK_NULL_HANDLE;
+		device = VK_NULL_HANDLE;
+		savedChecksum.clear();
+	}
+
+	void PipelineCache::SaveInBackground(ThreadPool& threadPool)
+	{
+		if (cache == VK_NULL_HANDLE || (pendingSave.valid() && pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+			return;	// What it misses is saved by the next one, or by Destroy.
+
+		pendingSave = threadPool.Submit([this]() { return Save(); });
+	}
+
+	bool PipelineCache::Save()
+	{
+		if (cache == VK_NULL_HANDLE)
+			return false;
+
+		size_t size = 0;
+		VkResult result = vkGetPipelineCacheData(device, cache, &size, nullptr);
+		if (result != VK_SUCCESS || size == 0)
+			return result == VK_SUCCESS;
+
+		// It may grow between the two calls, VK_INCOMPLETE then still leaves a valid, shorter cache in data.
+		std::vector<uint8_t> data(size);
+		result = vkGetPipelineCacheData(device, cache, &size, data.data());
+		if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+			return false;
+
+		PipelineCacheFileHeader header{};
+		header.magic = PIPELINE_CACHE_MAGIC;
+		header.version = VERSION;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = size;
+		std::string checksum = GetChecksum(data.data(), size);
+		if (checksum == savedChecksum)
+			return true;	// Nothing new since the last load or save.
+		std::memcpy(header.checksum, checksum.data(), sizeof(header.checksum));
+
+		if (!WriteFileAtomically(GetPath(), { { 0, &header, sizeof(header) }, { sizeof(header), data.data(), size } }))
+			return false;
+
+		savedChecksum = checksum;
+		return true;
+	}
+
+	std::filesystem::path PipelineCache::GetPath() const
+	{
+		std::filesystem::path path("CachedPipelines/");
+		std::error_code error;
+		std::filesystem::create_directories(path, error);
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%04x-%04x.bin", properties.vendorID, properties.deviceID);
+		return path / name;
+	}
+
+	bool PipelineCache::IsValid(const uint8_t* data, size_t size) const
+	{
+		if (size < sizeof(PipelineCacheFileHeader))
+			return false;
+
+		const PipelineCacheFileHeader* header = reinterpret_cast<const PipelineCacheFileHeader*>(data);
+		if (header->magic != PIPELINE_CACHE_MAGIC || header->version != VERSION)
+			return false;
+
+		// A driver update invalidates everything in the cache, that's a miss, not a warning.
+		if (header->vendorID != properties.vendorID || header->deviceID != properties.deviceID || header->driverVersion != properties.driverVersion ||
+			std::memcmp(header->pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			LOG_F(INFO, "Ignoring the pipeline cache, it was written by another driver");
+			return false;
+		}
+
+		const uint8_t* cacheData = data + sizeof(PipelineCacheFileHeader);
+		size_t cacheSize = size - sizeof(PipelineCacheFileHeader);
+		if (header->dataSize != cacheSize || std::memcmp(header->checksum, GetChecksum(cacheData, cacheSize).data(), sizeof(header->checksum)) != 0)
+		{
+			LOG_F(WARNING, "Ignoring the pipeline cache, it is truncated or damaged");
+			return false;
+		}
+
+		// The driver's header, which it would check itself. Done here as well, some drivers crash rather than reject foreign data.
+		VkPipelineCacheHeaderVersionOne driverHeader;
+		if (cacheSize < sizeof(driverHeader))
+			return false;
+		std::memcpy(&driverHeader, cacheData, sizeof(driverHeader));
+		return driverHeader.headerSize >= sizeof(driverHeader) && driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			driverHeader.vendorID == properties.vendorID && driverHeader.deviceID == properties.deviceID &&
+			std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
@@ -0,0 +1,1777 @@
+#include "Otter/Rendering/RenderDevice.hpp"
+#include "Otter/Core/FrameArena.hpp"
+#include "Otter/Core/Profiler.hpp"
+#include "Otter/Rendering/MeshOptimizer.hpp"
+#include "Otter/Rendering/TextureCache.hpp"
+#include "Otter/Utilities/ShaderUtilities.hpp"
+#include "loguru.hpp"
+#include "SDL_vulkan.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <assimp/Importer.hpp>      // C++ importer interface
+#include <assimp/scene.h>           // Output data structure
+#include <assimp/postprocess.h>     // Post processing flags
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace Otter::Rendering
+{
+	static const VkDeviceSize BAR_HEAP_BYTES = 256ull * 1024 * 1024;	// The host visible window into VRAM without resizable BAR.
+	static const uint64_t STREAMING_UPLOAD_BYTES = 32ull * 1024 * 1024;	// Per frame, so a burst of finished loads is spread over a few frames instead of one long one.
+	static const uint32_t MAX_TEXTURE_TABLE_SIZE = 4096;	// Resident textures at once. Unused slots cost a few bytes of descriptor memory each.
+
+	static std::string GetShaderPath(const std::string& shader)
+	{
+		return "Assets/Shaders/" + shader + "/" + shader;
+	}
+
+	static VKAPI_ATTR VkBool32 VKAPI_CALL vkDebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData)
+	{
+		LOG_F(ERROR, "[vulkan] validation layer: %s", pCallbackData->pMessage);
+        return VK_FALSE;
+    }
+
+	RenderDevice::RenderDevice(std::string applicationName)
+	{
+		this->applicationName = applicationName;
+	}
+
+	RenderDevice::~RenderDevice()
+	{
+		if (initialized)
+			LOG_F(WARNING, "RenderDevice was not shut down before destruction.");
+	}
+
+	bool RenderDevice::Initialize(SDL_Window* window, VkSurfaceKHR& surface)
+	{
+		if(!CreateVulkanInstance(window))
+		{
+			LOG_F(ERROR, "Failed to create vulkan instance");
+			return false;
+		}
+
+		surface = CreateSurface(window);
+		return InitializeDevice(surface);
+	}
+
+	bool RenderDevice::InitializeHeadless()
+	{
+		headless = true;
+		if(!CreateVulkanInstance(nullptr))
+		{
+			LOG_F(ERROR, "Failed to create vulkan instance");
+			return false;
+		}
+
+		return InitializeDevice(VK_NULL_HANDLE);
+	}
+
+	bool RenderDevice::InitializeDevice(VkSurfaceKHR surface)
+	{
+		SelectPhysicalDevice(surface);
+		DetectUnifiedMemory();
+		CreateLogicalDevice();
+		CreateAllocator();
+		pipelineCache.Create(logicalDevice, properties);
+		std::mutex& uploadQueueMutex = transferQueue == graphicsQueue ? queueMutex : transferQueueMutex;
+		uploadBatcher.Create(logicalDevice, allocator, queueFamilies.transferFamily.value(), transferQueue, uploadQueueMutex);
+		if (transferQueue != graphicsQueue)
+			uploadBatcher.SetBlitQueue(queueFamilies.graphicsFamily.value(), graphicsQueue, queueMutex);
+
+		// Tells when the frames that might still use an unloaded asset are done, without waiting on each renderer's fences.
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+		VkResult result = vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &frameSemaphore);
+		check_vk_result(result);
+		frameValue = 0;
+
+		geometryArena.Create(allocator, sizeof(GpuVertex), unifiedMemory, uploadQueueFamilies);
+
+		depthFormat = FindDepthFormat();
+		CreateDescriptorSetLayout();
+		CreateTextureSampler();
+		CreateTextureTable();
+		CreatePipelineLayout();
+		CreatePlaceholders();
+
+		initialized = true;
+		return true;
+	}
+
+	void RenderDevice::Shutdown()
+	{
+		if (!initialized)
+			return;
+
+		WaitIdle();
+
+		// Workers never touch the device, unclaimed prefetches can simply be dropped.
+		pendingShaders.clear();
+		pendingTextures.clear();
+		pendingMeshes.clear();
+		RetireReleases(true);
+
+		for (auto& pair : graphicsPipelines)
+			vkDestroyPipeline(logicalDevice, pair.second, nullptr);
+		graphicsPipelines.clear();
+		pipelineCache.Destroy();	// Saves whatever ImGui and the others added since the last pipeline here.
+
+		for (auto& pair : renderPasses)
+			vkDestroyRenderPass(logicalDevice, pair.second, nullptr);
+		renderPasses.clear();
+
+		for (auto& pair : shaderModules)
+			vkDestroyShaderModule(logicalDevice, pair.second, nullptr);
+		shaderModules.clear();
+
+		for (auto& pair : textures)
+		{
+			vkDestroyImageView(logicalDevice, pair.second.view, nullptr);
+			vmaDestroyImage(allocator, pair.second.image, pair.second.allocation);
+		}
+		textures.clear();
+		vkDestroyImageView(logicalDevice, placeholderTexture.view, nullptr);
+		vmaDestroyImage(allocator, placeholderTexture.image, placeholderTexture.allocation);
+		placeholderTexture = {};
+
+		meshes.clear();
+		placeholderMesh = {};
+		streamedAssets.clear();
+		geometryArena.Destroy();
+		residentAssetBytes = 0;
+
+		vkDestroyDescriptorPool(logicalDevice, textureTablePool, nullptr);	// Frees the table along with it.
+		vkDestroyDescriptorSetLayout(logicalDevice, textureTableLayout, nullptr);
+		textureTable = VK_NULL_HANDLE;
+		textureTableUsed = 0;
+		freeTextureSlots.clear();
+
+		vkDestroySampler(logicalDevice, textureSampler, nullptr);
+		vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
+		uploadBatcher.Destroy();
+		vkDestroySemaphore(logicalDevice, frameSemaphore, nullptr);
+		frameSemaphore = VK_NULL_HANDLE;
+		vmaDestroyAllocator(allocator);
+		vkDestroyDevice(logicalDevice, nullptr);
+		vkDestroyInstance(vulkanInstance, nullptr);
+
+		logicalDevice = VK_NULL_HANDLE;
+		vulkanInstance = VK_NULL_HANDLE;
+		initialized = false;
+		headless = false;
+	}
+
+	VkDeviceSize RenderDevice::GetAllocatedBytes() const
+	{
+		if (allocator == VK_NULL_HANDLE)
+			return 0;
+
+		const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+		vmaGetMemoryProperties(allocator, &memoryProperties);
+
+		std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+		vmaGetHeapBudgets(allocator, budgets.data());
+
+		VkDeviceSize total = 0;
+		for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+			total += budgets[i].statistics.allocationBytes;
+		return total;
+	}
+
+	uint64_t RenderDevice::FlushUploads()
+	{
+		return uploadBatcher.Flush();
+	}
+
+	uint64_t RenderDevice::NextFrameValue()
+	{
+		return ++frameValue;
+	}
+
+	void RenderDevice::WaitIdle()
+	{
+		// Recorded but unsubmitted uploads may still reference what the caller is about to destroy.
+		uploadBatcher.Flush();
+		std::lock_guard<std::mutex> lock(queueMutex);
+		std::lock_guard<std::mutex> transferLock(transferQueueMutex);
+		VkResult err = vkDeviceWaitIdle(logicalDevice);
+		check_vk_result(err);
+	}
+
+	VkSurfaceKHR RenderDevice::CreateSurface(SDL_Window* window)
+	{
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
+		if (headless)
+		{
+			LOG_F(ERROR, "Can't create a surface for window '%s', the render device was initialized headless", SDL_GetWindowTitle(window));
+			return surface;
+		}
+
+		SDL_bool result = SDL_Vulkan_CreateSurface(window, vulkanInstance, &surface);
+		if(!result)
+			LOG_F(ERROR, "Failed to create surface: %s", SDL_GetError());
+
+		assert(result);
+
+		// The device was picked for the first window's surface, make sure the present queue works for this one too.
+		if (physicalDevice != VK_NULL_HANDLE)
+		{
+			VkBool32 presentSupport = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamilies.presentFamily.value(), surface, &presentSupport);
+			if (!presentSupport)
+				LOG_F(ERROR, "Present queue family %u can not present to the surface of window '%s'", queueFamilies.presentFamily.value(), SDL_GetWindowTitle(window));
+		}
+
+		return surface;
+	}
+
+	bool RenderDevice::CreateVulkanInstance(SDL_Window* window)
+	{
+		//AppInfo
+		VkApplicationInfo appInfo{};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = applicationName.c_str();
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "Otter";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = VK_API_VERSION_1_3;
+
+		//CreateInfo
+		VkInstanceCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInfo.pApplicationInfo = &appInfo;
+
+        auto extensions = GetRequiredExtensions(window);
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+        if (enableValidationLayers) {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(requiredValidationLayers.size());
+            createInfo.ppEnabledLayerNames = requiredValidationLayers.data();
+
+            PopulateDebugMessengerCreateInfo(debugCreateInfo);
+            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugCreateInfo;
+        } else {
+            createInfo.enabledLayerCount = 0;
+
+            createInfo.pNext = nullptr;
+        }
+
+		VkResult result = vkCreateInstance(&createInfo, nullptr, &vulkanInstance);
+		check_vk_result(result);
+
+		return result == VK_SUCCESS;
+	}
+
+	VkResult RenderDevice::CreateDebugUtilsMessengerEXT(VkInstance vulkanInstance, const VkDebugUtilsMessengerCreateInfoEXT* createInfo, const VkAllocationCallbacks* allocator, VkDebugUtilsMessengerEXT* debugMessenger)
+	{
+		auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(vulkanInstance, "vkCreateDebugUtilsMessengerEXT");
+		if (func != nullptr) {
+			return func(vulkanInstance, createInfo, allocator, debugMessenger);
+		} else {
+			return VK_ERROR_EXTENSION_NOT_PRESENT;
+		}
+	}
+
+	void RenderDevice::DestroyDebugUtilsMessengerEXT(VkInstance vulkanInstance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* allocator)
+	{
+		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(vulkanInstance, "vkDestroyDebugUtilsMessengerEXT");
+		if (func != nullptr) {
+			func(vulkanInstance, debugMessenger, allocator);
+		}
+	}
+
+	bool RenderDevice::CheckValidationLayerSupport()
+	{
+        uint32_t layerCount;
+        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+        std::vector<VkLayerProperties> availableLayers(layerCount);
+        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+        for (const char* layerName : requiredValidationLayers) {
+            bool layerFound = false;
+
+            for (const auto& layerProperties : availableLayers) {
+                if (strcmp(layerName, layerProperties.layerName) == 0) {
+                    layerFound = true;
+                    break;
+                }
+            }
+
+            if (!layerFound) {
+                return false;
+            }
+        }
+
+        return true;
+	}
+
+	std::vector<const char*> RenderDevice::GetRequiredExtensions(SDL_Window* window)
+	{
+		// Headless, we don't need any surface extensions, nor SDL's video subsystem to tell us which.
+		if (window == nullptr)
+			return {};
+
+		unsigned int extensionCount = 0;
+		SDL_Vulkan_GetInstanceExtensions(window, &extensionCount, nullptr);
+		std::vector<const char *> extensionNames(extensionCount);
+		SDL_Vulkan_GetInstanceExtensions(window, &extensionCount, extensionNames.data());
+
+        return extensionNames;
+	}
+
+	void RenderDevice::PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
+	{
+        createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+        createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        createInfo.pfnUserCallback = vkDebugCallback;
+	}
+
+	void RenderDevice::SetupDebugMessenger()
+	{
+        if (!enableValidationLayers)
+			return;
+
+        VkDebugUtilsMessengerCreateInfoEXT createInfo;
+        PopulateDebugMessengerCreateInfo(createInfo);
+
+        VkResult result = CreateDebugUtilsMessengerEXT(vulkanInstance, &createInfo, nullptr, &debugMessenger);
+		check_vk_result(result);
+	}
+
+	void RenderDevice::SelectPhysicalDevice(VkSurfaceKHR surface)
+	{
+		uint32_t gpuCount;
+		VkResult err = vkEnumeratePhysicalDevices(vulkanInstance, &gpuCount, NULL);
+		check_vk_result(err);
+		assert(gpuCount > 0);	//TODO make custom macro with std::runtime_error and Loguru.
+
+		// Scratch lists, from the frame arena rather than the heap.
+		std::pmr::vector<VkPhysicalDevice> gpus(gpuCount, FrameArenas::GetResource());
+		err = vkEnumeratePhysicalDevices(vulkanInstance, &gpuCount, gpus.data());
+		check_vk_result(err);
+		assert(err == VK_SUCCESS);
+
+		std::pmr::vector<VkPhysicalDevice> suitableGpus(FrameArenas::GetResource());
+		for (const auto gpu : gpus)
+			if (IsPhysicalDeviceSuitable(gpu, surface))
+				suitableGpus.push_back(gpu);
+		assert(suitableGpus.size() > 0);
+
+		// If a number >1 of GPUs got reported, find discrete GPU if present, or use first one available. This covers
+		// most common cases (multi-gpu/integrated+dedicated graphics). Handling more complicated setups (multiple
+		// dedicated GPUs) is out of scope of this sample.
+		int useGpu = 0;
+		for (int i = 0; i < suitableGpus.size(); i++)
+		{
+			VkPhysicalDeviceProperties gpuProperties;
+			vkGetPhysicalDeviceProperties(suitableGpus[i], &gpuProperties);
+			if (gpuProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+			{
+				useGpu = i;
+				break;
+			}
+		}
+		physicalDevice = suitableGpus[useGpu];
+		assert(physicalDevice != VK_NULL_HANDLE);
+
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		queueFamilies = FindQueueFamilies(physicalDevice, surface);
+		LOG_F(INFO, "Using GPU %s", properties.deviceName);
+	}
+
+	bool RenderDevice::IsPhysicalDeviceSuitable(VkPhysicalDevice gpu, VkSurfaceKHR surface)
+	{
+		QueueFamilyIndices indices = FindQueueFamilies(gpu, surface);
+
+		bool extensionsSupported = HasDeviceExtensionSupport(gpu);
+
+		bool swapChainAdequate = surface == VK_NULL_HANDLE;
+		if (extensionsSupported && surface != VK_NULL_HANDLE)
+		{
+			uint32_t formatCount = 0, presentModeCount = 0;
+			vkGetPhysicalDeviceSurfaceFormatsKHR(gpu, surface, &formatCount, nullptr);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(gpu, surface, &presentModeCount, nullptr);
+			swapChainAdequate = formatCount > 0 && presentModeCount > 0;
+		}
+
+		VkPhysicalDeviceFeatures supportedFeatures;
+    	vkGetPhysicalDeviceFeatures(gpu, &supportedFeatures);
+
+		// Timeline semaphores (frames and uploads) are core, and always supported, from 1.2 on. Descriptor indexing is core there too, but optional.
+		VkPhysicalDeviceProperties gpuProperties;
+		vkGetPhysicalDeviceProperties(gpu, &gpuProperties);
+		bool apiVersionSupported = gpuProperties.apiVersion >= VK_API_VERSION_1_2 && HasDescriptorIndexingSupport(gpu);
+
+		return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && apiVersionSupported;
+	}
+
+	bool RenderDevice::HasDeviceExtensionSupport(VkPhysicalDevice gpu)
+	{
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionCount, nullptr);
+
+		std::pmr::vector<VkExtensionProperties> availableExtensions(extensionCount, FrameArenas::GetResource());
+		vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionCount, availableExtensions.data());
+
+		// Every required extension has to be in the list the device reports.
+		for (const char* required : GetRequiredDeviceExtensions())
+		{
+			auto matches = [required](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, required) == 0; };
+			if (std::none_of(availableExtensions.begin(), availableExtensions.end(), matches))
+				return false;
+		}
+
+		return true;
+	}
+
+	std::vector<const char*> RenderDevice::GetRequiredDeviceExtensions() const
+	{
+		if (headless)
+			return {};	// Swap chains are all we need extensions for so far.
+
+		return requiredPhysicalDeviceExtensions;
+	}
+
+	QueueFamilyIndices RenderDevice::FindQueueFamilies(VkPhysicalDevice gpu, VkSurfaceKHR surface)
+	{
+		QueueFamilyIndices indices;
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, nullptr);
+
+		std::pmr::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount, FrameArenas::GetResource());
+		vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, queueFamilyProperties.data());
+
+		// Find at least one queue family that supports Graphics.
+		int i = 0;
+		for (const auto& queueFamily : queueFamilyProperties)
+		{
+			VkBool32 presentSupport = false;
+			if (surface != VK_NULL_HANDLE)
+				vkGetPhysicalDeviceSurfaceSupportKHR(gpu, i, surface, &presentSupport);
+			if (presentSupport)
+				indices.presentFamily = i;
+
+			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+				indices.graphicsFamily = i;
+
+			i++;
+		}
+
+		// Nothing to present to, the "present" queue is only used for queue bookkeeping.
+		if (surface == VK_NULL_HANDLE)
+			indices.presentFamily = indices.graphicsFamily;
+
+		// A family that can only copy usually maps to a DMA engine, which runs uploads next to rendering.
+		for (uint32_t family = 0; family < queueFamilyCount; family++)
+		{
+			VkQueueFlags flags = queueFamilyProperties[family].queueFlags;
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				indices.transferFamily = family;
+				break;
+			}
+		}
+		if (!indices.transferFamily.has_value())
+			indices.transferFamily = indices.graphicsFamily;
+
+		return indices;
+	}
+
+	void RenderDevice::DetectUnifiedMemory()
+	{
+		/*
+			Integrated GPUs and software rasterizers (lavapipe) have one pool of memory, all of it device local and mappable.
+			Discrete GPUs with resizable BAR expose all of VRAM to the CPU as well. Staging there only doubles the memory traffic.
+			Without resizable BAR the mappable part of VRAM is a small window, meant for per-frame data rather than assets.
+		*/
+		VkPhysicalDeviceMemoryProperties memory;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memory);
+
+		unifiedMemory = false;
+		VkDeviceSize mappableBytes = 0;
+		for (uint32_t i = 0; i < memory.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = memory.memoryTypes[i].propertyFlags;
+			VkDeviceSize heapSize = memory.memoryHeaps[memory.memoryTypes[i].heapIndex].size;
+			if ((flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) && (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && heapSize > BAR_HEAP_BYTES)
+			{
+				unifiedMemory = true;
+				mappableBytes = std::max(mappableBytes, heapSize);
+			}
+		}
+
+		if (unifiedMemory)
+			LOG_F(INFO, "Unified memory: %.0f MiB of device-local memory is host visible, uploads skip staging", mappableBytes / (1024.0f * 1024.0f));
+	}
+
+	bool RenderDevice::HasSampledFormatSupport(VkFormat format)
+	{
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+		VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (formatProperties.optimalTilingFeatures & required) == required;
+	}
+
+	bool RenderDevice::HasLinearBlitSupport(VkFormat format)
+	{
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+		VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (formatProperties.optimalTilingFeatures & required) == required;
+	}
+
+	bool RenderDevice::HasDescriptorIndexingSupport(VkPhysicalDevice gpu)
+	{
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &vulkan12Features;
+		vkGetPhysicalDeviceFeatures2(gpu, &features);
+
+		return vulkan12Features.runtimeDescriptorArray && vulkan12Features.descriptorBindingPartiallyBound &&
+			vulkan12Features.descriptorBindingSampledImageUpdateAfterBind && vulkan12Features.descriptorBindingUpdateUnusedWhilePending;
+	}
+
+	bool RenderDevice::HasHostImageCopySupport()
+	{
+	#ifdef VK_EXT_host_image_copy
+		if (properties.apiVersion < VK_API_VERSION_1_3)
+			return false;
+
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::pmr::vector<VkExtensionProperties> availableExtensions(extensionCount, FrameArenas::GetResource());
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+		auto matches = [](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0; };
+		if (std::none_of(availableExtensions.begin(), availableExtensions.end(), matches))
+			return false;
+
+		VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+		hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &hostImageCopyFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+		if (!hostImageCopyFeatures.hostImageCopy)
+			return false;
+
+		// We copy straight into the layout shaders sample from, which the driver has to allow.
+		VkPhysicalDeviceHostImageCopyPropertiesEXT copyProperties{};
+		copyProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &copyProperties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+		std::pmr::vector<VkImageLayout> dstLayouts(copyProperties.copyDstLayoutCount, FrameArenas::GetResource());
+		copyProperties.pCopyDstLayouts = dstLayouts.data();
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+		if (std::find(dstLayouts.begin(), dstLayouts.end(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) == dstLayouts.end())
+			return false;
+
+		VkFormatProperties3 formatProperties3{};
+		formatProperties3.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3;
+		VkFormatProperties2 formatProperties{};
+		formatProperties.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2;
+		formatProperties.pNext = &formatProperties3;
+		vkGetPhysicalDeviceFormatProperties2(physicalDevice, VK_FORMAT_R8G8B8A8_SRGB, &formatProperties);
+		return (formatProperties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+	#else
+		return false;	// Vulkan headers older than the extension.
+	#endif
+	}
+
+	void RenderDevice::CreateLogicalDevice()
+	{
+		// Specify queues to be created alongside the device.
+		assert(physicalDevice != VK_NULL_HANDLE);
+
+		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+		std::set<uint32_t> uniqueQueueFamilies = {queueFamilies.graphicsFamily.value(), queueFamilies.presentFamily.value(), queueFamilies.transferFamily.value()};
+
+		float queuePriority = 1.0f;
+		for (uint32_t queueFamily : uniqueQueueFamilies)
+		{
+			VkDeviceQueueCreateInfo queueCreateInfo{};
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueFamilyIndex = queueFamily;
+			queueCreateInfo.queueCount = 1;
+			queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfos.push_back(queueCreateInfo);
+		}
+
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+		VkPhysicalDeviceFeatures deviceFeatures{};
+		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;	// Optional, only used by the GPU profiler.
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;	// Optional, cooked textures fall back to their source image without it.
+		enabledFeatures = deviceFeatures;
+
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+		vulkan12Features.runtimeDescriptorArray = VK_TRUE;	// The texture table, see CreateTextureTable.
+		vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		std::vector<const char*> deviceExtensions = GetRequiredDeviceExtensions();
+
+		// On a discrete GPU the CPU would copy textures over PCIe itself, staging lets the copy engine do that.
+		hostImageCopy = unifiedMemory && HasHostImageCopySupport();
+	#ifdef VK_EXT_host_image_copy
+		VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+		hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+		hostImageCopyFeatures.hostImageCopy = VK_TRUE;
+		if (hostImageCopy)
+		{
+			vulkan12Features.pNext = &hostImageCopyFeatures;
+			deviceExtensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+		}
+	#endif
+
+		// Create the logical device.
+		VkDeviceCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = &vulkan12Features;
+		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+		createInfo.pQueueCreateInfos = queueCreateInfos.data();
+		createInfo.pEnabledFeatures = &deviceFeatures;
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		createInfo.enabledLayerCount = 0;	// Validation layers are disabled on application level currently.
+
+		VkResult result = vkCreateDevice(physicalDevice, &createInfo, nullptr, &logicalDevice);
+		check_vk_result(result);
+
+	#ifdef VK_EXT_host_image_copy
+		if (hostImageCopy)
+		{
+			copyMemoryToImage = (PFN_vkCopyMemoryToImageEXT) vkGetDeviceProcAddr(logicalDevice, "vkCopyMemoryToImageEXT");
+			transitionImageLayout = (PFN_vkTransitionImageLayoutEXT) vkGetDeviceProcAddr(logicalDevice, "vkTransitionImageLayoutEXT");
+			hostImageCopy = copyMemoryToImage != nullptr && transitionImageLayout != nullptr;
+		}
+	#endif
+		if (hostImageCopy)
+			LOG_F(INFO, "Textures are written with host image copies");
+
+		// After creation, get a reference to our queues.
+		vkGetDeviceQueue(logicalDevice, queueFamilies.graphicsFamily.value(), 0, &graphicsQueue);
+		vkGetDeviceQueue(logicalDevice, queueFamilies.presentFamily.value(), 0, &presentQueue);
+		vkGetDeviceQueue(logicalDevice, queueFamilies.transferFamily.value(), 0, &transferQueue);
+
+		uploadQueueFamilies.clear();
+		if (queueFamilies.transferFamily != queueFamilies.graphicsFamily)
+			uploadQueueFamilies = { queueFamilies.graphicsFamily.value(), queueFamilies.transferFamily.value() };
+		LOG_F(INFO, "Uploading on queue family %u%s", queueFamilies.transferFamily.value(), uploadQueueFamilies.empty() ? " (graphics)" : " (transfer only)");
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::pmr::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount, FrameArenas::GetResource());
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+		timestampValidBits = queueFamilyProperties[queueFamilies.graphicsFamily.value()].timestampValidBits;
+	}
+
+	void RenderDevice::CreateAllocator()
+	{
+		VmaAllocatorCreateInfo allocatorCreateInfo{};
+		allocatorCreateInfo.flags = 0;
+		allocatorCreateInfo.physicalDevice = physicalDevice;
+		allocatorCreateInfo.device = logicalDevice;
+		allocatorCreateInfo.instance = vulkanInstance;
+		VkResult result = vmaCreateAllocator(&allocatorCreateInfo, &allocator);
+		check_vk_result(result);
+	}
+
+	void RenderDevice::CreateDescriptorSetLayout()
+	{
+		VkDescriptorSetLayoutBinding uboLayoutBinding{};
+		uboLayoutBinding.binding = 0;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorCount = 1;
+		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
+
+		// Textures aren't per frame, they're in the texture table.
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &uboLayoutBinding;
+
+		VkResult result = vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &descriptorSetLayout);
+		check_vk_result(result);
+	}
+
+	void RenderDevice::CreatePipelineLayout()
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;	// The model matrix, and the texture index.
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(ObjectPushConstants);
+
+		std::array<VkDescriptorSetLayout, 2> setLayouts = { descriptorSetLayout, textureTableLayout };
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		VkResult result = vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout);
+		check_vk_result(result);
+	}
+
+	void RenderDevice::CreateTextureSampler()
+	{
+		// More info here: https://vulkan-tutorial.com/Texture_mapping/Image_view_and_sampler#page_Samplers
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;	// Each texture's view limits it to the levels it has.
+
+		VkResult result = vkCreateSampler(logicalDevice, &samplerInfo, nullptr, &textureSampler);
+		check_vk_result(result);
+	}
+
+	void RenderDevice::CreateTextureTable()
+	{
+		// One set for every texture, so switching textures between draws is a push constant instead of a descriptor set bind.
+		// Update after bind lets slots be written while command buffers using the table are recorded or in flight, partially bound
+		// lets the slots nothing uses yet stay empty.
+		VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+		vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &vulkan12Properties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+		textureTableSize = std::min({ MAX_TEXTURE_TABLE_SIZE,
+			vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+			vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages, vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers });
+
+		VkDescriptorSetLayoutBinding tableBinding{};
+		tableBinding.binding = 0;
+		tableBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		tableBinding.descriptorCount = textureTableSize;
+		tableBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = 1;
+		bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &tableBinding;
+		VkResult result = vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &textureTableLayout);
+		check_vk_result(result);
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = textureTableSize;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		result = vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &textureTablePool);
+		check_vk_result(result);
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = textureTablePool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &textureTableLayout;
+		result = vkAllocateDescriptorSets(logicalDevice, &allocInfo, &textureTable);
+		check_vk_result(result);
+
+		LOG_F(INFO, "Texture table has %u slots", textureTableSize);
+	}
+
+	void RenderDevice::WriteTextureSlot(uint32_t slot, VkImageView view)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = view;
+		imageInfo.sampler = textureSampler;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = textureTable;
+		descriptorWrite.dstBinding = 0;
+		descriptorWrite.dstArrayElement = slot;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrite, 0, nullptr);
+	}
+
+	VkShaderModule RenderDevice::GetShaderModule(const std::string& path)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		auto it = shaderModules.find(path);
+		if (it != shaderModules.end())
+			return it->second;
+
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+		auto pending = pendingShaders.find(path);
+		if (pending != pendingShaders.end())
+		{
+			std::vector<uint32_t> shaderCode = pending->second.get();
+			pendingShaders.erase(pending);
+			if (!shaderCode.empty())
+				shaderModule = ShaderUtilities::CreateShaderModule(shaderCode, path, logicalDevice);
+		}
+		else
+			shaderModule = ShaderUtilities::LoadShaderModule(path, logicalDevice);
+
+		if (shaderModule != VK_NULL_HANDLE)
+			shaderModules[path] = shaderModule;
+
+		return shaderModule;
+	}
+
+	VkRenderPass RenderDevice::GetRenderPass(VkFormat colorFormat)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		auto it = renderPasses.find(colorFormat);
+		if (it != renderPasses.end())
+			return it->second;
+
+	    VkAttachmentDescription colorAttachment{};
+		colorAttachment.format = colorFormat;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;	// Headless images may be read back.
+
+		VkAttachmentReference colorAttachmentRef{};
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthAttachmentRef{};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		VkSubpassDependency dependency{};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &dependency;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkResult result = vkCreateRenderPass(logicalDevice, &renderPassInfo, nullptr, &renderPass);
+		check_vk_result(result);
+
+		renderPasses[colorFormat] = renderPass;
+		return renderPass;
+	}
+
+	VkPipeline RenderDevice::GetGraphicsPipeline(const std::string& shader, VkFormat colorFormat)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		auto key = std::make_pair(shader, colorFormat);
+		auto it = graphicsPipelines.find(key);
+		if (it != graphicsPipelines.end())
+			return it->second;
+
+		std::string shaderPath = GetShaderPath(shader);
+		VkShaderModule vert = GetShaderModule(shaderPath + ".vert");
+		VkShaderModule frag = GetShaderModule(shaderPath + ".frag");
+		if(vert == VK_NULL_HANDLE || frag == VK_NULL_HANDLE)
+			return VK_NULL_HANDLE;
+
+		VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		vertShaderStageInfo.module = vert;
+		vertShaderStageInfo.pName = "main";
+
+		VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		fragShaderStageInfo.module = frag;
+		fragShaderStageInfo.pName = "main";
+
+		VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
+		// Fixed functions of render pipeline
+		auto bindingDescription = GpuVertex::getBindingDescription();
+		auto attributeDescriptions = GpuVertex::getAttributeDescriptions();
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		// Viewport and scissor are set while recording (see Renderer::RecordCommandBuffer), only their count is baked in.
+		VkPipelineViewportStateCreateInfo viewportState{};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		// The rasterizer takes the geometry that is shaped by the vertices from the vertex shader and turns it into fragments to be colored by the fragment shader.
+		// It also performs depth testing, face culling and the scissor test, and it can be configured to output fragments that fill entire polygons or just the edges (wireframe rendering).
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizer.depthBiasEnable = VK_FALSE;
+		rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+		rasterizer.depthBiasClamp = 0.0f; // Optional
+		rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+
+		// AA method, currently disabled.
+		VkPipelineMultisampleStateCreateInfo multisampling{};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		multisampling.minSampleShading = 1.0f; // Optional
+		multisampling.pSampleMask = nullptr; // Optional
+		multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+		multisampling.alphaToOneEnable = VK_FALSE; // Optional
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+
+		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+		colorBlending.blendConstants[0] = 0.0f; // Optional
+		colorBlending.blendConstants[1] = 0.0f; // Optional
+		colorBlending.blendConstants[2] = 0.0f; // Optional
+		colorBlending.blendConstants[3] = 0.0f; // Optional
+
+		// Dynamic States - A limited amount of the state that we've specified in the previous structs can actually be changed without recreating the pipeline
+		std::vector<VkDynamicState> dynamicStates = {
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
+		};
+
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+		dynamicState.pDynamicStates = dynamicStates.data();
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = VK_TRUE;
+		depthStencil.depthWriteEnable = VK_TRUE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.minDepthBounds = 0.0f; // Optional
+		depthStencil.maxDepthBounds = 1.0f; // Optional
+		depthStencil.stencilTestEnable = VK_FALSE;
+		depthStencil.front = {}; // Optional
+		depthStencil.back = {}; // Optional
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = shaderStages;
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.renderPass = GetRenderPass(colorFormat);
+		pipelineInfo.subpass = 0;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+		pipelineInfo.basePipelineIndex = -1; // Optional
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkResult result = vkCreateGraphicsPipelines(logicalDevice, pipelineCache.GetHandle(), 1, &pipelineInfo, nullptr, &pipeline);
+		check_vk_result(result);
+
+		// Saved now rather than only at shutdown, so a run that doesn't end cleanly keeps them. On a worker, not to add to the hitch.
+		pipelineCache.SaveInBackground(threadPool);
+		graphicsPipelines[key] = pipeline;
+		return pipeline;
+	}
+
+	const Texture& RenderDevice::GetTexture(const std::string& path)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		auto it = textures.find(path);
+		if (it != textures.end())
+			return it->second;
+
+		auto pending = pendingTextures.find(path);
+		if (pending != pendingTextures.end())
+		{
+			textures[path] = CreateTextureImage(pending->second.get());
+			pendingTextures.erase(pending);
+		}
+		else
+			textures[path] = CreateTextureImage(DecodeTextureImage(path));
+
+		return textures[path];
+	}
+
+	const Mesh& RenderDevice::LoadMesh(const std::string& path)
+	{
+		// Every window and entity referencing the same mesh shares one import and one range of the geometry arena.
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		Mesh& mesh = meshes[path];
+		if (mesh.IsResident())
+			return mesh;
+
+		auto pending = pendingMeshes.find(path);
+		if (pending != pendingMeshes.end())
+		{
+			UploadMesh(pending->second.get(), mesh);
+			pendingMeshes.erase(pending);
+		}
+		else
+			UploadMesh(ImportMesh(path), mesh);
+
+		return mesh;
+	}
+
+	void RenderDevice::UnloadMesh(const std::string& path)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		pendingMeshes.erase(path);
+		auto it = meshes.find(path);
+		if (it == meshes.end() || !it->second.IsResident())
+			return;
+
+		const MeshDraw& draw = it->second.GetDraw();
+		residentAssetBytes -= static_cast<uint64_t>(it->second.vertexCount) * sizeof(GpuVertex) + draw.indexCount * (draw.indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2);
+		PendingRelease release;
+		release.geometry = it->second.geometry;
+		DeferRelease(std::move(release));
+		it->second.geometry = {};
+		it->second.vertexCount = 0;
+	}
+
+	void RenderDevice::UnloadTexture(const std::string& path)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		pendingTextures.erase(path);
+		auto it = textures.find(path);
+		if (it == textures.end())
+			return;
+
+		residentAssetBytes -= it->second.GetBytes();
+		PendingRelease release;
+		release.texture = it->second;
+		DeferRelease(std::move(release));
+		textures.erase(it);
+	}
+
+	void RenderDevice::ReleaseUnloaded()
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		RetireReleases(false);
+	}
+
+	void RenderDevice::DeferRelease(PendingRelease release)
+	{
+		// Recorded but unsubmitted uploads may still write it, the flush gives them a value to wait for.
+		release.frameValue = frameValue;
+		release.uploadValue = uploadBatcher.Flush();
+		pendingReleases.push_back(std::move(release));
+	}
+
+	void RenderDevice::RetireReleases(bool all)
+	{
+		if (pendingReleases.empty())
+			return;
+
+		uint64_t completedFrame = 0, completedUpload = 0;
+		if (!all)
+		{
+			VkResult result = vkGetSemaphoreCounterValue(logicalDevice, frameSemaphore, &completedFrame);
+			check_vk_result(result);
+			result = vkGetSemaphoreCounterValue(logicalDevice, uploadBatcher.GetSemaphore(), &completedUpload);
+			check_vk_result(result);
+		}
+
+		while (!pendingReleases.empty())
+		{
+			PendingRelease& release = pendingReleases.front();
+			if (!all && (release.frameValue > completedFrame || release.uploadValue > completedUpload))
+				break;
+
+			geometryArena.Free(release.geometry);
+			Texture& texture = release.texture;
+			if (texture.image != VK_NULL_HANDLE)
+			{
+				// No submitted frame samples the slot anymore. It gets the placeholder rather than a destroyed view until it's reused.
+				if (texture.textureIndex != placeholderTexture.textureIndex)
+				{
+					WriteTextureSlot(texture.textureIndex, placeholderTexture.view);
+					freeTextureSlots.push_back(texture.textureIndex);
+				}
+				vkDestroyImageView(logicalDevice, texture.view, nullptr);
+				vmaDestroyImage(allocator, texture.image, texture.allocation);
+			}
+			pendingReleases.pop_front();
+		}
+	}
+
+	const Mesh& RenderDevice::StreamMesh(const std::string& path)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		const Mesh& mesh = meshes[path];
+		if (!mesh.IsResident())
+			PrefetchMesh(path);
+		return mesh;
+	}
+
+	const Texture& RenderDevice::StreamTexture(const std::string& path)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		auto it = textures.find(path);
+		if (it != textures.end())
+			return it->second;
+
+		PrefetchTexture(path);
+		return placeholderTexture;
+	}
+
+	void RenderDevice::UpdateStreaming()
+	{
+		OTTER_PROFILE_SCOPE("RenderDevice::UpdateStreaming");
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		streamedAssets.clear();
+
+		// Finished loads only, nothing here waits on a worker.
+		uint64_t uploaded = 0;
+		for (auto it = pendingMeshes.begin(); it != pendingMeshes.end() && uploaded < STREAMING_UPLOAD_BYTES;)
+		{
+			if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			const MeshData& data = it->second.get();
+			uploaded += data.GetVertexBytes() + data.GetIndexBytes();
+			UploadMesh(data, meshes[it->first]);
+			streamedAssets.push_back(it->first);
+			it = pendingMeshes.erase(it);
+		}
+
+		for (auto it = pendingTextures.begin(); it != pendingTextures.end() && uploaded < STREAMING_UPLOAD_BYTES;)
+		{
+			if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			const DecodedImage& image = it->second.get();
+			uploaded += image.GetSize();
+			textures[it->first] = CreateTextureImage(image);
+			streamedAssets.push_back(it->first);
+			it = pendingTextures.erase(it);
+		}
+
+		// Gets the copies going now rather than when the first renderer submits.
+		if (!streamedAssets.empty())
+			uploadBatcher.Flush();
+	}
+
+	void RenderDevice::PrefetchShader(const std::string& path, std::shared_ptr<StartupTimeline> timeline)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		if (shaderModules.find(path) != shaderModules.end() || pendingShaders.find(path) != pendingShaders.end())
+			return;
+
+		pendingShaders[path] = threadPool.Submit([path, timeline]()
+		{
+			StartupTimeline::Clock::time_point start = StartupTimeline::Clock::now();
+			std::vector<uint32_t> shaderCode;
+			if (!ShaderUtilities::LoadShaderCode(path, shaderCode))
+				shaderCode.clear();
+
+			if (timeline)
+				timeline->Record("Load shader " + path, start, StartupTimeline::Clock::now());
+			return shaderCode;
+		}).share();
+	}
+
+	void RenderDevice::PrefetchGraphicsPipeline(const std::string& shader, std::shared_ptr<StartupTimeline> timeline)
+	{
+		std::string shaderPath = GetShaderPath(shader);
+		PrefetchShader(shaderPath + ".vert", timeline);
+		PrefetchShader(shaderPath + ".frag", timeline);
+	}
+
+	void RenderDevice::PrefetchTexture(const std::string& path, std::shared_ptr<StartupTimeline> timeline)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		if (textures.find(path) != textures.end() || pendingTextures.find(path) != pendingTextures.end())
+			return;
+
+		pendingTextures[path] = threadPool.Submit([path, timeline]()
+		{
+			StartupTimeline::Clock::time_point start = StartupTimeline::Clock::now();
+			DecodedImage image = DecodeTextureImage(path);
+
+			if (timeline)
+				timeline->Record("Decode texture " + path, start, StartupTimeline::Clock::now());
+			return image;
+		}).share();
+	}
+
+	void RenderDevice::PrefetchMesh(const std::string& path, std::shared_ptr<StartupTimeline> timeline)
+	{
+		std::lock_guard<std::recursive_mutex> lock(resourceMutex);
+		auto loaded = meshes.find(path);
+		if ((loaded != meshes.end() && loaded->second.IsResident()) || pendingMeshes.find(path) != pendingMeshes.end())
+			return;
+
+		pendingMeshes[path] = threadPool.Submit([path, timeline]()
+		{
+			StartupTimeline::Clock::time_point start = StartupTimeline::Clock::now();
+			MeshData mesh = ImportMesh(path);
+
+			if (timeline)
+				timeline->Record("Import mesh " + path, start, StartupTimeline::Clock::now());
+			return mesh;
+		}).share();
+	}
+
+	MeshData RenderDevice::ImportMesh(const std::string& path)
+	{
+		static const uint32_t importFlags =
+			aiProcess_Triangulate            |
+			aiProcess_JoinIdenticalVertices  |
+			aiProcess_SortByPType            |
+			aiProcess_FlipUVs;					// Vulkan's texture origin is the top left.
+
+		MappedFile source;
+		if (!source.Open(path))
+		{
+			LOG_F(ERROR, "Failed to open mesh %s", path.c_str());
+			abort();
+		}
+
+		MeshData data;
+		std::string key = MeshCache::GetKey(source, importFlags);
+		if (MeshCache::Load(key, data))
+			return data;
+
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path, importFlags);
+		if (scene == nullptr)
+		{
+			LOG_F(ERROR, "Failed to import mesh %s: %s", path.c_str(), importer.GetErrorString());
+			abort();
+		}
+
+		// All triangle meshes of the file are merged into one, each keeps a submesh. SortByPType split off points and lines, those are skipped.
+		// Each submesh is optimized on its own, so its triangles stay one contiguous range.
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> meshIndices;
+		float missRatioBefore = 0.0f, missRatioAfter = 0.0f;
+		for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+		{
+			const aiMesh* mesh = scene->mMeshes[m];
+			if ((mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0 || mesh->mNumVertices == 0)
+				continue;
+
+			SubMesh subMesh;
+			subMesh.firstIndex = static_cast<uint32_t>(indices.size());
+			subMesh.materialIndex = mesh->mMaterialIndex;
+			subMesh.bounds.min = subMesh.bounds.max = glm::vec3(mesh->mVertices[0].x, mesh->mVertices[0].y, mesh->mVertices[0].z);
+
+			uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+			for (unsigned int v = 0; v < mesh->mNumVertices; v++)
+			{
+				Vertex vertex{};
+				vertex.pos = { mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z };
+				vertex.color = mesh->HasVertexColors(0) ? glm::vec3(mesh->mColors[0][v].r, mesh->mColors[0][v].g, mesh->mColors[0][v].b) : glm::vec3(1.0f);
+				if (mesh->HasTextureCoords(0))
+					vertex.texCoord = { mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y };
+				vertices.push_back(vertex);
+				subMesh.bounds.min = glm::min(subMesh.bounds.min, vertex.pos);
+				subMesh.bounds.max = glm::max(subMesh.bounds.max, vertex.pos);
+			}
+
+			meshIndices.clear();
+			for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+				for (unsigned int i = 0; i < mesh->mFaces[f].mNumIndices; i++)
+					meshIndices.push_back(mesh->mFaces[f].mIndices[i]);
+
+			missRatioBefore += MeshOptimizer::GetAverageCacheMissRatio(meshIndices.data(), meshIndices.size(), mesh->mNumVertices) * (meshIndices.size() / 3);
+			MeshOptimizer::OptimizeVertexCache(meshIndices.data(), meshIndices.size(), mesh->mNumVertices);
+			MeshOptimizer::OptimizeOverdraw(meshIndices.data(), meshIndices.size(), &vertices[baseVertex], mesh->mNumVertices);
+			missRatioAfter += MeshOptimizer::GetAverageCacheMissRatio(meshIndices.data(), meshIndices.size(), mesh->mNumVertices) * (meshIndices.size() / 3);
+			for (uint32_t index : meshIndices)
+				indices.push_back(baseVertex + index);
+
+			subMesh.indexCount = static_cast<uint32_t>(indices.size()) - subMesh.firstIndex;
+			if (data.subMeshes.empty())
+				data.bounds = subMesh.bounds;
+			data.bounds.min = glm::min(data.bounds.min, subMesh.bounds.min);
+			data.bounds.max = glm::max(data.bounds.max, subMesh.bounds.max);
+			data.subMeshes.push_back(subMesh);
+		}
+
+		if (indices.empty())
+		{
+			LOG_F(ERROR, "Mesh %s has no triangles", path.c_str());
+			abort();
+		}
+
+		// Submeshes use disjoint vertex ranges in submesh order, renumbering by first use keeps it that way.
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices.data(), indices.size());
+		LOG_F(INFO, "Optimized mesh %s: %.2f vertices transformed per triangle, was %.2f", path.c_str(),
+			missRatioAfter / (indices.size() / 3), missRatioBefore / (indices.size() / 3));
+
+		PackMeshData(vertices, indices, data);
+		if (MeshCache::Store(key, data))
+			LOG_F(INFO, "Cooked mesh %s", path.c_str());
+		return data;
+	}
+
+	void RenderDevice::PackMeshData(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, MeshData& data)
+	{
+		data.vertexCount = static_cast<uint32_t>(vertices.size());
+	#ifdef OTTER_QUANTIZE_VERTICES
+		data.vertices.reserve(vertices.size());
+		for (const Vertex& vertex : vertices)
+			data.vertices.push_back(MeshOptimizer::QuantizeVertex(vertex, data.bounds));
+	#else
+		data.vertices = std::move(vertices);
+	#endif
+
+		data.indexCount = static_cast<uint32_t>(indices.size());
+		if (data.vertexCount <= UINT16_MAX + 1)
+		{
+			data.indexType = VK_INDEX_TYPE_UINT16;
+			data.indices.resize(indices.size() * sizeof(uint16_t));
+			uint16_t* indices16 = reinterpret_cast<uint16_t*>(data.indices.data());
+			for (size_t i = 0; i < indices.size(); i++)
+				indices16[i] = static_cast<uint16_t>(indices[i]);
+		}
+		else
+		{
+			data.indexType = VK_INDEX_TYPE_UINT32;
+			data.indices.resize(indices.size() * sizeof(uint32_t));
+			memcpy(data.indices.data(), indices.data(), data.indices.size());
+		}
+	}
+
+	DecodedImage RenderDevice::DecodeTextureImage(const std::string& path)
+	{
+		// A cooked texture next to the source image wins, it comes block compressed and with its mips.
+		DecodedImage image;
+		std::filesystem::path cookedPath(path);
+		if (cookedPath.extension() == Ktx2::EXTENSION)
+		{
+			if (!Ktx2::Load(cookedPath, image))
+			{
+				LOG_F(ERROR, "Failed to load texture image %s", path.c_str());
+				abort();
+			}
+			return image;
+		}
+
+		cookedPath.replace_extension(Ktx2::EXTENSION);
+		if (Ktx2::Load(cookedPath, image))
+		{
+			image.sourcePath = path;
+			return image;
+		}
+		return DecodeSourceImage(path);
+	}
+
+	DecodedImage RenderDevice::DecodeSourceImage(const std::string& path)
+	{
+		MappedFile source;
+		if (!source.Open(path))
+		{
+			LOG_F(ERROR, "Failed to load texture image %s", path.c_str());
+			abort();
+		}
+
+		DecodedImage image;
+		std::string key = TextureCache::GetKey(source);
+		if (TextureCache::Load(key, image))
+			return image;
+
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load_from_memory(source.GetData(), static_cast<int>(source.GetSize()), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+		if (!pixels)
+		{
+			LOG_F(ERROR, "Failed to load texture image %s", path.c_str());
+			abort();
+		}
+
+		image.size = { texWidth, texHeight };
+		image.pixels.assign(pixels, pixels + (size_t)texWidth * texHeight * 4);
+		stbi_image_free(pixels);
+
+		// On the worker thread anyway, so the mips are filtered here once and cached with the rest, instead of blitted every start.
+		TextureCache::GenerateMips(image, true);
+		if (TextureCache::Store(key, image))
+			LOG_F(INFO, "Cached decoded texture %s", path.c_str());
+		return image;
+	}
+
+	Texture RenderDevice::CreateTextureImage(const DecodedImage& image)
+	{
+		if (!HasSampledFormatSupport(image.format))
+		{
+			if (image.sourcePath.empty())
+			{
+				LOG_F(ERROR, "Failed to create a texture image, the device can't sample format %d", image.format);
+				abort();
+			}
+
+			LOG_F(WARNING, "The device can't sample the cooked format of %s, decoding it instead", image.sourcePath.c_str());
+			return CreateTextureImage(DecodeSourceImage(image.sourcePath));
+		}
+
+		Texture texture;
+		VkDeviceSize imageSize = image.GetSize();
+		uploadedBytes += imageSize;
+
+		// Without linear blits only the levels the image brings are used, the sampler's LOD range is clamped to the view.
+		// Block compressed formats never blit, they come with their mips cooked.
+		std::vector<MipLevel> levels = image.levels.empty() ? std::vector<MipLevel>{ { 0, image.size } } : image.levels;
+		uint32_t fullChain = GetMipLevelCount(image.size);
+		texture.size = image.size;
+		texture.format = image.format;
+		texture.mipLevels = HasLinearBlitSupport(texture.format) ? fullChain : std::min(static_cast<uint32_t>(levels.size()), fullChain);
+		levels.resize(std::min(static_cast<uint32_t>(levels.size()), texture.mipLevels));
+
+		residentAssetBytes += texture.GetBytes();
+
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	#ifdef VK_EXT_host_image_copy
+		if (hostImageCopy && texture.format == VK_FORMAT_R8G8B8A8_SRGB)
+			usage |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+	#endif
+
+		CreateImage(
+			texture.size,
+			texture.format,
+			VK_IMAGE_TILING_OPTIMAL,
+			usage,
+			texture.image,
+			texture.allocation,
+			uploadQueueFamilies,
+			texture.mipLevels
+		);
+
+		// Host copies can't blit and are only checked for RGBA8. Otherwise copied and made accessible to shaders with the next batch of uploads.
+		if (levels.size() < texture.mipLevels || texture.format != VK_FORMAT_R8G8B8A8_SRGB || !WriteImage(image.GetData(), texture.image, levels))
+			uploadBatcher.CopyToImage(image.GetData(), imageSize, texture.image, levels, texture.mipLevels);
+
+		texture.view = CreateImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+
+		// The placeholder comes first and takes slot 0. Once the table is full, further textures draw as the placeholder.
+		if (!freeTextureSlots.empty())
+		{
+			texture.textureIndex = freeTextureSlots.back();
+			freeTextureSlots.pop_back();
+		}
+		else if (textureTableUsed < textureTableSize)
+			texture.textureIndex = textureTableUsed++;
+		else
+		{
+			LOG_F(WARNING, "The texture table is full (%u slots), drawing with the placeholder instead", textureTableSize);
+			texture.textureIndex = placeholderTexture.textureIndex;
+			return texture;
+		}
+		WriteTextureSlot(texture.textureIndex, texture.view);
+		return texture;
+	}
+
+	void RenderDevice::CreatePlaceholders()
+	{
+		DecodedImage image;
+		image.pixels = { 160, 160, 160, 255 };
+		image.size = { 1, 1 };
+		image.levels = { { 0, image.size } };
+		placeholderTexture = CreateTextureImage(image);
+
+		std::vector<Vertex> vertices;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			Vertex vertex{};
+			vertex.pos = glm::vec3(corner & 1 ? 0.25f : -0.25f, corner & 2 ? 0.25f : -0.25f, corner & 4 ? 0.25f : -0.25f);
+			vertex.color = glm::vec3(1.0f);
+			vertex.texCoord = glm::vec2(corner & 1 ? 1.0f : 0.0f, corner & 2 ? 1.0f : 0.0f);
+			vertices.push_back(vertex);
+		}
+		std::vector<uint32_t> indices = {
+			0, 2, 1, 1, 2, 3,	// -z
+			4, 5, 6, 5, 7, 6,	// +z
+			0, 1, 4, 1, 5, 4,	// -y
+			2, 6, 3, 3, 6, 7,	// +y
+			0, 4, 2, 2, 4, 6,	// -x
+			1, 3, 5, 3, 7, 5	// +x
+		};
+
+		MeshData data;
+		data.bounds = { glm::vec3(-0.25f), glm::vec3(0.25f) };
+		data.subMeshes.push_back({ 0, static_cast<uint32_t>(indices.size()), 0, data.bounds });
+		PackMeshData(vertices, indices, data);
+		UploadMesh(data, placeholderMesh);
+	}
+
+	void RenderDevice::UploadMesh(const MeshData& data, Mesh& mesh)
+	{
+		if (!geometryArena.Allocate(data.vertexCount, data.indexCount, data.indexType, mesh.geometry))
+		{
+			LOG_F(ERROR, "Failed to allocate %u vertices and %u indices in the geometry arena", data.vertexCount, data.indexCount);
+			abort();
+		}
+
+		mesh.vertexCount = data.vertexCount;
+		residentAssetBytes += data.GetVertexBytes() + data.GetIndexBytes();
+		mesh.bounds = data.bounds;
+		mesh.subMeshes = data.subMeshes;
+	#ifdef OTTER_QUANTIZE_VERTICES
+		mesh.vertexTransform = MeshOptimizer::GetDequantizeTransform(data.bounds);
+	#endif
+
+		// For a cooked mesh these read straight from the mapped file, pages are faulted in as they're copied.
+		if (geometryArena.Write(mesh.geometry, data.GetVertexData(), data.GetVertexBytes(), data.GetIndexData(), data.GetIndexBytes()))
+		{
+			uploadedBytes += data.GetVertexBytes() + data.GetIndexBytes();
+			return;
+		}
+
+		UploadToBuffer(data.GetVertexData(), data.GetVertexBytes(), mesh.geometry.draw.vertexBuffer, mesh.geometry.vertexByteOffset);
+		UploadToBuffer(data.GetIndexData(), data.GetIndexBytes(), mesh.geometry.draw.indexBuffer, mesh.geometry.indexByteOffset);
+	}
+
+	void RenderDevice::UploadToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize offset)
+	{
+		/*
+			Load the data into GPU memory by means of
+			RAM -> Staging Buffer -> Vertex/Index Buffer.
+			Reason we use the staging buffer is because the most optimal memory for the GPU is non-accessible by the CPU (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT).
+			On unified memory (integrated GPUs, resizable BAR) that memory is mappable, and meshes and textures are written directly
+			instead, see GeometryArena::Write and WriteImage. This is the fallback for everything else.
+			More info: https://gpuopen-librariesandsdks.github.io/VulkanMemoryAllocator/html/usage_patterns.html
+			The copy is batched with others, see UploadBatcher.
+		*/
+		uploadBatcher.CopyToBuffer(data, size, buffer, offset);
+		uploadedBytes += size;
+	}
+
+	bool RenderDevice::WriteImage(const uint8_t* data, VkImage image, const std::vector<MipLevel>& levels)
+	{
+	#ifdef VK_EXT_host_image_copy
+		if (!hostImageCopy)
+			return false;
+
+		// The image is new, so nothing on the GPU can be using it while the CPU writes it.
+		VkImageSubresourceRange range{};
+		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		range.baseMipLevel = 0;
+		range.levelCount = static_cast<uint32_t>(levels.size());
+		range.baseArrayLayer = 0;
+		range.layerCount = 1;
+
+		VkHostImageLayoutTransitionInfoEXT transition{};
+		transition.sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+		transition.image = image;
+		transition.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		transition.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		transition.subresourceRange = range;
+		VkResult result = transitionImageLayout(logicalDevice, 1, &transition);
+		check_vk_result(result);
+
+		std::vector<VkMemoryToImageCopyEXT> regions(levels.size());
+		for (uint32_t level = 0; level < regions.size(); level++)
+		{
+			VkMemoryToImageCopyEXT& region = regions[level];
+			region.sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+			region.pHostPointer = data + levels[level].offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = {0, 0, 0};
+			region.imageExtent = { static_cast<uint32_t>(levels[level].size.x), static_cast<uint32_t>(levels[level].size.y), 1 };
+		}
+
+		VkCopyMemoryToImageInfoEXT copyInfo{};
+		copyInfo.sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+		copyInfo.dstImage = image;
+		copyInfo.dstImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		copyInfo.regionCount = static_cast<uint32_t>(regions.size());
+		copyInfo.pRegions = regions.data();
+		result = copyMemoryToImage(logicalDevice, &copyInfo);
+		check_vk_result(result);
+		return true;
+	#else
+		return false;
+	#endif
+	}
+
+	VkImageView RenderDevice::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspectFlags;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = mipLevels;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView imageView;
+		VkResult result = vkCreateImageView(logicalDevice, &viewInfo, nullptr, &imageView);
+		check_vk_result(result);
+
+		return imageView;
+	}
+
+	void RenderDevice::CreateImage(Vec2D size, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkImage& image, VmaAllocation& imageMemory, const std::vector<uint32_t>& sharedQueueFamilies, uint32_t mipLevels)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = static_cast<uint32_t>(size.x);
+		imageInfo.extent.height = static_cast<uint32_t>(size.y);
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = tiling;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = usage;
+		imageInfo.sharingMode = sharedQueueFamilies.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(sharedQueueFamilies.size());
+		imageInfo.pQueueFamilyIndices = sharedQueueFamilies.data();
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+		VmaAllocationCreateInfo imageAllocCreateInfo = {};
+		imageAllocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+		VmaAllocationInfo imageAllocInfo = {};
+		VkResult result = vmaCreateImage(allocator, &imageInfo, &imageAllocCreateInfo, &image, &imageMemory, &imageAllocInfo);
+		check_vk_result(result);
+	}
+
+	VkFormat RenderDevice::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
+	{
+		for (VkFormat format : candidates)
+		{
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+
+			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
+				return format;
+			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
+				return format;
+		}
+
+		LOG_F(ERROR, "failed to find supported format!");
+		abort();
+	}
+
+	VkFormat RenderDevice::FindDepthFormat()
+	{
+		if (depthFormat != VK_FORMAT_UNDEFINED)
+			return depthFormat;
+
+		return FindSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		);
+	}
+}
@@ -0,0 +1,106 @@
+#include "Otter/Rendering/TextureCache.hpp"
+#include "Otter/Utilities/MD5.hpp"
+#include <array>
+#include <cmath>
+
+namespace Otter::Rendering
+{
+	static float ToLinear(uint8_t value)
+	{
+		// Every texel of every level goes through here, a table keeps pow out of the loop.
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> result;
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				result[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return result;
+		}();
+		return table[value];
+	}
+
+	static uint8_t ToSrgb(float value)
+	{
+		float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+	}
+
+	// 2x2 box filter, an odd last row or column is reused. Averaging sRGB values directly would darken every level.
+	static void Downsample(const uint8_t* source, Vec2D sourceSize, uint8_t* destination, Vec2D size, bool srgb)
+	{
+		for (int y = 0; y < size.y; y++)
+			for (int x = 0; x < size.x; x++)
+				for (int channel = 0; channel < 4; channel++)
+				{
+					bool linear = srgb && channel < 3;
+					float sum = 0.0f;
+					for (int dy = 0; dy < 2; dy++)
+						for (int dx = 0; dx < 2; dx++)
+						{
+							int sourceX = std::min(x * 2 + dx, sourceSize.x - 1);
+							int sourceY = std::min(y * 2 + dy, sourceSize.y - 1);
+							uint8_t value = source[(static_cast<size_t>(sourceY) * sourceSize.x + sourceX) * 4 + channel];
+							sum += linear ? ToLinear(value) : value;
+						}
+
+					float average = sum / 4.0f;
+					destination[(static_cast<size_t>(y) * size.x + x) * 4 + channel] = linear ? ToSrgb(average) : static_cast<uint8_t>(average + 0.5f);
+				}
+	}
+
+	std::string TextureCache::GetKey(const MappedFile& source)
+	{
+		uint32_t settings[] = { VERSION, static_cast<uint32_t>(VK_FORMAT_R8G8B8A8_SRGB) };
+
+		MD5 hash;
+		hash.update(source.GetData(), static_cast<MD5::size_type>(source.GetSize()));
+		hash.update(reinterpret_cast<const unsigned char*>(settings), sizeof(settings));
+		hash.finalize();
+		return hash.hexdigest();
+	}
+
+	bool TextureCache::Load(const std::string& key, DecodedImage& image)
+	{
+		DecodedImage cached;
+		if (!Ktx2::Load(GetPath(key), cached) || cached.format != VK_FORMAT_R8G8B8A8_SRGB)
+			return false;
+
+		image = std::move(cached);
+		return true;
+	}
+
+	bool TextureCache::Store(const std::string& key, const DecodedImage& image)
+	{
+		return Ktx2::Store(GetPath(key), image);
+	}
+
+	void TextureCache::GenerateMips(DecodedImage& image, bool srgb)
+	{
+		uint32_t levelCount = GetMipLevelCount(image.size);
+		image.levels = { { 0, image.size } };
+		size_t bytes = GetImageBytes(VK_FORMAT_R8G8B8A8_SRGB, image.size);
+		for (uint32_t level = 1; level < levelCount; level++)
+		{
+			Vec2D size = GetMipLevelSize(image.size, level);
+			image.levels.push_back({ bytes, size });
+			bytes += GetImageBytes(VK_FORMAT_R8G8B8A8_SRGB, size);
+		}
+
+		image.pixels.resize(bytes);
+		for (uint32_t level = 1; level < levelCount; level++)
+		{
+			const MipLevel& source = image.levels[level - 1];
+			Downsample(image.pixels.data() + source.offset, source.size, image.pixels.data() + image.levels[level].offset, image.levels[level].size, srgb);
+		}
+	}
+
+	std::filesystem::path TextureCache::GetPath(const std::string& key)
+	{
+		std::filesystem::path path("CachedTextures/");
+		std::error_code error;
+		std::filesystem::create_directories(path, error);
+		return path / (key + Ktx2::EXTENSION);
+	}
+}
@@ -0,0 +1,408 @@
+#include "Otter/Rendering/UploadBatcher.hpp"
+#include "Otter/Rendering/RenderTypes.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Otter::Rendering
+{
+	static const VkDeviceSize STAGING_ALIGNMENT = 16;	// Covers the texel and block sizes image copies need their source offsets aligned to.
+
+	void UploadBatcher::Create(VkDevice device, VmaAllocator allocator, uint32_t queueFamily, VkQueue queue, std::mutex& queueMutex, VkDeviceSize ringBytes)
+	{
+		this->device = device;
+		this->allocator = allocator;
+		this->queue = queue;
+		this->queueMutex = &queueMutex;
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+		VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool);
+		check_vk_result(result);
+
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+		result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore);
+		check_vk_result(result);
+
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+		bufferInfo.size = ringBytes;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo allocCreateInfo = {};
+		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		VmaAllocationInfo allocInfo = {};
+		result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &ring, &ringAllocation, &allocInfo);
+		check_vk_result(result);
+
+		ringData = static_cast<uint8_t*>(allocInfo.pMappedData);
+		ringSize = ringBytes;
+		ringHead = 0;
+		ringUsed = 0;
+	}
+
+	void UploadBatcher::SetBlitQueue(uint32_t queueFamily, VkQueue queue, std::mutex& queueMutex)
+	{
+		blitQueue = queue;
+		blitQueueMutex = &queueMutex;
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+		VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &blitCommandPool);
+		check_vk_result(result);
+	}
+
+	void UploadBatcher::Destroy()
+	{
+		if (device == VK_NULL_HANDLE)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Wait(Submit());
+		Retire(false);
+
+		vkDestroyCommandPool(device, commandPool, nullptr);	// Frees the command buffers with it.
+		if (blitCommandPool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(device, blitCommandPool, nullptr);
+		vkDestroySemaphore(device, semaphore, nullptr);
+		vmaDestroyBuffer(allocator, ring, ringAllocation);
+
+		freeCommandBuffers.clear();
+		freeBlitCommandBuffers.clear();
+		commandPool = VK_NULL_HANDLE;
+		blitCommandPool = VK_NULL_HANDLE;
+		blitQueue = VK_NULL_HANDLE;
+		lastSubmitBlitted = false;
+		semaphore = VK_NULL_HANDLE;
+		ring = VK_NULL_HANDLE;
+		ringAllocation = VK_NULL_HANDLE;
+		ringData = nullptr;
+		submittedValue = 0;
+		device = VK_NULL_HANDLE;
+	}
+
+	void UploadBatcher::CopyToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize offset)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		VkBuffer source = VK_NULL_HANDLE;
+		VkDeviceSize sourceOffset = Stage(data, size, source);
+		VkCommandBuffer commandBuffer = GetCommandBuffer();
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = sourceOffset;
+		copyRegion.dstOffset = offset;
+		copyRegion.size = size;
+		vkCmdCopyBuffer(commandBuffer, source, buffer, 1, &copyRegion);
+	}
+
+	void UploadBatcher::CopyToImage(const void* data, VkDeviceSize size, VkImage image, const std::vector<MipLevel>& levels, uint32_t mipLevels)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		VkBuffer source = VK_NULL_HANDLE;
+		VkDeviceSize sourceOffset = Stage(data, size, source);
+		VkCommandBuffer commandBuffer = GetCommandBuffer();
+		uint32_t copiedLevels = std::min(static_cast<uint32_t>(levels.size()), mipLevels);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		std::vector<VkBufferImageCopy> regions(copiedLevels);
+		for (uint32_t level = 0; level < copiedLevels; level++)
+		{
+			VkBufferImageCopy& region = regions[level];
+			region.bufferOffset = sourceOffset + levels[level].offset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = {0, 0, 0};
+			region.imageExtent = { static_cast<uint32_t>(levels[level].size.x), static_cast<uint32_t>(levels[level].size.y), 1 };
+		}
+		vkCmdCopyBufferToImage(commandBuffer, source, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copiedLevels, regions.data());
+
+		// Only layout changes after this, transfer queues can't name shader stages. Readers wait on the semaphore, which covers the rest.
+		auto transitionToShaders = [&](VkCommandBuffer target, VkImageLayout oldLayout, uint32_t baseLevel, uint32_t levelCount)
+		{
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = 0;
+			barrier.subresourceRange.baseMipLevel = baseLevel;
+			barrier.subresourceRange.levelCount = levelCount;
+			vkCmdPipelineBarrier(target, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		};
+
+		if (copiedLevels == mipLevels)
+		{
+			transitionToShaders(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, mipLevels);
+			return;
+		}
+
+		// Each generated level is a linear downsample of the one before, which then goes from blit destination to blit source.
+		VkCommandBuffer blitCommandBuffer = GetBlitCommandBuffer();
+		if (copiedLevels > 1)
+			transitionToShaders(blitCommandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, copiedLevels - 1);
+
+		Vec2D levelSize = levels[copiedLevels - 1].size;
+		for (uint32_t level = copiedLevels; level < mipLevels; level++)
+		{
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.subresourceRange.baseMipLevel = level - 1;
+			barrier.subresourceRange.levelCount = 1;
+			vkCmdPipelineBarrier(blitCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			Vec2D next = { std::max(levelSize.x / 2, 1), std::max(levelSize.y / 2, 1) };
+			VkImageBlit blit{};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.srcOffsets[0] = {0, 0, 0};
+			blit.srcOffsets[1] = {levelSize.x, levelSize.y, 1};
+			blit.dstSubresource = blit.srcSubresource;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstOffsets[0] = {0, 0, 0};
+			blit.dstOffsets[1] = {next.x, next.y, 1};
+			vkCmdBlitImage(blitCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+			transitionToShaders(blitCommandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, level - 1, 1);
+			levelSize = next;
+		}
+		transitionToShaders(blitCommandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels - 1, 1);
+	}
+
+	uint64_t UploadBatcher::Flush()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return Submit();
+	}
+
+	void UploadBatcher::Wait(uint64_t value)
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &semaphore;
+		waitInfo.pValues = &value;
+		VkResult result = vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+		check_vk_result(result);
+	}
+
+	VkCommandBuffer UploadBatcher::GetCommandBuffer()
+	{
+		if (recording.commandBuffer == VK_NULL_HANDLE)
+			recording.commandBuffer = BeginCommandBuffer(commandPool, freeCommandBuffers);
+		return recording.commandBuffer;
+	}
+
+	VkCommandBuffer UploadBatcher::GetBlitCommandBuffer()
+	{
+		if (blitQueue == VK_NULL_HANDLE)
+			return GetCommandBuffer();
+
+		if (recording.blitCommandBuffer == VK_NULL_HANDLE)
+			recording.blitCommandBuffer = BeginCommandBuffer(blitCommandPool, freeBlitCommandBuffers);
+		return recording.blitCommandBuffer;
+	}
+
+	VkCommandBuffer UploadBatcher::BeginCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList)
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (freeList.empty())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = pool;
+			allocInfo.commandBufferCount = 1;
+			VkResult result = vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+			check_vk_result(result);
+		}
+		else
+		{
+			commandBuffer = freeList.back();
+			freeList.pop_back();
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);	// Implicitly resets a recycled one.
+		check_vk_result(result);
+		return commandBuffer;
+	}
+
+	VkDeviceSize UploadBatcher::Stage(const void* data, VkDeviceSize size, VkBuffer& source)
+	{
+		VkDeviceSize alignedSize = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+		if (alignedSize > ringSize)
+		{
+			VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+			bufferInfo.size = size;
+			bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VmaAllocationCreateInfo allocCreateInfo = {};
+			allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+			allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+			VmaAllocation allocation = VK_NULL_HANDLE;
+			VmaAllocationInfo allocInfo = {};
+			VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &source, &allocation, &allocInfo);
+			check_vk_result(result);
+
+			memcpy(allocInfo.pMappedData, data, (size_t)size);
+			vmaFlushAllocation(allocator, allocation, 0, size);
+			recording.ownBuffers.push_back({ source, allocation });
+			return 0;
+		}
+
+		// Ranges are handed out in submission order and come back in completion order, which is the same: a plain ring.
+		VkDeviceSize skipped = 0;
+		while (true)
+		{
+			skipped = ringHead + alignedSize > ringSize ? ringSize - ringHead : 0;	// Copies don't wrap, the tail end is left unused.
+			if (ringUsed + skipped + alignedSize <= ringSize)
+				break;
+
+			// Full. Whatever isn't in flight yet is recording, it has to go out before its space can come back.
+			if (inFlight.empty())
+				Submit();
+			stallCount++;
+			Retire(true);
+		}
+
+		if (skipped > 0)
+			ringHead = 0;
+		VkDeviceSize offset = ringHead;
+		ringHead += alignedSize;
+		ringUsed += skipped + alignedSize;
+		recording.ringBytes += skipped + alignedSize;
+
+		memcpy(ringData + offset, data, (size_t)size);
+		vmaFlushAllocation(allocator, ringAllocation, offset, size);	// No-op on coherent memory.
+		source = ring;
+		return offset;
+	}
+
+	uint64_t UploadBatcher::Submit()
+	{
+		if (recording.commandBuffer == VK_NULL_HANDLE)
+			return submittedValue;
+
+		VkResult result = vkEndCommandBuffer(recording.commandBuffer);
+		check_vk_result(result);
+
+		// The semaphore only counts up: copies may not signal before the previous batch's blits did on the other queue.
+		uint64_t previousValue = submittedValue;
+		recording.value = ++submittedValue;
+		SubmitCommandBuffer(queue, *queueMutex, recording.commandBuffer, lastSubmitBlitted ? previousValue : 0, recording.value);
+
+		lastSubmitBlitted = recording.blitCommandBuffer != VK_NULL_HANDLE;
+		if (lastSubmitBlitted)
+		{
+			result = vkEndCommandBuffer(recording.blitCommandBuffer);
+			check_vk_result(result);
+
+			uint64_t copiedValue = recording.value;
+			recording.value = ++submittedValue;
+			SubmitCommandBuffer(blitQueue, *blitQueueMutex, recording.blitCommandBuffer, copiedValue, recording.value);
+		}
+
+		inFlight.push_back(std::move(recording));
+		recording = {};
+		batchCount++;
+		Retire(false);
+		return submittedValue;
+	}
+
+	void UploadBatcher::SubmitCommandBuffer(VkQueue queue, std::mutex& queueMutex, VkCommandBuffer commandBuffer, uint64_t waitValue, uint64_t signalValue)
+	{
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = waitValue > 0 ? 1 : 0;
+		timelineInfo.pWaitSemaphoreValues = &waitValue;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waitValue > 0 ? 1 : 0;
+		submitInfo.pWaitSemaphores = &semaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &semaphore;
+
+		VkResult result;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
+		check_vk_result(result);
+	}
+
+	void UploadBatcher::Retire(bool wait)
+	{
+		uint64_t completed = 0;
+		VkResult result = vkGetSemaphoreCounterValue(device, semaphore, &completed);
+		check_vk_result(result);
+
+		while (!inFlight.empty())
+		{
+			Batch& batch = inFlight.front();
+			if (completed < batch.value)
+			{
+				if (!wait)
+					break;
+				Wait(batch.value);
+				completed = batch.value;
+				wait = false;
+			}
+
+			ringUsed -= batch.ringBytes;
+			for (auto& buffer : batch.ownBuffers)
+				vmaDestroyBuffer(allocator, buffer.first, buffer.second);
+			freeCommandBuffers.push_back(batch.commandBuffer);
+			if (batch.blitCommandBuffer != VK_NULL_HANDLE)
+				freeBlitCommandBuffers.push_back(batch.blitCommandBuffer);
+			inFlight.pop_front();
+		}
+
+		// Start over at the front while nothing's staged, so big uploads don't have to skip the tail end.
+		if (ringUsed == 0)
+			ringHead = 0;
+	}
+}
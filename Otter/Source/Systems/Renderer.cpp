@@ -1,95 +1,125 @@
 #include "Otter/Systems/Renderer.hpp"
-#include "Otter/Utilities/ShaderUtilities.hpp"
 #include "Otter/Core/Coordinator.hpp"
 #include "Otter/Components/MeshRenderer.hpp"
+#include "Otter/Components/Transform.hpp"
+#include "Otter/Core/AllocationTracker.hpp"
+#include "Otter/Core/Profiler.hpp"
 #include "loguru.hpp"
 #include "imgui.h"
 #include "imgui_impl_sdl.h"
-#include "SDL_vulkan.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
 #include <glm/gtc/matrix_transform.hpp>
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // Output data structure
-#include <assimp/postprocess.h>     // Post processing flags
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#include <memory>
+
+using namespace Otter::Rendering;
 
 namespace Otter::Systems
 {
-	static void check_vk_result(VkResult err)
-	{
-		if (err == 0)
-			return;
-
-		LOG_F(ERROR, "[vulkan] Error: VkResult = %d\n", err);
-
-		if (err < 0)
-			abort();
-	}
-
-	static VKAPI_ATTR VkBool32 VKAPI_CALL vkDebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData)
-	{
-		LOG_F(ERROR, "[vulkan] validation layer: %s", pCallbackData->pMessage);
-        return VK_FALSE;
-    }
+	static const char* DEFAULT_SHADER = "Simple";
+	static const char* DEFAULT_TEXTURE = "Assets/Textures/floral_shoppe.jpg";
+	static const VkFormat OFFSCREEN_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;	// RGBA byte order, so captures can be written out as is.
 
 	void Renderer::OnStart()
 	{
 		currentFrame = 0;
-		deltaTime = 0;
+		spin = glm::mat4(1.0f);
+		camera.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 
-		if(!CreateVulkanInstance())
+		if (!device)
 		{
-			LOG_F(ERROR, "Failed to create vulkan instance");
+			LOG_F(ERROR, "Renderer has no render device assigned");
 			return;
 		}
 
-		CreateSurface();
-		SelectPhysicalDevice();
-		CreateLogicalDevice();
-
-		// Memory Allocator
-		VmaAllocatorCreateInfo allocatorCreateInfo{};
-		allocatorCreateInfo.flags = 0;
-		allocatorCreateInfo.physicalDevice = physicalDevice;
-		allocatorCreateInfo.device = logicalDevice;
-		allocatorCreateInfo.instance = vulkanInstance;
-		vmaCreateAllocator(&allocatorCreateInfo, &allocator);
-
-		// Load shader modules
-		vert = ShaderUtilities::LoadShaderModule("Assets/Shaders/Simple/Simple.vert", logicalDevice);
-		frag = ShaderUtilities::LoadShaderModule("Assets/Shaders/Simple/Simple.frag", logicalDevice);
-		if(vert == VK_NULL_HANDLE || frag == VK_NULL_HANDLE)
+		// Kick off the CPU heavy loading first, so it runs on the device's workers while we set up Vulkan here.
+		auto timeline = std::make_shared<StartupTimeline>("Renderer " + title);
+		AssetManager& assets = AssetManager::Get();
+		defaultShader = assets.AcquireShader(DEFAULT_SHADER);
+		defaultTexture = assets.AcquireTexture(DEFAULT_TEXTURE);
+		device->PrefetchGraphicsPipeline(DEFAULT_SHADER, timeline);
+		device->PrefetchTexture(DEFAULT_TEXTURE, timeline);
+		for (auto entity : entities)
+		{
+			const Components::MeshRenderer& meshRenderer = coordinator->GetComponent<Components::MeshRenderer>(entity);
+			if (meshRenderer.mesh.IsValid())
+				device->PrefetchMesh(assets.GetPath(meshRenderer.mesh), timeline);
+			if (meshRenderer.texture.IsValid())
+				device->PrefetchTexture(assets.GetPath(meshRenderer.texture), timeline);
+		}
+
+		// The first window brings up the device, since picking a GPU requires a surface it can present to.
+		if (!device->IsInitialized())
+		{
+			bool deviceInitialized = timeline->Measure("Initialize device", [&]() {
+				return headless ? device->InitializeHeadless() : device->Initialize(handle, surface);
+			});
+			if (!deviceInitialized)
+				return;
+		}
+		else if (headless != device->IsHeadless())
+		{
+			// A headless device has no surface support, a windowed one would leave offscreen images in present layout.
+			LOG_F(ERROR, "Renderer '%s' can't share a %s render device", title.c_str(), device->IsHeadless() ? "headless" : "windowed");
 			return;
+		}
+		else if (!headless)
+			timeline->Measure("Create surface", [&]() { surface = device->CreateSurface(handle); });
 
-		CreateSwapChain();
-		CreateImageViews();
-		CreateRenderPass();
-		CreateDescriptorSetLayout();
-		CreateGraphicsPipeline();
-		CreateCommandPool();
-		CreateDepthResources();
-		CreateFrameBuffers();
-		CreateTextureImage();
-		CreateTextureSampler();
-		LoadMeshes();
-		CreateVertexBuffer();
-		CreateIndexBuffer();
-		CreateUniformBuffers();
-		CreateDescriptorPool();
-		CreateDescriptorSets();
-		CreateCommandBuffer();
-		CreateSyncObjects();
+		logicalDevice = device->GetLogicalDevice();
+		allocator = device->GetAllocator();
+
+		if (headless)
+			timeline->Measure("Create offscreen targets", [&]() { CreateOffscreenTargets(); });
+		else
+			timeline->Measure("Create swap chain", [&]() { CreateSwapChain(); });
+		timeline->Measure("Create image views", [&]() { CreateImageViews(); });
+		timeline->Measure("Create command pool", [&]() { CreateCommandPool(); });
+		timeline->Measure("Create depth resources", [&]() { CreateDepthResources(); });
+		timeline->Measure("Create sync objects", [&]() { CreateSyncObjects(); });
+		timeline->Measure("Create uniform buffers", [&]() { CreateUniformBuffers(); });
+		timeline->Measure("Create command buffers", [&]() { CreateCommandBuffer(); });
+		timeline->Measure("Create GPU profiler", [&]() { gpuProfiler.Create(*device, "GPU " + title); });
+
+		// Everything below may have to wait for a prefetch to finish.
+		renderPass = timeline->Measure("Get render pass", [&]() { return device->GetRenderPass(swapChainImageFormat); });
+		timeline->Measure("Create framebuffers", [&]() { CreateFrameBuffers(); });
+		graphicsPipeline = timeline->Measure("Get graphics pipeline", [&]() { return device->GetGraphicsPipeline(DEFAULT_SHADER, swapChainImageFormat); });
+		if(graphicsPipeline == VK_NULL_HANDLE)
+			return;
+
+		timeline->Measure("Stream meshes", [&]() { StreamMeshes(); });
+		timeline->Measure("Create descriptor pool", [&]() { CreateDescriptorPool(); });
+		timeline->Measure("Create descriptor sets", [&]() { CreateDescriptorSets(); });
 
 		if (imGuiAllowed)
-			SetupImGui();
+			timeline->Measure("Setup ImGui", [&]() { SetupImGui(); });
 
+		timeline->Log();
 		initialized = true;
+
+		if (renderThreadEnabled)
+			StartRenderThread();
 	}
 
 	void Renderer::OnStop()
 	{
-		VkResult err = vkDeviceWaitIdle(logicalDevice);
-		check_vk_result(err);
+		AssetManager::Get().Release(defaultTexture);
+		AssetManager::Get().Release(defaultShader);
+		defaultTexture = {};
+		defaultShader = {};
+		if (!initialized)
+			return;
+
+		StopRenderThread();
+		device->WaitIdle();
+
+		for (auto& readback : readbacks)
+		{
+			WriteCapture(readback);
+			vmaDestroyBuffer(allocator, readback.buffer, readback.allocation);
+		}
+		readbacks.clear();
 
 		if (imGuiAllowed)
 		{
@@ -100,19 +130,9 @@ namespace Otter::Systems
 
 		DestroySwapChain();
 
-    	vkDestroySampler(logicalDevice, textureSampler, nullptr);
-    	vkDestroyImageView(logicalDevice, textureImageView, nullptr);
-		vmaDestroyImage(allocator, textureImage, textureImageMemory);
-		vmaDestroyBuffer(allocator, vertexBuffer, vertexBufferAllocation);
-		vmaDestroyBuffer(allocator, indexBuffer, indexBufferAllocation);
 		for(size_t i = 0; i < uniformBufferAllocations.size(); i++)
 			vmaDestroyBuffer(allocator, uniformBuffers[i], uniformBufferAllocations[i]);
 
-		vmaDestroyAllocator(allocator);
-		vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
-		vkDestroyShaderModule(logicalDevice, vert, nullptr);
-    	vkDestroyShaderModule(logicalDevice, frag, nullptr);
-
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 		{
 			vkDestroySemaphore(logicalDevice, imageAvailableSemaphores[i], nullptr);
@@ -122,318 +142,179 @@ namespace Otter::Systems
 		vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
 		vkDestroyDescriptorPool(logicalDevice, imguiDescriptorPool, nullptr);
 		vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
-		vkDestroyDevice(logicalDevice, nullptr);
-		vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
+		gpuProfiler.Destroy();
+		if (surface != VK_NULL_HANDLE)
+			vkDestroySurfaceKHR(device->GetInstance(), surface, nullptr);
 
-		vkDestroyInstance(vulkanInstance, nullptr);
-		vulkanInstance = nullptr;
+		// Instance, device and shared resources are released by the Application once every window is gone.
+		device.reset();
+		initialized = false;
 	}
 
 	void Renderer::OnTick(float deltaTime)
 	{
+		OTTER_PROFILE_SCOPE("Renderer::OnTick");
 		if (!initialized)
 			return;
 
-		this->deltaTime = deltaTime;
-
-		if (imGuiAllowed)
+		// Window callbacks run user code, so they're always fired from the main thread.
+		if (swapChainRecreated.exchange(false) && onFramebufferResized)
 		{
-			ImGui_ImplVulkan_NewFrame();
-			ImGui_ImplSDL2_NewFrame();
-			ImGui::NewFrame();
-
-			if(onDrawImGui)
-				onDrawImGui();
-
-			ImGui::Render();
+			//TODO high DPI support (SDL_WINDOW_ALLOW_HIGHDPI at window create)
+			int width = 0, height = 0;
+			SDL_GetWindowSize(handle, &width, &height);
+			onFramebufferResized({width, height});
 		}
 
-		DrawFrame();
-	}
-
-	void Renderer::OnSDLEvent(SDL_Event* event)
-	{
-		if (!initialized)
-			return;
-
-		if (!imGuiAllowed)
-			return;
-
-		ImGui_ImplSDL2_ProcessEvent(event);
-	}
-
-	bool Renderer::CreateVulkanInstance()
-	{
-		//AppInfo
-		VkApplicationInfo appInfo{};
-		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-		appInfo.pApplicationName = SDL_GetWindowTitle(handle);
-		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.pEngineName = "Otter";
-		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_3;
-
-		//CreateInfo
-		VkInstanceCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-		createInfo.pApplicationInfo = &appInfo;
-
-        auto extensions = GetRequiredExtensions();
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-        createInfo.ppEnabledExtensionNames = extensions.data();
-
-        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
-        if (enableValidationLayers) {
-            createInfo.enabledLayerCount = static_cast<uint32_t>(requiredValidationLayers.size());
-            createInfo.ppEnabledLayerNames = requiredValidationLayers.data();
-
-            PopulateDebugMessengerCreateInfo(debugCreateInfo);
-            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugCreateInfo;
-        } else {
-            createInfo.enabledLayerCount = 0;
-
-            createInfo.pNext = nullptr;
-        }
-
-		VkResult result = vkCreateInstance(&createInfo, nullptr, &vulkanInstance);
-		check_vk_result(result);
-
-		return result == VK_SUCCESS;
-	}
-
-	VkResult Renderer::CreateDebugUtilsMessengerEXT(VkInstance vulkanInstance, const VkDebugUtilsMessengerCreateInfoEXT* createInfo, const VkAllocationCallbacks* allocator, VkDebugUtilsMessengerEXT* debugMessenger)
-	{
-		auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(vulkanInstance, "vkCreateDebugUtilsMessengerEXT");
-		if (func != nullptr) {
-			return func(vulkanInstance, createInfo, allocator, debugMessenger);
-		} else {
-			return VK_ERROR_EXTENSION_NOT_PRESENT;
+		// Lets gameplay react to assets coming in, e.g. to swap a loading indicator for the real thing.
+		for (const std::string& path : device->GetStreamedAssets())
+		{
+			Otter::Event event(Events::Assets::LOADED);
+			event.SetParam<AssetId>(Events::Assets::Loaded::ASSET, fnv1a_32(path.c_str(), path.size()));
+			coordinator->SendEvent(event);
 		}
-	}
 
-	void Renderer::DestroyDebugUtilsMessengerEXT(VkInstance vulkanInstance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* allocator)
-	{
-		auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(vulkanInstance, "vkDestroyDebugUtilsMessengerEXT");
-		if (func != nullptr) {
-			func(vulkanInstance, debugMessenger, allocator);
+		BuildSnapshot(deltaTime);
+
+		if (renderThreadEnabled)
+		{
+			{
+				std::lock_guard<std::mutex> lock(snapshotMutex);
+				snapshotPending = true;
+			}
+			snapshotAvailable.notify_one();
 		}
+		else if (snapshots.Consume())
+			DrawFrame(snapshots.GetReadBuffer());
 	}
 
-	bool Renderer::CheckValidationLayerSupport()
+	void Renderer::BuildSnapshot(float deltaTime)
 	{
-        uint32_t layerCount;
-        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
-
-        std::vector<VkLayerProperties> availableLayers(layerCount);
-        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+		OTTER_PROFILE_SCOPE("Renderer::BuildSnapshot");
+		RenderSnapshot& snapshot = snapshots.GetWriteBuffer();
+		snapshot.deltaTime = deltaTime;
+		snapshot.camera = camera;
+
+		spin = glm::rotate(spin, deltaTime*glm::radians(90.f), glm::vec3(0.0f, 0.0f, 1.0f));
+		snapshot.draws.clear();
+
+		// Slots change as textures stream in and get evicted, so they're looked up every frame. Entities tend to share textures,
+		// neighbours in a row usually have the same one.
+		AssetManager& assets = AssetManager::Get();
+		uint32_t defaultTextureIndex = device->StreamTexture(assets.GetPath(defaultTexture)).textureIndex;	// The interned path, a literal would build a string each frame.
+		TextureHandle lastTexture;
+		uint32_t lastTextureIndex = defaultTextureIndex;
+		const Mesh* lastStreamedMesh = nullptr;
+		for (auto entity : entities)
+		{
+			// Entities created after OnStart start streaming their mesh on first sight, and show the placeholder until it's in.
+			Components::MeshRenderer& meshRenderer = coordinator->GetComponent<Components::MeshRenderer>(entity);
+			if (meshRenderer.resolvedMesh == nullptr)
+			{
+				if (!meshRenderer.mesh.IsValid())
+					continue;
+				meshRenderer.resolvedMesh = &device->StreamMesh(assets.GetPath(meshRenderer.mesh));
+				lastStreamedMesh = meshRenderer.resolvedMesh;
+			}
+			else if (!meshRenderer.resolvedMesh->IsResident() && meshRenderer.resolvedMesh != lastStreamedMesh)
+			{
+				// Evicted meshes stay resolved, streaming again brings them back. A no-op while the load is pending, and only once
+				// for a run of entities sharing the mesh.
+				device->StreamMesh(assets.GetPath(meshRenderer.mesh));
+				lastStreamedMesh = meshRenderer.resolvedMesh;
+			}
+			const Mesh& mesh = meshRenderer.resolvedMesh->IsResident() ? *meshRenderer.resolvedMesh : device->GetPlaceholderMesh();
 
-        for (const char* layerName : requiredValidationLayers) {
-            bool layerFound = false;
+			if (meshRenderer.texture != lastTexture)
+			{
+				lastTexture = meshRenderer.texture;
+				lastTextureIndex = lastTexture.IsValid() ? device->StreamTexture(assets.GetPath(lastTexture)).textureIndex : defaultTextureIndex;
+			}
 
-            for (const auto& layerProperties : availableLayers) {
-                if (strcmp(layerName, layerProperties.layerName) == 0) {
-                    layerFound = true;
-                    break;
-                }
-            }
+			// Entities without a transform get the demo spin.
+			const glm::mat4& model = coordinator->HasComponent<Components::Transform>(entity) ? coordinator->GetComponent<Components::Transform>(entity).world : spin;
+		#ifdef OTTER_QUANTIZE_VERTICES
+			snapshot.draws.push_back({ model * mesh.vertexTransform, mesh.GetDraw(), lastTextureIndex });
+		#else
+			snapshot.draws.push_back({ model, mesh.GetDraw(), lastTextureIndex });
+		#endif
+		}
 
-            if (!layerFound) {
-                return false;
-            }
-        }
+		if (imGuiAllowed)
+		{
+			OTTER_PROFILE_SCOPE("Renderer::ImGui");
+			ImGui_ImplVulkan_NewFrame();
+			ImGui_ImplSDL2_NewFrame();
+			ImGui::NewFrame();
 
-        return true;
-	}
+			if(onDrawImGui)
+				onDrawImGui();
 
-	std::vector<const char*> Renderer::GetRequiredExtensions()
-	{
-		//TODO move to Window so we have 2 vulkan instances and get the correct result
-		unsigned int extensionCount = 0;
-		SDL_Vulkan_GetInstanceExtensions(handle, &extensionCount, nullptr);
-		std::vector<const char *> extensionNames(extensionCount);
-		SDL_Vulkan_GetInstanceExtensions(handle, &extensionCount, extensionNames.data());
+			ImGui::Render();
+			snapshot.imGui.Capture(ImGui::GetDrawData());
+		}
 
-        return extensionNames;
+		snapshots.Publish();
 	}
 
-	void Renderer::PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
+	void Renderer::StartRenderThread()
 	{
-        createInfo = {};
-        createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-        createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-        createInfo.pfnUserCallback = vkDebugCallback;
+		std::string threadName = "Render " + title;
+		renderThreadRunning = true;
+		renderThread = std::thread([this, threadName]() {
+			loguru::set_thread_name(threadName.c_str());
+			RenderThreadMain();
+		});
 	}
 
-	void Renderer::SetupDebugMessenger()
+	void Renderer::StopRenderThread()
 	{
-        if (!enableValidationLayers)
+		if (!renderThread.joinable())
 			return;
 
-        VkDebugUtilsMessengerCreateInfoEXT createInfo;
-        PopulateDebugMessengerCreateInfo(createInfo);
-
-        VkResult result = CreateDebugUtilsMessengerEXT(vulkanInstance, &createInfo, nullptr, &debugMessenger);
-		check_vk_result(result);
-	}
-
-	void Renderer::CreateSurface()
-	{
-		SDL_bool result = SDL_Vulkan_CreateSurface(handle, vulkanInstance, &surface);
-		if(!result)
-			LOG_F(ERROR, "Failed to create surface: %s", SDL_GetError());
-
-		assert(result);
-	}
-
-	void Renderer::SelectPhysicalDevice()
-	{
-		uint32_t gpuCount;
-		VkResult err = vkEnumeratePhysicalDevices(vulkanInstance, &gpuCount, NULL);
-		check_vk_result(err);
-		assert(gpuCount > 0);	//TODO make custom macro with std::runtime_error and Loguru.
-
-		std::vector<VkPhysicalDevice> gpus(gpuCount);
-		err = vkEnumeratePhysicalDevices(vulkanInstance, &gpuCount, gpus.data());
-		check_vk_result(err);
-		assert(err == VK_SUCCESS);
-
-		std::vector<VkPhysicalDevice> suitableGpus{};
-		for (const auto gpu : gpus)
-			if (IsPhysicalDeviceSuitable(gpu))
-				suitableGpus.push_back(gpu);
-		assert(suitableGpus.size() > 0);
-
-		// If a number >1 of GPUs got reported, find discrete GPU if present, or use first one available. This covers
-		// most common cases (multi-gpu/integrated+dedicated graphics). Handling more complicated setups (multiple
-		// dedicated GPUs) is out of scope of this sample.
-		int useGpu = 0;
-		for (int i = 0; i < suitableGpus.size(); i++)
 		{
-			VkPhysicalDeviceProperties properties;
-			vkGetPhysicalDeviceProperties(suitableGpus[i], &properties);
-			if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-			{
-				useGpu = i;
-				break;
-			}
+			std::lock_guard<std::mutex> lock(snapshotMutex);
+			renderThreadRunning = false;
 		}
-		physicalDevice = suitableGpus[useGpu];
-		assert(physicalDevice != VK_NULL_HANDLE);
-
-		VkPhysicalDeviceProperties properties;
-		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
-		LOG_F(INFO, "Using GPU %s", properties.deviceName);
+		snapshotAvailable.notify_one();
+		renderThread.join();
 	}
 
-	bool Renderer::IsPhysicalDeviceSuitable(VkPhysicalDevice gpu)
+	void Renderer::RenderThreadMain()
 	{
-		QueueFamilyIndices indices = FindQueueFamilies(gpu);
-
-		bool extensionsSupported = HasDeviceExtensionSupport(gpu);
-
-		bool swapChainAdequate = false;
-		if (extensionsSupported)
+		while (true)
 		{
-			SwapChainSupportDetails swapChainSupport = FindSwapChainSupport(gpu);
-			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
-		}
-
-		VkPhysicalDeviceFeatures supportedFeatures;
-    	vkGetPhysicalDeviceFeatures(gpu, &supportedFeatures);
-
-		return indices.graphicsFamily.has_value() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
-	}
-
-	bool Renderer::HasDeviceExtensionSupport(VkPhysicalDevice gpu)
-	{
-		uint32_t extensionCount;
-		vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionCount, nullptr);
-
-		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-		vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionCount, availableExtensions.data());
-
-		// Make a copy of the required extensions and remove them if they are present on the device.
-		// If no extensions are part of the list anymore, we have them all and we're good to go.
-		std::set<std::string> requiredExtensions(requiredPhysicalDeviceExtensions.begin(), requiredPhysicalDeviceExtensions.end());
-		for (const auto& extension : availableExtensions)
-			requiredExtensions.erase(extension.extensionName);
-
-		return requiredExtensions.empty();
-	}
-
-	QueueFamilyIndices Renderer::FindQueueFamilies(VkPhysicalDevice gpu)
-	{
-		QueueFamilyIndices indices;
-
-		uint32_t queueFamilyCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, nullptr);
-
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, queueFamilies.data());
-
-		// Find at least one queue family that supports Graphics.
-		int i = 0;
-		for (const auto& queueFamily : queueFamilies)
-		{
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(gpu, i, surface, &presentSupport);
-			if (presentSupport)
-				indices.presentFamily = i;
+			{
+				std::unique_lock<std::mutex> lock(snapshotMutex);
+				snapshotAvailable.wait(lock, [this]() { return snapshotPending || !renderThreadRunning; });
+				if (!renderThreadRunning)
+					return;
 
-			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-				indices.graphicsFamily = i;
+				snapshotPending = false;
+			}
 
-			i++;
+			// If the main thread published more than once since the last frame, this picks up the newest snapshot.
+			OTTER_PROFILE_SCOPE("Renderer::RenderThreadFrame");
+			OTTER_ALLOCATION_SCOPE("Renderer::RenderThreadFrame");
+			if (snapshots.Consume())
+				DrawFrame(snapshots.GetReadBuffer());
 		}
-
-		return indices;
 	}
 
-	void Renderer::CreateLogicalDevice()
+	void Renderer::OnSDLEvent(SDL_Event* event)
 	{
-		// Specify queues to be created alongside the device.
-		assert(physicalDevice != VK_NULL_HANDLE);
-		QueueFamilyIndices indices = FindQueueFamilies(physicalDevice);
-
-		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
-
-		float queuePriority = 1.0f;
-		for (uint32_t queueFamily : uniqueQueueFamilies)
-		{
-			VkDeviceQueueCreateInfo queueCreateInfo{};
-			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queueCreateInfo.queueFamilyIndex = queueFamily;
-			queueCreateInfo.queueCount = 1;
-			queueCreateInfo.pQueuePriorities = &queuePriority;
-			queueCreateInfos.push_back(queueCreateInfo);
-		}
-
-		VkPhysicalDeviceFeatures deviceFeatures{};
-		deviceFeatures.samplerAnisotropy = VK_TRUE;
-
-		// Create the logical device.
-		VkDeviceCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
-		createInfo.pQueueCreateInfos = queueCreateInfos.data();
-		createInfo.pEnabledFeatures = &deviceFeatures;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredPhysicalDeviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = requiredPhysicalDeviceExtensions.data();
-		createInfo.enabledLayerCount = 0;	// Validation layers are disabled on application level currently.
+		if (!initialized)
+			return;
 
-		VkResult result = vkCreateDevice(physicalDevice, &createInfo, nullptr, &logicalDevice);
-		check_vk_result(result);
+		if (!imGuiAllowed)
+			return;
 
-		// After creation, get a reference to our queues.
-		vkGetDeviceQueue(logicalDevice, indices.graphicsFamily.value(), 0, &graphicsQueue);
-		vkGetDeviceQueue(logicalDevice, indices.presentFamily.value(), 0, &presentQueue);
+		ImGui_ImplSDL2_ProcessEvent(event);
 	}
 
 	void Renderer::CreateSwapChain()
 	{
-		SwapChainSupportDetails swapChainSupport = FindSwapChainSupport(physicalDevice);
+		const SwapChainSupportDetails& swapChainSupport = FindSwapChainSupport(device->GetPhysicalDevice());
 		VkSurfaceFormatKHR surfaceFormat = SelectSwapChainSurfaceFormat(swapChainSupport.formats);
 		VkPresentModeKHR presentMode = SelectSwapChainPresentMode(swapChainSupport.presentModes);
 		VkExtent2D extent = SelectSwapChainExtent(swapChainSupport.capabilities);
@@ -462,7 +343,7 @@ namespace Otter::Systems
 		// VK_SHARING_MODE_CONCURRENT
 		// Images can be used across multiple queue families without explicit ownership transfers.
 
-		QueueFamilyIndices indices = FindQueueFamilies(physicalDevice);
+		const QueueFamilyIndices& indices = device->GetQueueFamilies();
 		uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
 		// If the queue families differ, use concurrent mdoe so we don't have to deal with ownership.
@@ -493,11 +374,6 @@ namespace Otter::Systems
 		vkGetSwapchainImagesKHR(logicalDevice, swapChain, &swapChainImageCount, swapChainImages.data());
 		swapChainImageFormat = surfaceFormat.format;
 		swapChainExtent = extent;
-
-		quad.model = glm::rotate(glm::mat4(1.0f), 0*glm::radians(90.f), glm::vec3(0.0f, 0.0f, 1.0f));
-		quad.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		quad.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float) swapChainExtent.height, 0.1f, 10.0f);
-		quad.proj[1][1] *= -1;
 	}
 
 	void Renderer::DestroySwapChain()
@@ -511,38 +387,96 @@ namespace Otter::Systems
     	vkDestroyImageView(logicalDevice, depthImageView, nullptr);
 		vmaDestroyImage(allocator, depthImage, depthImageMemory);
 
-		vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
-		vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr);
-		vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
-		vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr);
+		for (size_t i = 0; i < offscreenImageAllocations.size(); i++)
+			vmaDestroyImage(allocator, swapChainImages[i], offscreenImageAllocations[i]);
+		offscreenImageAllocations.clear();
+
+		if (swapChain != VK_NULL_HANDLE)
+			vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr);
+		swapChain = VK_NULL_HANDLE;
 	}
 
-	void Renderer::RecreateSwapChain()
+	void Renderer::CreateOffscreenTargets()
 	{
-		//TODO high DPI support (SDL_WINDOW_ALLOW_HIGHDPI at window create)
-		int width = 0, height = 0;
-		SDL_GetWindowSize(handle, &width, &height);
+		// One image per frame in flight, so recording a frame never has to wait on the image of the previous one.
+		swapChainImageFormat = OFFSCREEN_FORMAT;
+		swapChainExtent = { static_cast<uint32_t>(headlessSize.x), static_cast<uint32_t>(headlessSize.y) };
+		swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+		offscreenImageAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			device->CreateImage(headlessSize, OFFSCREEN_FORMAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, swapChainImages[i], offscreenImageAllocations[i]);
+
+		readbacks.resize(MAX_FRAMES_IN_FLIGHT);
+		for (auto& readback : readbacks)
+		{
+			VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+			bufferInfo.size = static_cast<VkDeviceSize>(headlessSize.x) * headlessSize.y * 4;
+			bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		vkDeviceWaitIdle(logicalDevice);
+			VmaAllocationCreateInfo allocCreateInfo = {};
+			allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+			allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+			VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &readback.buffer, &readback.allocation, nullptr);
+			check_vk_result(result);
+		}
+	}
+
+	void Renderer::CaptureFrame(const std::string& path)
+	{
+		if (!headless)
+		{
+			LOG_F(ERROR, "Frame captures are only supported by headless renderers, ignoring %s", path.c_str());
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(captureMutex);
+		requestedCapture = path;
+	}
+
+	void Renderer::WriteCapture(FrameReadback& readback)
+	{
+		if (readback.path.empty())
+			return;
+
+		VmaAllocationInfo allocationInfo;
+		vmaGetAllocationInfo(allocator, readback.allocation, &allocationInfo);
+		vmaInvalidateAllocation(allocator, readback.allocation, 0, VK_WHOLE_SIZE);
+
+		int stride = static_cast<int>(swapChainExtent.width) * 4;
+		if (stbi_write_png(readback.path.c_str(), swapChainExtent.width, swapChainExtent.height, 4, allocationInfo.pMappedData, stride) == 0)
+			LOG_F(ERROR, "Failed to write frame capture %s", readback.path.c_str());
+		else
+			LOG_F(INFO, "Wrote frame capture %s", readback.path.c_str());
+
+		readback.path.clear();
+	}
+
+	void Renderer::RecreateSwapChain()
+	{
+		OTTER_PROFILE_SCOPE("Renderer::RecreateSwapChain");
+		device->WaitIdle();
 		DestroySwapChain();
 
 		CreateSwapChain();
 		CreateImageViews();
-		CreateRenderPass();
-		CreateGraphicsPipeline();
+
+		// Cached on the device, this only creates something new if the surface format changed.
+		renderPass = device->GetRenderPass(swapChainImageFormat);
+		graphicsPipeline = device->GetGraphicsPipeline(DEFAULT_SHADER, swapChainImageFormat);
+
 		CreateDepthResources();
 		CreateFrameBuffers();
 
 		currentFrame = 0;
 		framebufferResized = false;
-		
-		if(onFramebufferResized)
-			onFramebufferResized({width, height});
+		swapChainRecreated = true;
 	}
 
-	SwapChainSupportDetails Renderer::FindSwapChainSupport(VkPhysicalDevice gpu)
+	const SwapChainSupportDetails& Renderer::FindSwapChainSupport(VkPhysicalDevice gpu)
 	{
-		SwapChainSupportDetails result;
+		// Filled in place: the vectors keep their capacity, so recreating the swap chain on a resize doesn't allocate.
+		SwapChainSupportDetails& result = swapChainSupportDetails;
 
 		// Capabilities (min/max number of images in swap chain, min/max width and height of images)
 		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(gpu, surface, &result.capabilities);
@@ -550,20 +484,16 @@ namespace Otter::Systems
 		// Formats: Pixel format, colour space, etc.
 		uint32_t formatCount;
 		vkGetPhysicalDeviceSurfaceFormatsKHR(gpu, surface, &formatCount, nullptr);
+		result.formats.resize(formatCount);
 		if (formatCount != 0)
-		{
-			result.formats.resize(formatCount);
 			vkGetPhysicalDeviceSurfaceFormatsKHR(gpu, surface, &formatCount, result.formats.data());
-		}
 
 		// Present modes: conditions for "swapping" images to the screen
 		uint32_t presentModeCount;
 		vkGetPhysicalDeviceSurfacePresentModesKHR(gpu, surface, &presentModeCount, nullptr);
+		result.presentModes.resize(presentModeCount);
 		if (presentModeCount != 0)
-		{
-			result.presentModes.resize(presentModeCount);
 			vkGetPhysicalDeviceSurfacePresentModesKHR(gpu, surface, &presentModeCount, result.presentModes.data());
-		}
 
 		return result;
 	}
@@ -603,9 +533,9 @@ namespace Otter::Systems
 			TODO: investigate device energy impact between modes.
 		*/
 
-		// Pick mailbox if its available, otherwise revert to FIFO/vsync.
+		// Pick the requested mode if its available, otherwise revert to FIFO/vsync which every surface supports.
 		for (const auto& availablePresentMode : availablePresentModes)
-			if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+			if (availablePresentMode == preferredPresentMode)
 				return availablePresentMode;
 
 		return VK_PRESENT_MODE_FIFO_KHR;
@@ -635,299 +565,23 @@ namespace Otter::Systems
 		}
 	}
 
-	VkImageView Renderer::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
-		VkImageViewCreateInfo viewInfo{};
-		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-		viewInfo.image = image;
-		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = format;
-		viewInfo.subresourceRange.aspectMask = aspectFlags;
-		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
-		viewInfo.subresourceRange.baseArrayLayer = 0;
-		viewInfo.subresourceRange.layerCount = 1;
-
-		VkImageView imageView;
-		VkResult result = vkCreateImageView(logicalDevice, &viewInfo, nullptr, &imageView);
-		check_vk_result(result);
-
-		return imageView;
-	}
-
 	void Renderer::CreateImageViews()
 	{
 		swapChainImageViews.resize(swapChainImages.size());
 		for (size_t i = 0; i < swapChainImages.size(); i++)
-			swapChainImageViews[i] = CreateImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+			swapChainImageViews[i] = device->CreateImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
 	}
 
-	void Renderer::LoadMeshes()
+	void Renderer::StreamMeshes()
 	{
-		//vertices = std::vector<Vertex>();
-		//indices = std::vector<uint32_t>();
-
 		for (auto entity : entities) 
 		{
-			auto meshRenderer = coordinator->GetComponent<Components::MeshRenderer>(entity);
-
-			Assimp::Importer importer;
-			// And have it read the given file with some example postprocessing
-			// Usually - if speed is not the most important aspect for you - you'll
-			// probably to request more postprocessing than we do in this example.
-			const aiScene* scene = importer.ReadFile(meshRenderer.meshPath,
-				aiProcess_CalcTangentSpace       |
-				aiProcess_Triangulate            |
-				aiProcess_JoinIdenticalVertices  |
-				aiProcess_SortByPType
-			);
-
-			// If the import failed, report it
-			if (scene == nullptr)
-			{
-				LOG_F(ERROR, "%s", importer.GetErrorString());
-				abort();
-			}
-
-			//todo add to vertices and build indices queue
-			int i = 0;
+			Components::MeshRenderer& meshRenderer = coordinator->GetComponent<Components::MeshRenderer>(entity);
+			if (meshRenderer.mesh.IsValid())
+				meshRenderer.resolvedMesh = &device->StreamMesh(AssetManager::Get().GetPath(meshRenderer.mesh));
 		}
 	}
 
-	void Renderer::CreateRenderPass()
-	{
-	    VkAttachmentDescription colorAttachment{};
-		colorAttachment.format = swapChainImageFormat;
-		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;	
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		VkAttachmentReference colorAttachmentRef{};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription depthAttachment{};
-		depthAttachment.format = FindDepthFormat();
-		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference depthAttachmentRef{};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass{};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
-		subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-		VkSubpassDependency dependency{};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-
-		std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
-		VkRenderPassCreateInfo renderPassInfo{};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		renderPassInfo.pAttachments = attachments.data();
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency; 
-		
-
-		VkResult result = vkCreateRenderPass(logicalDevice, &renderPassInfo, nullptr, &renderPass);
-		check_vk_result(result);
-	}
-
-	void Renderer::CreateDescriptorSetLayout()
-	{
-		VkDescriptorSetLayoutBinding uboLayoutBinding{};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
-
-		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-		samplerLayoutBinding.binding = 1;
-		samplerLayoutBinding.descriptorCount = 1;
-		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		samplerLayoutBinding.pImmutableSamplers = nullptr;
-		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
-		VkDescriptorSetLayoutCreateInfo layoutInfo{};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-		layoutInfo.pBindings = bindings.data();
-
-		VkResult result = vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &descriptorSetLayout);
-		check_vk_result(result);
-	}
-
-	void Renderer::CreateGraphicsPipeline()
-	{
-		VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfo.module = vert;
-		vertShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfo.module = frag;
-		fragShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-		// Fixed functions of render pipeline
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float) swapChainExtent.width;
-		viewport.height = (float) swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor{};
-		scissor.offset = {0, 0};
-		scissor.extent = swapChainExtent;
-
-		VkPipelineViewportStateCreateInfo viewportState{};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
-
-		// The rasterizer takes the geometry that is shaped by the vertices from the vertex shader and turns it into fragments to be colored by the fragment shader.
-		// It also performs depth testing, face culling and the scissor test, and it can be configured to output fragments that fill entire polygons or just the edges (wireframe rendering).
-		VkPipelineRasterizationStateCreateInfo rasterizer{};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;
-		rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-		rasterizer.depthBiasClamp = 0.0f; // Optional
-		rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-		// AA method, currently disabled.
-		VkPipelineMultisampleStateCreateInfo multisampling{};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		multisampling.minSampleShading = 1.0f; // Optional
-		multisampling.pSampleMask = nullptr; // Optional
-		multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-		multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
-
-		VkPipelineColorBlendStateCreateInfo colorBlending{};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f; // Optional
-		colorBlending.blendConstants[1] = 0.0f; // Optional
-		colorBlending.blendConstants[2] = 0.0f; // Optional
-		colorBlending.blendConstants[3] = 0.0f; // Optional
-
-		// Dynamic States - A limited amount of the state that we've specified in the previous structs can actually be changed without recreating the pipeline
-		std::vector<VkDynamicState> dynamicStates = {
-			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH
-		};
-
-		VkPipelineDynamicStateCreateInfo dynamicState{};
-		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-		dynamicState.pDynamicStates = dynamicStates.data();
-
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 1; // Optional
-		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout; // Optional
-		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-		VkResult result = vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout);
-		check_vk_result(result);
-
-		VkPipelineDepthStencilStateCreateInfo depthStencil{};
-		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencil.depthTestEnable = VK_TRUE;
-		depthStencil.depthWriteEnable = VK_TRUE;
-		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-		depthStencil.depthBoundsTestEnable = VK_FALSE;
-		depthStencil.minDepthBounds = 0.0f; // Optional
-		depthStencil.maxDepthBounds = 1.0f; // Optional
-		depthStencil.stencilTestEnable = VK_FALSE;
-		depthStencil.front = {}; // Optional
-		depthStencil.back = {}; // Optional
-
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;	
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = &depthStencil;
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr; // Optional
-		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.renderPass = renderPass;
-		pipelineInfo.subpass = 0;	
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-		pipelineInfo.basePipelineIndex = -1; // Optional
-
-		result = vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline);
-		check_vk_result(result);
-	}
-
 	void Renderer::CreateFrameBuffers()
 	{
 		swapChainFramebuffers.resize(swapChainImageViews.size());
@@ -952,90 +606,6 @@ namespace Otter::Systems
 		}
 	}
 
-	void Renderer::CreateVertexBuffer()
-	{
-		/*
-			Load the Vertices into GPU memory by means of 
-			RAM -> Staging Buffer -> Vertex Buffer.
-			Reason we use the staging buffer is because the most optimal memory for the GPU is non-accessible by the CPU (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT).
-			On integrated GPU's this can be ignored as all graphics data does not have to go through PCIe, but we're not handling that here at the moment.
-			More info: https://gpuopen-librariesandsdks.github.io/VulkanMemoryAllocator/html/usage_patterns.html
-		*/
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-		VkBuffer stagingBuffer = VK_NULL_HANDLE;
-		VmaAllocation stagingBufferAllocation = VK_NULL_HANDLE;
-
-		// Staging Buffer
-		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = bufferSize;
-		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		VmaAllocationCreateInfo allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		VmaAllocationInfo allocInfo = {};
-		VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &stagingBuffer, &stagingBufferAllocation, &allocInfo);
-		check_vk_result(result);
-
-		memcpy(allocInfo.pMappedData, vertices.data(), (size_t)bufferInfo.size);
-
-		// Vertex Buffer
-		bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = bufferSize;
-		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-		result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &vertexBuffer, &vertexBufferAllocation, nullptr);
-		check_vk_result(result);
-
-		CopyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-
-		vmaDestroyBuffer(allocator, stagingBuffer, stagingBufferAllocation);
-	}
-
-	void Renderer::CreateIndexBuffer()
-	{
-		// See CreateVertexBuffer for some more info on how this works.
-
-		VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-		VkBuffer stagingBuffer = VK_NULL_HANDLE;
-		VmaAllocation stagingBufferAllocation = VK_NULL_HANDLE;
-
-		// Staging Buffer
-		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = bufferSize;
-		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		VmaAllocationCreateInfo allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		VmaAllocationInfo allocInfo = {};
-		VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &stagingBuffer, &stagingBufferAllocation, &allocInfo);
-		check_vk_result(result);
-
-		memcpy(allocInfo.pMappedData, indices.data(), (size_t)bufferInfo.size);
-
-		// Index Buffer
-		bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = bufferSize;
-		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-		allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-		result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &indexBuffer, &indexBufferAllocation, nullptr);
-		check_vk_result(result);
-
-		CopyBuffer(stagingBuffer, indexBuffer, bufferSize);
-
-		vmaDestroyBuffer(allocator, stagingBuffer, stagingBufferAllocation);
-	}
-
 	void Renderer::CreateUniformBuffers()
 	{
 		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
@@ -1059,65 +629,12 @@ namespace Otter::Systems
 		}
 	}
 
-	void Renderer::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-
-		VkBufferCopy copyRegion{};
-		copyRegion.srcOffset = 0; // Optional
-		copyRegion.dstOffset = 0; // Optional
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-		EndSingleTimeCommands(commandBuffer);
-	}
-
-	VkCommandBuffer Renderer::BeginSingleTimeCommands()
-	{
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
-
-		VkCommandBuffer commandBuffer;
-		VkResult result = vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer);
-		check_vk_result(result);
-
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		check_vk_result(result);
-
-		return commandBuffer;
-	}
-
-	void Renderer::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
-	{
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		VkResult result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-		check_vk_result(result);
-		result = vkQueueWaitIdle(graphicsQueue);
-		check_vk_result(result);
-
-		vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
-	}
-
 	void Renderer::CreateDescriptorPool()
 	{
-		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		// Textures are in the device's texture table, only the uniform buffers are per window.
+		std::array<VkDescriptorPoolSize, 1> poolSizes{};
 		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
 		VkDescriptorPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -1158,7 +675,7 @@ namespace Otter::Systems
 
 	void Renderer::CreateDescriptorSets()
 	{
-		std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+		std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, device->GetDescriptorSetLayout());
 		VkDescriptorSetAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		allocInfo.descriptorPool = descriptorPool;
@@ -1176,40 +693,25 @@ namespace Otter::Systems
 			bufferInfo.offset = 0;
 			bufferInfo.range = sizeof(UniformBufferObject);
 
-			VkDescriptorImageInfo imageInfo{};
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = textureImageView;
-			imageInfo.sampler = textureSampler;
-
-			std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-			descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[0].dstSet = descriptorSets[i];
-			descriptorWrites[0].dstBinding = 0;
-			descriptorWrites[0].dstArrayElement = 0;
-			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrites[0].descriptorCount = 1;
-			descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-			descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrites[1].dstSet = descriptorSets[i];
-			descriptorWrites[1].dstBinding = 1;
-			descriptorWrites[1].dstArrayElement = 0;
-			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			descriptorWrites[1].descriptorCount = 1;
-			descriptorWrites[1].pImageInfo = &imageInfo;
-
-			vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+			VkWriteDescriptorSet descriptorWrite{};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = descriptorSets[i];
+			descriptorWrite.dstBinding = 0;
+			descriptorWrite.dstArrayElement = 0;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pBufferInfo = &bufferInfo;
+
+			vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrite, 0, nullptr);
 		}
 	}
 
 	void Renderer::CreateCommandPool()
 	{
-		QueueFamilyIndices queueFamilyIndices = FindQueueFamilies(physicalDevice);
-
 		VkCommandPoolCreateInfo poolInfo{};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+		poolInfo.queueFamilyIndex = device->GetQueueFamilies().graphicsFamily.value();
 
 		VkResult result = vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &commandPool);
 		check_vk_result(result);
@@ -1231,9 +733,9 @@ namespace Otter::Systems
 
 	void Renderer::CreateDepthResources()
 	{
-		VkFormat depthFormat = FindDepthFormat();
+		VkFormat depthFormat = device->FindDepthFormat();
 		
-		CreateImage(
+		device->CreateImage(
 			{ swapChainExtent.width, swapChainExtent.height }, 
 			depthFormat, 
 			VK_IMAGE_TILING_OPTIMAL,
@@ -1241,232 +743,12 @@ namespace Otter::Systems
 			depthImage,
 			depthImageMemory
 		);
-		depthImageView = CreateImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
-	}
-
-	VkFormat Renderer::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
-	{
-		for (VkFormat format : candidates)
-		{
-			VkFormatProperties props;
-			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
-
-			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
-				return format;
-			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
-				return format;
-		}
-
-		LOG_F(ERROR, "failed to find supported format!");
-		abort();
-	}
-
-	VkFormat Renderer::FindDepthFormat()
-	{
-		return FindSupportedFormat(
-			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
-			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
-		);
-	}
-
-	void Renderer::CreateTextureImage()
-	{
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load("Assets/Textures/floral_shoppe.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-		if (!pixels)
-		{
-			LOG_F(ERROR, "Failed to load texture image");
-			abort();
-		}
-
-		// Move data to staging buffer
-		VkBuffer stagingBuffer = VK_NULL_HANDLE;
-		VmaAllocation stagingBufferAllocation = VK_NULL_HANDLE;
-		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-		bufferInfo.size = imageSize;
-		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-		VmaAllocationCreateInfo allocCreateInfo = {};
-		allocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-		allocCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
-		VmaAllocationInfo stagingAllocInfo = {};
-		VkResult result = vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, &stagingBuffer, &stagingBufferAllocation, &stagingAllocInfo);
-		check_vk_result(result);
-
-		memcpy(stagingAllocInfo.pMappedData, pixels, (size_t)bufferInfo.size);
-		stbi_image_free(pixels);
-
-		// Then, to a vulkan image
-		CreateImage(
-			{ texWidth, texHeight }, 
-			VK_FORMAT_R8G8B8A8_SRGB, 
-			VK_IMAGE_TILING_OPTIMAL, 
-			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			textureImage,
-			textureImageMemory
-		);
-
-		// Copy staging buffer to texture image
-		TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		CopyBufferToImage(stagingBuffer, textureImage, {texWidth, texHeight});
-
-		// Make the image accessible to shaders
-		TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		vmaDestroyBuffer(allocator, stagingBuffer, stagingBufferAllocation);
-
-		textureImageView = CreateImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
-
-	}
-
-	void Renderer::CreateImage(Vec2D size, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkImage& image, VmaAllocation& imageMemory)
-	{
-		VkImageCreateInfo imageInfo{};
-		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.extent.width = static_cast<uint32_t>(size.x);
-		imageInfo.extent.height = static_cast<uint32_t>(size.y);
-		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
-		imageInfo.arrayLayers = 1;
-		imageInfo.format = format;
-		imageInfo.tiling = tiling;
-		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		imageInfo.usage = usage;
-		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-
-		VmaAllocationCreateInfo imageAllocCreateInfo = {};
-		imageAllocCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
-		VmaAllocationInfo imageAllocInfo = {};
-		VkResult result = vmaCreateImage(allocator, &imageInfo, &imageAllocCreateInfo, &image, &imageMemory, &imageAllocInfo);
-		check_vk_result(result);
-	}
-
-	void Renderer::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-
-		// https://vulkan-tutorial.com/Texture_mapping/Images#page_Transition-barrier-masks
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		} 
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		{
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else
-		{
-			LOG_F(ERROR, "Unsupported layout transition!");
-			abort();
-		}
-
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage, destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
-
-		EndSingleTimeCommands(commandBuffer);
-	}
-
-	void Renderer::CopyBufferToImage(VkBuffer buffer, VkImage image, Vec2D size)
-	{
-    	VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-
-		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-
-		region.imageOffset = {0, 0, 0};
-		region.imageExtent =
-		{
-			static_cast<uint32_t>(size.x),
-			static_cast<uint32_t>(size.y),
-			1
-		};	
-
-		vkCmdCopyBufferToImage(
-			commandBuffer,
-			buffer,
-			image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&region
-		);
-
-
-    	EndSingleTimeCommands(commandBuffer);
-	}
-
-	void Renderer::CreateTextureSampler()
-	{
-		// More info here: https://vulkan-tutorial.com/Texture_mapping/Image_view_and_sampler#page_Samplers
-
-		VkSamplerCreateInfo samplerInfo{};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-
-		// TODO: pull this out and make this static data.
-		VkPhysicalDeviceProperties properties{};
-		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
-		samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
-		samplerInfo.compareEnable = VK_FALSE;
-		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;
-		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
-
-		VkResult result = vkCreateSampler(logicalDevice, &samplerInfo, nullptr, &textureSampler);
-		check_vk_result(result);
+		depthImageView = device->CreateImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
 
-	void Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	void Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, RenderSnapshot& snapshot)
 	{
+		OTTER_PROFILE_SCOPE("Renderer::RecordCommandBuffer");
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.flags = 0; // Optional
@@ -1474,6 +756,7 @@ namespace Otter::Systems
 
 		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
 		check_vk_result(result);
+		gpuProfiler.BeginFrame(commandBuffer, currentFrame);
 
 		std::array<VkClearValue, 2> clearValues{};
 		clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
@@ -1489,19 +772,105 @@ namespace Otter::Systems
 		renderPassInfo.pClearValues = clearValues.data();
 
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		gpuProfiler.BeginPass(commandBuffer, "Scene");
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 
-		VkBuffer vertexBuffers[] = {vertexBuffer};
-		VkDeviceSize offsets[] = {0};
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float) swapChainExtent.width;
+		viewport.height = (float) swapChainExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-		if(imGuiAllowed)
-			ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+		VkRect2D scissor{};
+		scissor.offset = {0, 0};
+		scissor.extent = swapChainExtent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkPipelineLayout pipelineLayout = device->GetPipelineLayout();
+		std::array<VkDescriptorSet, 2> sets = { descriptorSets[currentFrame], device->GetTextureTable() };
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+
+		// Meshes share the geometry arena's buffers, so buffers are only rebound when a draw lands in another page or index type.
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+		uint64_t triangles = 0;
+		for (const auto& draw : snapshot.draws)
+		{
+			const MeshDraw& mesh = draw.mesh;
+			if (mesh.vertexBuffer != boundVertexBuffer)
+			{
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &mesh.vertexBuffer, &offset);
+				boundVertexBuffer = mesh.vertexBuffer;
+			}
+			if (mesh.indexBuffer != boundIndexBuffer || mesh.indexType != boundIndexType)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer, 0, mesh.indexType);
+				boundIndexBuffer = mesh.indexBuffer;
+				boundIndexType = mesh.indexType;
+			}
+
+			ObjectPushConstants pushConstants{ draw.model, draw.textureIndex };
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants), &pushConstants);
+			vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset, 0);
+			triangles += mesh.indexCount / 3;
+		}
+		gpuProfiler.EndPass(commandBuffer);
+
+		uint64_t drawCalls = snapshot.draws.size();
+		if(imGuiAllowed && snapshot.imGui.drawData.Valid)
+		{
+			gpuProfiler.BeginPass(commandBuffer, "ImGui");
+			ImGui_ImplVulkan_RenderDrawData(&snapshot.imGui.drawData, commandBuffer);
+			gpuProfiler.EndPass(commandBuffer);
+
+			for (int i = 0; i < snapshot.imGui.drawData.CmdListsCount; i++)
+				for (const ImDrawCmd& command : snapshot.imGui.drawData.CmdLists[i]->CmdBuffer)
+				{
+					drawCalls += command.UserCallback == nullptr ? 1 : 0;
+					triangles += command.ElemCount / 3;
+				}
+		}
+		drawCallCount += drawCalls;
+		triangleCount += triangles;
 
         vkCmdEndRenderPass(commandBuffer);
+
+		// The render pass left the image in TRANSFER_SRC_OPTIMAL, wait for its writes and copy it out.
+		if (headless && !readbacks[currentFrame].path.empty())
+		{
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = swapChainImages[imageIndex];
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkBufferImageCopy region{};
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+			vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbacks[currentFrame].buffer, 1, &region);
+
+			VkBufferMemoryBarrier hostBarrier{};
+			hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			hostBarrier.buffer = readbacks[currentFrame].buffer;
+			hostBarrier.size = VK_WHOLE_SIZE;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+		}
+
         result = vkEndCommandBuffer(commandBuffer);
 		check_vk_result(result);
 	}
@@ -1531,42 +900,109 @@ namespace Otter::Systems
 		}
 	}
 
-	void Renderer::DrawFrame()
+	bool Renderer::DrawFrame(RenderSnapshot& snapshot)
 	{
-    	vkWaitForFences(logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+		/*
+			On the main thread all windows share one loop, so we never block there: one window on a FIFO swap chain
+			(or a slow monitor) would hold back every other window. If the GPU or the swap chain isn't ready, the frame is skipped
+			and the next tick brings a newer snapshot. A render thread only blocks itself, so it can wait.
+		*/
+		OTTER_PROFILE_SCOPE("Renderer::DrawFrame");
+		uint64_t timeout = renderThreadEnabled ? UINT64_MAX : 0;
 
-		uint32_t imageIndex;
-    	VkResult result = vkAcquireNextImageKHR(logicalDevice, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+		VkResult result;
 		{
-			RecreateSwapChain();
-			return;
+			OTTER_PROFILE_SCOPE("Renderer::WaitForFence");
+			result = vkWaitForFences(logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, timeout);
 		}
-		else if (result != VK_SUCCESS)
-			check_vk_result(result);
-		
+		if (result == VK_TIMEOUT)
+		{
+			skippedFrameCount++;
+			return false;
+		}
+		check_vk_result(result);
+
+		uint32_t imageIndex = currentFrame;
+		if (headless)
+		{
+			// The fence also covered the copy of a capture recorded in this frame slot, and each slot has its own image.
+			WriteCapture(readbacks[currentFrame]);
+
+			std::lock_guard<std::mutex> lock(captureMutex);
+			readbacks[currentFrame].path = std::move(requestedCapture);
+			requestedCapture.clear();
+		}
+		else
+		{
+			{
+				OTTER_PROFILE_SCOPE("Renderer::AcquireImage");
+				result = vkAcquireNextImageKHR(logicalDevice, swapChain, timeout, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+			}
+			if (result == VK_NOT_READY || result == VK_TIMEOUT)
+			{
+				skippedFrameCount++;
+				return false;
+			}
+			else if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+			{
+				RecreateSwapChain();
+				return false;
+			}
+			else if (result != VK_SUCCESS)
+				check_vk_result(result);
+		}
+
+
 		vkResetFences(logicalDevice, 1, &inFlightFences[currentFrame]);
 		vkResetCommandBuffer(commandBuffers[currentFrame], 0);
-		RecordCommandBuffer(commandBuffers[currentFrame], imageIndex);
-		UpdateUniformBuffer(currentFrame);
+		RecordCommandBuffer(commandBuffers[currentFrame], imageIndex, snapshot);
+		UpdateUniformBuffer(currentFrame, snapshot);
+
+		// Meshes and textures in this frame may have been uploaded just now, on another queue. The GPU waits for that, we don't.
+		uint64_t uploadValue = device->FlushUploads();
+
+		VkSemaphore waitSemaphores[] = {device->GetUploadSemaphore(), imageAvailableSemaphores[currentFrame]};
+		VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+		uint64_t waitValues[] = {uploadValue, 0};	// Binary semaphores ignore theirs.
+		uint32_t waitCount = headless ? 1 : 2;	// Offscreen images are ours, nothing to wait for or present.
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = waitCount;
+		timelineInfo.pWaitSemaphoreValues = waitValues;
 
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-		VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-		VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waitCount;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
 
-		VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		// The device's frame timeline tells it when assets unloaded meanwhile are no longer drawn. Presenting waits on the first one.
+		VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame], device->GetFrameSemaphore()};
+		uint64_t signalValues[] = {0, 0};
+		uint32_t signalOffset = headless ? 1 : 0;
+		timelineInfo.signalSemaphoreValueCount = 2 - signalOffset;
+		timelineInfo.pSignalSemaphoreValues = signalValues + signalOffset;
+		submitInfo.signalSemaphoreCount = 2 - signalOffset;
+		submitInfo.pSignalSemaphores = signalSemaphores + signalOffset;
 
-		result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]);
+		{
+			OTTER_PROFILE_SCOPE("Renderer::Submit");
+			std::lock_guard<std::mutex> lock(device->GetQueueMutex());
+			signalValues[1] = device->NextFrameValue();	// Taken under the queue lock, so values reach the queue in order.
+			result = vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
+		}
 		check_vk_result(result);
+		renderedFrameCount++;
+
+		if (headless)
+		{
+			currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+			return true;
+		}
 
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1579,35 +1015,52 @@ namespace Otter::Systems
 		presentInfo.pImageIndices = &imageIndex;
 		presentInfo.pResults = nullptr; // Optional
 
-		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+		{
+			OTTER_PROFILE_SCOPE("Renderer::Present");
+			std::lock_guard<std::mutex> lock(device->GetQueueMutex());
+			result = vkQueuePresentKHR(device->GetPresentQueue(), &presentInfo);
+		}
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
 		{
 			RecreateSwapChain();
-			return;
+			return true;
 		}
 		else if (result != VK_SUCCESS)
 			check_vk_result(result);
 
 		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		return true;
 	}
 
-	void Renderer::UpdateUniformBuffer(uint32_t currentImage)
+	RenderStats Renderer::GetRenderStats() const
 	{
-		/*
-			Using a UBO this way is not the most efficient way to pass frequently changing values to the shader.
-			A more efficient way to pass a small buffer of data to shaders are push constants. We may look at these in a future chapter.
-		*/
-		quad.model = glm::rotate(quad.model, deltaTime*glm::radians(90.f), glm::vec3(0.0f, 0.0f, 1.0f));
+		RenderStats stats;
+		stats.renderedFrames = renderedFrameCount;
+		stats.skippedFrames = skippedFrameCount;
+		stats.drawCalls = drawCallCount;
+		stats.triangles = triangleCount;
+		return stats;
+	}
+
+	void Renderer::UpdateUniformBuffer(uint32_t currentImage, const RenderSnapshot& snapshot)
+	{
+		OTTER_PROFILE_SCOPE("Renderer::UpdateUniformBuffer");
+		// Per frame data only, per draw data (the model matrix) goes through push constants.
+		UniformBufferObject ubo{};
+		ubo.view = snapshot.camera.view;
+		ubo.proj = glm::perspective(glm::radians(snapshot.camera.fieldOfView), swapChainExtent.width / (float) swapChainExtent.height, snapshot.camera.nearPlane, snapshot.camera.farPlane);
+		ubo.proj[1][1] *= -1;
 
 		void* data;
 		vmaMapMemory(allocator, uniformBufferAllocations[currentImage], &data);
-		memcpy(data, &quad, sizeof(quad));
+		memcpy(data, &ubo, sizeof(ubo));
 		vmaUnmapMemory(allocator, uniformBufferAllocations[currentImage]);
 	}
 
 	void Renderer::SetupImGui()
 	{
 		IMGUI_CHECKVERSION();
+		AllocationTracker::InstallImGuiAllocator();
 		ImGui::CreateContext();
 		ImGuiIO& io = ImGui::GetIO(); (void)io;
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
@@ -1628,11 +1081,12 @@ namespace Otter::Systems
 		// Setup Platform/Renderer backends
 		ImGui_ImplSDL2_InitForVulkan(handle);
 		ImGui_ImplVulkan_InitInfo init_info = {};
-		init_info.Instance = vulkanInstance;
-		init_info.PhysicalDevice = physicalDevice;
+		init_info.Instance = device->GetInstance();
+		init_info.PhysicalDevice = device->GetPhysicalDevice();
 		init_info.Device = logicalDevice;
-		init_info.Queue = graphicsQueue;
+		init_info.Queue = device->GetGraphicsQueue();
 		init_info.DescriptorPool = imguiDescriptorPool;
+		init_info.PipelineCache = device->GetPipelineCache();
 		init_info.Subpass = 0;
 		init_info.MinImageCount = minImageCount;
 		init_info.ImageCount = imageCount;
@@ -1657,11 +1111,13 @@ namespace Otter::Systems
         end_info.pCommandBuffers = &commandBuffers[currentFrame];
         err = vkEndCommandBuffer(commandBuffers[currentFrame]);
         check_vk_result(err);
-        err = vkQueueSubmit(graphicsQueue, 1, &end_info, VK_NULL_HANDLE);
+        {
+            std::lock_guard<std::mutex> lock(device->GetQueueMutex());
+            err = vkQueueSubmit(device->GetGraphicsQueue(), 1, &end_info, VK_NULL_HANDLE);
+        }
         check_vk_result(err);
 
-        err = vkDeviceWaitIdle(logicalDevice);
-        check_vk_result(err);
+        device->WaitIdle();
         ImGui_ImplVulkan_DestroyFontUploadObjects();
 	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Otter/Systems/TemplateSystem.hpp"
+#include "Otter/Core/Profiler.hpp"
 #include "loguru.hpp"
 
 namespace Otter::Systems
@@ -13,5 +14,6 @@ namespace Otter::Systems
 
 	void TemplateSystem::OnTick(float deltaTime)
 	{
+		OTTER_PROFILE_SCOPE("TemplateSystem::OnTick");
 	}
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "Otter/Systems/TransformSystem.hpp"
+#include "Otter/Components/Transform.hpp"
+#include "Otter/Core/Coordinator.hpp"
+#include "Otter/Core/Profiler.hpp"
+
+namespace Otter::Systems
+{
+	void TransformSystem::OnStart()
+	{
+		updatedTick.assign(MAX_ENTITIES, 0);
+	}
+
+	void TransformSystem::OnStop()
+	{
+	}
+
+	void TransformSystem::OnTick(float deltaTime)
+	{
+		OTTER_PROFILE_SCOPE("TransformSystem::OnTick");
+		if (updatedTick.size() != MAX_ENTITIES)
+			updatedTick.assign(MAX_ENTITIES, 0);
+
+		tick++;
+		for (auto entity : entities)
+			UpdateWorld(entity);
+	}
+
+	const glm::mat4& TransformSystem::UpdateWorld(Entity entity)
+	{
+		Components::Transform& transform = coordinator->GetComponent<Components::Transform>(entity);
+		if (updatedTick[entity] == tick)
+			return transform.world;
+
+		// Marked before visiting the parent, so a cycle in the hierarchy ends up using a stale matrix instead of recursing forever.
+		updatedTick[entity] = tick;
+
+		Entity parent = transform.parent;
+		if (parent < MAX_ENTITIES && parent != entity && coordinator->HasComponent<Components::Transform>(parent))
+			transform.world = UpdateWorld(parent) * transform.GetLocalMatrix();
+		else
+			transform.world = transform.GetLocalMatrix();
+
+		return transform.world;
+	}
+}
@@ -0,0 +1,121 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "Otter/Utilities/AtomicFile.hpp"
+#include "loguru.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace Otter
+{
+#ifdef _WIN32
+	using FileHandle = HANDLE;
+#else
+	using FileHandle = int;
+#endif
+
+	// Unique per process and thread, in the same directory so the rename stays on one file system.
+	static std::filesystem::path GetTemporaryPath(const std::filesystem::path& path)
+	{
+	#ifdef _WIN32
+		unsigned long processId = GetCurrentProcessId();
+	#else
+		unsigned long processId = static_cast<unsigned long>(getpid());
+	#endif
+		char suffix[64];
+		std::snprintf(suffix, sizeof(suffix), ".%lu-%zx.tmp", processId, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += suffix;
+		return temporaryPath;
+	}
+
+	static bool WriteAll(FileHandle file, const void* data, size_t size)
+	{
+		const char* bytes = static_cast<const char*>(data);
+		while (size > 0)
+		{
+		#ifdef _WIN32
+			DWORD written = 0;
+			if (!WriteFile(file, bytes, static_cast<DWORD>(std::min<size_t>(size, 1u << 30)), &written, nullptr))
+				return false;
+		#else
+			ssize_t written = write(file, bytes, size);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return false;
+		#endif
+			bytes += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	static bool WriteAndSync(const std::filesystem::path& path, const std::vector<FileChunk>& chunks)
+	{
+	#ifdef _WIN32
+		FileHandle file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+	#else
+		FileHandle file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (file < 0)
+			return false;
+	#endif
+
+		const char padding[64] = {};
+		uint64_t position = 0;
+		bool written = true;
+		for (const FileChunk& chunk : chunks)
+		{
+			while (written && position < chunk.offset)
+			{
+				uint64_t gap = std::min<uint64_t>(chunk.offset - position, sizeof(padding));
+				written = WriteAll(file, padding, static_cast<size_t>(gap));
+				position += gap;
+			}
+			written = written && WriteAll(file, chunk.data, chunk.size);
+			position += chunk.size;
+		}
+
+		// On disk before the rename, otherwise a crash can leave path naming a file whose data never made it there.
+	#ifdef _WIN32
+		written = written && FlushFileBuffers(file);
+		return CloseHandle(file) && written;
+	#else
+		written = written && fsync(file) == 0;
+		return close(file) == 0 && written;
+	#endif
+	}
+
+	bool WriteFileAtomically(const std::filesystem::path& path, const std::vector<FileChunk>& chunks)
+	{
+		std::filesystem::path temporaryPath = GetTemporaryPath(path);
+		std::error_code error;
+		if (!WriteAndSync(temporaryPath, chunks))
+		{
+			LOG_F(WARNING, "Failed to write %s", temporaryPath.string().c_str());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			LOG_F(WARNING, "Failed to move %s into place: %s", path.string().c_str(), error.message().c_str());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+}
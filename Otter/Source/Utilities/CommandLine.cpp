@@ -0,0 +1,65 @@
+#include "Otter/Utilities/CommandLine.hpp"
+#include <cstdlib>
+
+namespace Otter
+{
+	static bool IsOption(const std::string& argument)
+	{
+		return argument.size() > 2 && argument.compare(0, 2, "--") == 0;
+	}
+
+	CommandLine::CommandLine(int argc, char* argv[])
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string argument = argv[i];
+			if (!IsOption(argument))
+			{
+				positional.push_back(argument);
+				continue;
+			}
+
+			argument = argument.substr(2);
+			size_t separator = argument.find('=');
+			if (separator != std::string::npos)
+				options[argument.substr(0, separator)] = argument.substr(separator + 1);
+			else if (i + 1 < argc && !IsOption(argv[i + 1]))
+				options[argument] = argv[++i];
+			else
+				options[argument] = "";
+		}
+	}
+
+	bool CommandLine::Has(const std::string& name) const
+	{
+		return options.find(name) != options.end();
+	}
+
+	std::string CommandLine::GetString(const std::string& name, const std::string& fallback) const
+	{
+		auto it = options.find(name);
+		return it != options.end() ? it->second : fallback;
+	}
+
+	int CommandLine::GetInt(const std::string& name, int fallback) const
+	{
+		auto it = options.find(name);
+		if (it == options.end() || it->second.empty())
+			return fallback;
+
+		char* end = nullptr;
+		long value = std::strtol(it->second.c_str(), &end, 10);
+		return *end == '\0' ? static_cast<int>(value) : fallback;
+	}
+
+	float CommandLine::GetFloat(const std::string& name, float fallback) const
+	{
+		auto it = options.find(name);
+		if (it == options.end() || it->second.empty())
+			return fallback;
+
+		char* end = nullptr;
+		float value = std::strtof(it->second.c_str(), &end);
+		return *end == '\0' ? value : fallback;
+	}
+}
@@ -0,0 +1,112 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Otter/Utilities/MappedFile.hpp"
+#include <utility>
+
+namespace Otter
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			std::swap(data, other.data);
+			std::swap(size, other.size);
+		#ifdef _WIN32
+			std::swap(mapping, other.mapping);
+		#endif
+		}
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+	#ifdef _WIN32
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		// The mapping keeps the file open, the file handle isn't needed past this.
+		HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (fileMapping == nullptr)
+			return false;
+
+		void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			CloseHandle(fileMapping);
+			return false;
+		}
+
+		mapping = fileMapping;
+		data = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+	#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat status{};
+		if (fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);	// The mapping holds its own reference.
+		if (view == MAP_FAILED)
+			return false;
+
+		madvise(view, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+		data = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(status.st_size);
+	#endif
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data == nullptr)
+			return;
+
+	#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+		mapping = nullptr;
+	#else
+		munmap(const_cast<uint8_t*>(data), size);
+	#endif
+		data = nullptr;
+		size = 0;
+	}
+}
@@ -196,6 +196,11 @@ namespace Otter
 		if(!result)
 			return VK_NULL_HANDLE;
 
+		return CreateShaderModule(shaderCode, path, logicalDevice);
+	}
+
+	VkShaderModule ShaderUtilities::CreateShaderModule(const std::vector<uint32_t>& shaderCode, std::string path, VkDevice logicalDevice)
+	{
 		VkShaderModuleCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		createInfo.codeSize = shaderCode.size() * sizeof(uint32_t);
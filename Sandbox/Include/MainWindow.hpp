@@ -1,12 +1,19 @@
 #pragma once
 #include "Otter/Core/Window.hpp"
+#include "StressScene.hpp"
 
 namespace Sandbox {
 	class MainWindow : public Otter::Window
 	{
 	public:
-		MainWindow(glm::vec2 size, std::string title, bool imGuiAllowed);
+		MainWindow(glm::vec2 size, std::string title, bool imGuiAllowed, bool headless = false);
+		virtual void OnTick(float deltaTime);
 		virtual void OnDrawImGui();
+
+		void StartStressScene(const StressSceneSettings& settings);
+
+	private:
+		StressScene stressScene;
 	};
 
-}
\ No newline at end of file
+}
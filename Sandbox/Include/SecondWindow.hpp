@@ -5,7 +5,7 @@ namespace Sandbox {
 	class SecondWindow : public Otter::Window
 	{
 	public:
-		SecondWindow(glm::vec2 size, std::string title, bool imGuiAllowed) : Otter::Window(size, title, imGuiAllowed) {}
+		SecondWindow(glm::vec2 size, std::string title, bool imGuiAllowed, bool headless = false) : Otter::Window(size, title, imGuiAllowed, headless) {}
 	};
 
 }
\ No newline at end of file
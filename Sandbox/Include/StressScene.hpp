@@ -0,0 +1,90 @@
+#pragma once
+#include "Otter/Core/Coordinator.hpp"
+#include "Otter/Core/System.hpp"
+#include "Otter/Utilities/CommandLine.hpp"
+#include "glm/vec3.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Sandbox {
+	enum class StressMovement
+	{
+		None,
+		Orbit,	// Circles around its spawn point.
+		Wave,	// Bobs up and down, phase shifted over the grid.
+		Wander	// Random walk, kept inside the scene bounds.
+	};
+
+	/*
+		Load for measuring ECS, culling, batching and streaming changes, configured from the command line:
+		--stress <entities> [--stress-meshes <n>] [--stress-textures <n>] [--stress-movement none|orbit|wave|wander]
+		[--stress-depth <entities per hierarchy chain>] [--stress-churn <chains respawned per second>] [--stress-seed <n>]
+	*/
+	struct StressSceneSettings
+	{
+		int entityCount = 0;		// 0 disables the stress scene.
+		int meshVariety = 1;		// How many different meshes/textures are handed out, round robin. Clamped to what's in the assets.
+		int textureVariety = 1;
+		StressMovement movement = StressMovement::Orbit;
+		int hierarchyDepth = 1;		// 1 = every entity is a root.
+		float churnRate = 0.0f;
+		uint32_t seed = 1;
+
+		static StressSceneSettings FromCommandLine(const Otter::CommandLine& commandLine);
+	};
+
+	// Per root entity, children follow through their Transform's parent.
+	struct StressMotion
+	{
+		StressMovement movement = StressMovement::None;
+		glm::vec3 origin = glm::vec3(0.0f);
+		float radius = 0.0f;	// How far it may move from its origin.
+		float phase = 0.0f;
+		float speed = 1.0f;
+	};
+
+	class StressMotionSystem : public Otter::System
+	{
+	public:
+		virtual void OnStart() {}
+		virtual void OnStop() {}
+		virtual void OnTick(float deltaTime);
+		virtual const char* GetName() const { return "StressMotionSystem"; }
+
+	private:
+		float time = 0.0f;
+	};
+
+	// Spawns the entities, and despawns/respawns whole chains to simulate churn.
+	class StressScene
+	{
+	public:
+		void Start(Otter::Coordinator& coordinator, const StressSceneSettings& settings);
+		void OnTick(float deltaTime);
+		inline bool IsRunning() const { return coordinator != nullptr; }
+		inline int GetEntityCount() const { return entityCount; }
+		inline uint64_t GetRespawnedChainCount() const { return respawnedChains; }
+
+	private:
+		struct Chain
+		{
+			int slot = 0;		// Place in the grid.
+			int length = 0;
+			std::vector<Otter::Entity> entities;	// Root first.
+		};
+
+		Otter::Coordinator* coordinator = nullptr;
+		StressSceneSettings settings;
+		std::mt19937 random;
+		std::vector<Chain> chains;
+		float churnBudget = 0.0f;
+		int gridSize = 1;
+		int entityCount = 0;
+		uint64_t spawnedEntities = 0;	// Drives the round robin over meshes and textures.
+		uint64_t respawnedChains = 0;
+
+		void SpawnChain(Chain& chain);
+		void DespawnChain(Chain& chain);
+	};
+}
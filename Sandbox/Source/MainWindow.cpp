@@ -1,20 +1,51 @@
 #include "MainWindow.hpp"
 #include "imgui.h"
+#include "Otter/Core/AllocationTracker.hpp"
+#include "Otter/Core/FrameArena.hpp"
+#include "Otter/Core/Profiler.hpp"
 #include "Otter/Components/MeshRenderer.hpp"
+#include "Otter/Components/Transform.hpp"
 
 namespace Sandbox
 {
-	MainWindow::MainWindow(glm::vec2 size, std::string title, bool imGuiAllowed) : Otter::Window(size, title, imGuiAllowed)
+	MainWindow::MainWindow(glm::vec2 size, std::string title, bool imGuiAllowed, bool headless) : Otter::Window(size, title, imGuiAllowed, headless)
 	{
+		coordinator.RegisterComponent<StressMotion>();
+		{
+			Otter::Signature signature;
+			signature.set(coordinator.GetComponentType<Otter::Components::Transform>());
+			signature.set(coordinator.GetComponentType<StressMotion>());
+			RegisterSystem<StressMotionSystem>(signature);
+		}
+
 		Otter::Components::MeshRenderer mr = { "Assets/Meshes/viking_room.obj", "Assets/Textures/viking_room.png" };
 		Otter::Entity entity = coordinator.CreateEntity();
-		coordinator.AddComponent(entity, mr);
+		coordinator.AddComponent(entity, std::move(mr));
+	}
+
+	void MainWindow::StartStressScene(const StressSceneSettings& settings)
+	{
+		stressScene.Start(coordinator, settings);
+	}
+
+	void MainWindow::OnTick(float deltaTime)
+	{
+		stressScene.OnTick(deltaTime);
+		Otter::Window::OnTick(deltaTime);
 	}
 
 	void MainWindow::OnDrawImGui()
 	{
 		ImGui::Begin("Hello, world!");
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-		ImGui::End();	
+		if (stressScene.IsRunning())
+			ImGui::Text("Stress scene: %d entities, %llu chains respawned", stressScene.GetEntityCount(), (unsigned long long)stressScene.GetRespawnedChainCount());
+		ImGui::End();
+
+		Otter::Profiler::Get().DrawImGui();
+		GetGpuProfiler().DrawImGui();
+		Otter::AllocationTracker::Get().DrawImGui();
+		Otter::FrameArenas::Get().DrawImGui();
+		Otter::Rendering::AssetManager::Get().DrawImGui();
 	}
 }
\ No newline at end of file
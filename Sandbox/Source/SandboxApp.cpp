@@ -1,17 +1,25 @@
 #include "SandboxApp.hpp"
 #include "MainWindow.hpp"
 #include "SecondWindow.hpp"
+#include "Otter/Core/Profiler.hpp"
 
 namespace Sandbox {
 
 	SandboxApp::SandboxApp() : Application()
 	{
 		appName = "SandboxApp";
+		SetTargetFrameRate(144.0f);
+		SetRenderThreadEnabled(true);
+		Otter::Profiler::Get().SetSpikeCapture(50.0f);
 	}
 
 	void SandboxApp::OnStart()
 	{
-		CreateWindow<Sandbox::MainWindow>({480, 640}, "Main Window");
+		auto mainWindow = CreateWindow<Sandbox::MainWindow>({480, 640}, "Main Window");
+
+		StressSceneSettings stressSettings = StressSceneSettings::FromCommandLine(GetCommandLine());
+		if (mainWindow && stressSettings.entityCount > 0)
+			mainWindow->StartStressScene(stressSettings);
 		CreateWindow<Sandbox::SecondWindow>({640, 480}, "Second Window");
 	}
 
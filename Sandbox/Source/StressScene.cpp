@@ -0,0 +1,204 @@
+#include "StressScene.hpp"
+#include "Otter/Components/MeshRenderer.hpp"
+#include "Otter/Components/Transform.hpp"
+#include "Otter/Core/Profiler.hpp"
+#include "loguru.hpp"
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Sandbox
+{
+	static const std::vector<std::string> STRESS_MESHES = {
+		"Assets/Meshes/viking_room.obj"
+	};
+	static const std::vector<std::string> STRESS_TEXTURES = {
+		"Assets/Textures/viking_room.png",
+		"Assets/Textures/floral_shoppe.jpg"
+	};
+	static const float SCENE_EXTENT = 3.0f;	// Entities are laid out on a square grid this wide around the origin, in view of the default camera.
+	static const float TWO_PI = 6.28318530718f;
+
+	static bool ParseMovement(const std::string& name, StressMovement& movement)
+	{
+		if (name == "none")
+			movement = StressMovement::None;
+		else if (name == "orbit")
+			movement = StressMovement::Orbit;
+		else if (name == "wave")
+			movement = StressMovement::Wave;
+		else if (name == "wander")
+			movement = StressMovement::Wander;
+		else
+			return false;
+		return true;
+	}
+
+	StressSceneSettings StressSceneSettings::FromCommandLine(const Otter::CommandLine& commandLine)
+	{
+		StressSceneSettings settings;
+		settings.entityCount = std::max(commandLine.GetInt("stress", 0), 0);
+		settings.meshVariety = std::clamp(commandLine.GetInt("stress-meshes", 1), 1, (int)STRESS_MESHES.size());
+		settings.textureVariety = std::clamp(commandLine.GetInt("stress-textures", 1), 1, (int)STRESS_TEXTURES.size());
+		settings.hierarchyDepth = std::max(commandLine.GetInt("stress-depth", 1), 1);
+		settings.churnRate = std::max(commandLine.GetFloat("stress-churn", 0.0f), 0.0f);
+		settings.seed = static_cast<uint32_t>(commandLine.GetInt("stress-seed", 1));
+
+		std::string movement = commandLine.GetString("stress-movement", "orbit");
+		if (!ParseMovement(movement, settings.movement))
+			LOG_F(WARNING, "Unknown stress movement '%s', expected none, orbit, wave or wander. Using orbit.", movement.c_str());
+
+		if (commandLine.GetInt("stress-meshes", 1) > settings.meshVariety || commandLine.GetInt("stress-textures", 1) > settings.textureVariety)
+			LOG_F(WARNING, "Only %zu meshes and %zu textures are available for the stress scene", STRESS_MESHES.size(), STRESS_TEXTURES.size());
+
+		return settings;
+	}
+
+	void StressMotionSystem::OnTick(float deltaTime)
+	{
+		OTTER_PROFILE_SCOPE("StressMotionSystem::OnTick");
+		time += deltaTime;
+
+		for (auto entity : entities)
+		{
+			const StressMotion& motion = coordinator->GetComponent<StressMotion>(entity);
+			Otter::Components::Transform& transform = coordinator->GetComponent<Otter::Components::Transform>(entity);
+			float t = time * motion.speed + motion.phase;
+
+			switch (motion.movement)
+			{
+				case StressMovement::None:
+					continue;
+				case StressMovement::Orbit:
+					transform.position = motion.origin + motion.radius * glm::vec3(std::cos(t), std::sin(t), 0.0f);
+					break;
+				case StressMovement::Wave:
+					transform.position = motion.origin + glm::vec3(0.0f, 0.0f, motion.radius * std::sin(t));
+					break;
+				case StressMovement::Wander:
+				{
+					// A heading that drifts smoothly but differently per entity, bounced back at the edge of its cell.
+					float heading = motion.phase + 2.0f * std::sin(0.5f * t + 3.0f * motion.phase);
+					transform.position += deltaTime * motion.speed * motion.radius * glm::vec3(std::cos(heading), std::sin(heading), 0.0f);
+					glm::vec3 offset = transform.position - motion.origin;
+					if (glm::length(offset) > motion.radius)
+						transform.position = motion.origin + glm::normalize(offset) * motion.radius;
+					break;
+				}
+			}
+
+			transform.rotation = glm::angleAxis(t, glm::vec3(0.0f, 0.0f, 1.0f));
+		}
+	}
+
+	void StressScene::Start(Otter::Coordinator& coordinator, const StressSceneSettings& settings)
+	{
+		this->coordinator = &coordinator;
+		this->settings = settings;
+		random.seed(settings.seed);
+
+		// The first entity ids are taken by the window itself, leave some room for those.
+		int maxEntities = static_cast<int>(Otter::MAX_ENTITIES) - 16;
+		if (this->settings.entityCount > maxEntities)
+		{
+			LOG_F(WARNING, "Stress scene asked for %d entities, clamping to %d (MAX_ENTITIES)", settings.entityCount, maxEntities);
+			this->settings.entityCount = maxEntities;
+		}
+
+		int depth = this->settings.hierarchyDepth;
+		int chainCount = (this->settings.entityCount + depth - 1) / depth;
+		gridSize = std::max(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(chainCount)))), 1);
+
+		chains.resize(chainCount);
+		for (int i = 0; i < chainCount; i++)
+		{
+			chains[i].slot = i;
+			chains[i].length = std::min(depth, this->settings.entityCount - i * depth);
+			SpawnChain(chains[i]);
+		}
+
+		LOG_F(INFO, "Started stress scene: %d entities in %d chains of depth %d, %d meshes, %d textures, %.1f chains respawned/s, seed %u",
+			entityCount, chainCount, depth, this->settings.meshVariety, this->settings.textureVariety, this->settings.churnRate, this->settings.seed);
+	}
+
+	void StressScene::OnTick(float deltaTime)
+	{
+		if (!IsRunning() || chains.empty() || settings.churnRate <= 0.0f)
+			return;
+
+		OTTER_PROFILE_SCOPE("StressScene::Churn");
+		churnBudget += settings.churnRate * deltaTime;
+		std::uniform_int_distribution<size_t> pick(0, chains.size() - 1);
+		while (churnBudget >= 1.0f)
+		{
+			Chain& chain = chains[pick(random)];
+			DespawnChain(chain);
+			SpawnChain(chain);
+			respawnedChains++;
+			churnBudget -= 1.0f;
+		}
+	}
+
+	void StressScene::SpawnChain(Chain& chain)
+	{
+		float cell = SCENE_EXTENT / gridSize;
+		glm::vec3 origin = glm::vec3(
+			(chain.slot % gridSize + 0.5f) * cell - SCENE_EXTENT * 0.5f,
+			(chain.slot / gridSize + 0.5f) * cell - SCENE_EXTENT * 0.5f,
+			0.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		Otter::Entity parent = Otter::INVALID_ENTITY;
+		for (int i = 0; i < chain.length; i++)
+		{
+			Otter::Entity entity = coordinator->CreateEntity();
+
+			Otter::Components::Transform transform;
+			if (i == 0)
+			{
+				transform.position = origin;
+				transform.scale = glm::vec3(cell * 0.4f);
+			}
+			else
+			{
+				// Each child sits off to the side of its parent and a bit smaller, so a chain winds up like a spiral.
+				transform.position = glm::vec3(0.6f, 0.0f, 0.3f);
+				transform.rotation = glm::angleAxis(TWO_PI / 12.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+				transform.scale = glm::vec3(0.7f);
+				transform.parent = parent;
+			}
+			coordinator->AddComponent(entity, transform);
+
+			Otter::Components::MeshRenderer meshRenderer = {
+				STRESS_MESHES[spawnedEntities % settings.meshVariety],
+				STRESS_TEXTURES[spawnedEntities % settings.textureVariety]
+			};
+			coordinator->AddComponent(entity, std::move(meshRenderer));
+
+			if (i == 0)
+			{
+				StressMotion motion;
+				motion.movement = settings.movement;
+				motion.origin = origin;
+				motion.radius = cell * 0.25f;
+				motion.phase = unit(random) * TWO_PI;
+				motion.speed = 0.5f + unit(random);
+				coordinator->AddComponent(entity, motion);
+			}
+
+			chain.entities.push_back(entity);
+			parent = entity;
+			spawnedEntities++;
+			entityCount++;
+		}
+	}
+
+	void StressScene::DespawnChain(Chain& chain)
+	{
+		for (auto entity : chain.entities)
+			coordinator->DestroyEntity(entity);
+
+		entityCount -= static_cast<int>(chain.entities.size());
+		chain.entities.clear();
+	}
+}
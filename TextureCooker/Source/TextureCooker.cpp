@@ -0,0 +1,174 @@
+#include "Otter/Rendering/Ktx2.hpp"
+#include "Otter/Rendering/TextureCache.hpp"
+#include "Otter/Utilities/CommandLine.hpp"
+#include "loguru.hpp"
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+/*
+	Usage: OtterTextureCooker [directory] [--format auto|bc1|bc3|bc5|rgba8] [--force]
+	Cooks every source image in directory (Otter/Assets/Textures by default) into a KTX2 file next to it, with the same name and a
+	full mip chain. The engine loads that instead of the source image whenever the GPU can sample its format.
+	auto picks BC5 for normal maps (named *_normal or *_n), BC3 for images with transparency and BC1 for everything else.
+	BC7 KTX2 files made by other tools (toktx, Compressonator) load as well, there is no BC7 encoder here.
+	Textures whose KTX2 is newer than their source are skipped, unless --force.
+*/
+namespace TextureCooker
+{
+	using namespace Otter;
+	using namespace Otter::Rendering;
+
+	static const std::vector<std::string> SOURCE_EXTENSIONS = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+
+	// Appends the blocks of one RGBA8 level to compressed. Blocks hanging over the edge of a small level repeat its last row and column.
+	static void Compress(const uint8_t* pixels, Vec2D size, VkFormat format, std::vector<uint8_t>& compressed)
+	{
+		if (!IsBlockCompressed(format))
+		{
+			compressed.insert(compressed.end(), pixels, pixels + GetImageBytes(format, size));
+			return;
+		}
+
+		uint8_t block[16 * 4];
+		uint8_t blockData[16];
+		for (int blockY = 0; blockY < size.y; blockY += 4)
+			for (int blockX = 0; blockX < size.x; blockX += 4)
+			{
+				for (int texel = 0; texel < 16; texel++)
+				{
+					int x = std::min(blockX + texel % 4, size.x - 1);
+					int y = std::min(blockY + texel / 4, size.y - 1);
+					const uint8_t* source = &pixels[(static_cast<size_t>(y) * size.x + x) * 4];
+					if (format == VK_FORMAT_BC5_UNORM_BLOCK)
+					{
+						block[texel * 2] = source[0];
+						block[texel * 2 + 1] = source[1];
+					}
+					else
+						std::copy(source, source + 4, &block[texel * 4]);
+				}
+
+				if (format == VK_FORMAT_BC5_UNORM_BLOCK)
+					stb_compress_bc5_block(blockData, block);
+				else
+					stb_compress_dxt_block(blockData, block, format == VK_FORMAT_BC3_SRGB_BLOCK ? 1 : 0, STB_DXT_HIGHQUAL);
+				compressed.insert(compressed.end(), blockData, blockData + GetTexelBlockBytes(format));
+			}
+	}
+
+	static bool ParseFormat(const std::string& name, VkFormat& format)
+	{
+		if (name == "bc1")
+			format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		else if (name == "bc3")
+			format = VK_FORMAT_BC3_SRGB_BLOCK;
+		else if (name == "bc5")
+			format = VK_FORMAT_BC5_UNORM_BLOCK;
+		else if (name == "rgba8")
+			format = VK_FORMAT_R8G8B8A8_SRGB;
+		else
+			return false;
+		return true;
+	}
+
+	static VkFormat ChooseFormat(const std::filesystem::path& path, const DecodedImage& image)
+	{
+		std::string name = path.stem().string();
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		auto endsWith = [&name](const std::string& suffix) { return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0; };
+		if (endsWith("_normal") || endsWith("_n"))
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+
+		for (size_t i = 3; i < image.pixels.size(); i += 4)
+			if (image.pixels[i] != 255)
+				return VK_FORMAT_BC3_SRGB_BLOCK;
+		return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	}
+
+	static bool Cook(const std::filesystem::path& source, const std::string& formatName)
+	{
+		DecodedImage image;
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(source.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+		{
+			LOG_F(ERROR, "Failed to load %s: %s", source.string().c_str(), stbi_failure_reason());
+			return false;
+		}
+		image.size = { width, height };
+		image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		if (formatName == "auto")
+			format = ChooseFormat(source, image);
+		else if (!ParseFormat(formatName, format))
+		{
+			LOG_F(ERROR, "Unknown format %s, expected auto, bc1, bc3, bc5 or rgba8", formatName.c_str());
+			return false;
+		}
+
+		// Same mip filter as the engine's texture cache. Normal maps (BC5) aren't color, they're filtered as they are.
+		TextureCache::GenerateMips(image, format != VK_FORMAT_BC5_UNORM_BLOCK);
+
+		DecodedImage cooked;
+		cooked.format = format;
+		cooked.size = image.size;
+		for (const MipLevel& level : image.levels)
+		{
+			cooked.levels.push_back({ cooked.pixels.size(), level.size });
+			Compress(image.pixels.data() + level.offset, level.size, format, cooked.pixels);
+		}
+
+		std::filesystem::path destination = source;
+		destination.replace_extension(Ktx2::EXTENSION);
+		if (!Ktx2::Store(destination, cooked))
+		{
+			LOG_F(ERROR, "Failed to write %s", destination.string().c_str());
+			return false;
+		}
+
+		LOG_F(INFO, "Cooked %s: %dx%d, %zu levels, %.1f KiB (%.1f KiB uncompressed, without mips)", destination.string().c_str(), width, height,
+			cooked.levels.size(), cooked.pixels.size() / 1024.0f, static_cast<size_t>(width) * height * 4 / 1024.0f);
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	loguru::init(argc, argv);
+	Otter::CommandLine commandLine(argc, argv);
+	std::filesystem::path directory = commandLine.GetPositional().empty() ? "Otter/Assets/Textures" : commandLine.GetPositional().front();
+	std::string format = commandLine.GetString("format", "auto");
+	bool force = commandLine.Has("force");
+
+	std::error_code error;
+	if (!std::filesystem::is_directory(directory, error))
+	{
+		LOG_F(ERROR, "%s is not a directory", directory.string().c_str());
+		return 1;
+	}
+
+	int failed = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (!entry.is_regular_file() || std::find(TextureCooker::SOURCE_EXTENSIONS.begin(), TextureCooker::SOURCE_EXTENSIONS.end(), extension) == TextureCooker::SOURCE_EXTENSIONS.end())
+			continue;
+
+		std::filesystem::path cooked = entry.path();
+		cooked.replace_extension(Otter::Rendering::Ktx2::EXTENSION);
+		if (!force && std::filesystem::exists(cooked, error) && std::filesystem::last_write_time(cooked, error) >= entry.last_write_time(error))
+			continue;
+
+		if (!TextureCooker::Cook(entry.path(), format))
+			failed++;
+	}
+
+	return failed == 0 ? 0 : 1;
+}